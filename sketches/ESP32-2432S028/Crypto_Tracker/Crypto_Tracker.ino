@@ -2,13 +2,21 @@
  * Crypto Tracker - ESP32-2432S028 (Cheap Yellow Display)
  *
  * Affiche les cours de cryptomonnaies avec graphique historique 7 jours.
- * Navigation tactile entre les differentes cryptos.
+ * Navigation tactile entre les differentes cryptos ; un appui sur le
+ * graphique alterne les vues 7 jours / 1 heure / 24 heures, ces deux
+ * dernieres calculees sur l'historique local (price_history.h).
+ * Les requetes HTTP tournent dans une tache de fond ; les graphiques sont
+ * gardes en cache (chart_cache.h), la navigation ne fait que redessiner.
  * API: CoinGecko (gratuite, sans cle)
+ * Mode ticker optionnel (PRICE_STREAMING 1) : les prix arrivent en continu
+ * par un WebSocket Binance miniTicker ; retour au polling CoinGecko s'il
+ * tombe. Desactive par defaut (stream.binance.com est bloque dans certains
+ * pays) ; la bibliotheque WebSockets n'est requise qu'avec ce mode.
  *
  * Board: ESP32-2432S028 (Cheap Yellow Display)
  * FQBN: esp32:esp32:esp32
  *
- * @dependencies TFT_eSPI, XPT2046_Touchscreen, ArduinoJson
+ * @dependencies TFT_eSPI, XPT2046_Touchscreen, ArduinoJson, WebSockets (PRICE_STREAMING)
  */
 
 #include <TFT_eSPI.h>
@@ -18,6 +26,9 @@
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include "credentials.h"
+#include "chart_cache.h"
+#include "chart_stream.h"
+#include "price_history.h"
 
 // Backlight
 #define TFT_BACKLIGHT 21
@@ -41,6 +52,9 @@ XPT2046_Touchscreen ts(TOUCH_CS, TOUCH_IRQ);
 
 TFT_eSPI tft = TFT_eSPI();
 
+#define CHART_POINTS 50
+#define CHART_SPAN_MS (7.0 * 24 * 3600 * 1000)   // market_chart days=7
+
 // Liste des cryptos a suivre
 struct Crypto {
   const char* id;       // ID CoinGecko
@@ -49,24 +63,102 @@ struct Crypto {
   uint16_t color;       // Couleur du graphique
   float price;
   float change24h;
-  float chartData[50];  // Historique pour le graphique
+  uint16_t chartData[CHART_POINTS];  // quantifie sur [chartMin, chartMax]
+  float chartMin, chartMax;
   int chartPoints;
+  ChartCacheEntry chart;
   bool dataValid;
 };
 
 #define NUM_CRYPTOS 6
 Crypto cryptos[NUM_CRYPTOS] = {
-  {"bitcoin",  "BTC", "Bitcoin",  TFT_ORANGE, 0, 0, {}, 0, false},
-  {"ethereum", "ETH", "Ethereum", TFT_CYAN,   0, 0, {}, 0, false},
-  {"solana",   "SOL", "Solana",   TFT_MAGENTA,0, 0, {}, 0, false},
-  {"cardano",  "ADA", "Cardano",  TFT_BLUE,   0, 0, {}, 0, false},
-  {"ripple",   "XRP", "Ripple",   TFT_DARKGREY, 0, 0, {}, 0, false},
-  {"dogecoin", "DOGE","Dogecoin", TFT_YELLOW, 0, 0, {}, 0, false}
+  {"bitcoin",  "BTC", "Bitcoin",  TFT_ORANGE, 0, 0, {}, 0, 0, 0, {0, false}, false},
+  {"ethereum", "ETH", "Ethereum", TFT_CYAN,   0, 0, {}, 0, 0, 0, {0, false}, false},
+  {"solana",   "SOL", "Solana",   TFT_MAGENTA,0, 0, {}, 0, 0, 0, {0, false}, false},
+  {"cardano",  "ADA", "Cardano",  TFT_BLUE,   0, 0, {}, 0, 0, 0, {0, false}, false},
+  {"ripple",   "XRP", "Ripple",   TFT_DARKGREY, 0, 0, {}, 0, 0, 0, {0, false}, false},
+  {"dogecoin", "DOGE","Dogecoin", TFT_YELLOW, 0, 0, {}, 0, 0, 0, {0, false}, false}
+};
+
+// --- Rendu ---
+// Le graphique est compose hors ecran dans un sprite 8 bits (282x132,
+// 37 Ko) puis pousse en une seule transaction SPI : plus de trace visible
+// ligne a ligne. Un sprite 16 bits eligible au DMA (74 Ko) ne tiendrait pas
+// a cote de la pile TLS sur l'ESP32 sans PSRAM.
+TFT_eSprite chartSpr = TFT_eSprite(&tft);
+bool chartSprOk = false;
+
+// 1 = rendu d'avant le sprite, pour comparer les logs "Rendu ..." sur la
+// meme carte : pas de sprite, ecran principal efface et tout redessine
+// directement sur le TFT a chaque prix, graphique et changement de crypto.
+#define UI_DIRECT_RENDER 0
+
+#define CHART_SPR_W (CHART_W + 2)
+#define CHART_SPR_H (CHART_H + 2)
+#define GLYPH_W      12     // police GLCD taille 2
+#define PRICE_CHARS  11
+#define CHANGE_CHARS 8
+#define CHANGE_Y     30     // sous le prix, au-dessus du cadre du graphique
+
+struct GlyphField {
+  int x, y;
+  int chars;
+  char shown[16];     // texte affiche, cadre a droite sur 'chars' cellules
+  uint16_t color;
 };
 
+// Statistiques du rendu en cours (log serie). uiDraws compte les appels de
+// dessin TFT_eSPI emis (fillRect, drawChar, pushSprite), pas les
+// transactions SPI reelles ; les durees sont mesurees (esp_timer).
+uint32_t uiDraws = 0;
+uint32_t uiPushUs = 0;   // duree du pushSprite du graphique
+
+// Les champs de donnees de cryptos[] sont ecrits par la tache reseau :
+// toute lecture/ecriture passe par cryptoMux (copie de la struct).
+portMUX_TYPE cryptoMux = portMUX_INITIALIZER_UNLOCKED;
+bool pricesUpdated = false;            // prix et historique ecrits (cryptoMux)
+uint32_t chartsUpdated = 0;            // bit i : graphique de cryptos[i] recu (cryptoMux)
+
+// Historique local de chaque crypto (15,8 Ko au total), alimente par
+// chaque prix recu. Hors de Crypto pour que snapshotCrypto() ne le copie
+// pas. Protege par un mutex et non par cryptoMux : add() (logf) et
+// series() (jusqu'a 168 bougies, expf) ne doivent pas tourner
+// interruptions coupees.
+PriceHistory history[NUM_CRYPTOS];
+SemaphoreHandle_t historyMutex;
+int chartView = HIST_7D;               // vue du graphique
+unsigned long lastLocalChart = 0;
+#define LOCAL_CHART_MS 5000            // rafraichissement des vues locales
+const char* const VIEW_LABELS[HIST_VIEW_COUNT] = {"1 heure", "24 heures", "7 jours"};
+
+// --- Mode ticker WebSocket ---
+// Un seul WebSocket persistant sur le flux combine miniTicker (1 message
+// par paire et par seconde au plus). Chaque message ecrase le prix de la
+// crypto dans cryptos[] ; l'ecran ne redessine qu'a PRICE_UI_MIN_MS au
+// plus, quel que soit le debit du flux. Tant que le flux vit, le polling
+// REST des prix est suspendu (les graphiques restent en REST).
+// Test en local : WS_HOST "192.168.1.20", WS_PORT 8765, WS_TLS 0 avec
+// ticker_standin.py. Sans le mode (0), prix en polling REST seul.
+#define PRICE_STREAMING 0
+#define WS_HOST        "stream.binance.com"
+#define WS_PORT        9443
+#define WS_TLS         1
+#define WS_QUOTE       "usdt"   // paires BTCUSDT, ETHUSDT...
+#define WS_STALE_MS    15000    // sans message : retour au polling REST
+#define PRICE_UI_MIN_MS 500     // cadence max de redessin des prix
+
+#if PRICE_STREAMING
+#include <WebSocketsClient.h>
+
+WebSocketsClient ws;
+volatile unsigned long wsLastMsg = 0;
+volatile uint32_t wsMessages = 0;
+char wsPath[192];
+#endif
+
 int currentCrypto = 0;
-unsigned long lastUpdate = 0;
 unsigned long lastTouch = 0;
+unsigned long lastPriceDraw = 0;
 unsigned long lastInteraction = 0;
 unsigned long lastAutoRotate = 0;
 #define UPDATE_INTERVAL 60000   // 60 secondes
@@ -93,9 +185,13 @@ unsigned long lastAutoRotate = 0;
 #define BTN_NEXT_X (SCREEN_W - BTN_W - 10)
 #define BTN_Y (SCREEN_H - FOOTER_H + 5)
 
+GlyphField priceField  = {SCREEN_W - 10 - PRICE_CHARS * GLYPH_W,  12,       PRICE_CHARS,  "", TFT_WHITE};
+GlyphField changeField = {SCREEN_W - 10 - CHANGE_CHARS * GLYPH_W, CHANGE_Y, CHANGE_CHARS, "", TFT_WHITE};
+
 void setup() {
   Serial.begin(115200);
   Serial.println("Crypto Tracker - ESP32-2432S028");
+  historyMutex = xSemaphoreCreateMutex();
 
   // Backlight
   pinMode(TFT_BACKLIGHT, OUTPUT);
@@ -106,6 +202,13 @@ void setup() {
   tft.setRotation(1);
   tft.fillScreen(TFT_BLACK);
 
+  // Sprite du graphique alloue avant le WiFi/TLS (tas encore contigu)
+#if !UI_DIRECT_RENDER
+  chartSpr.setColorDepth(8);
+  chartSprOk = chartSpr.createSprite(CHART_SPR_W, CHART_SPR_H) != nullptr;
+  if (!chartSprOk) Serial.println("Sprite graphique indisponible, trace direct");
+#endif
+
   // Init tactile
   touchSPI.begin(TOUCH_CLK, TOUCH_MISO, TOUCH_MOSI, TOUCH_CS);
   ts.begin(touchSPI);
@@ -115,11 +218,10 @@ void setup() {
   drawConnecting();
   connectWiFi();
 
-  // Premier chargement
+  // Premier affichage, les donnees arrivent par la tache reseau
   drawUI();
-  fetchAllPrices();
-  fetchChartData(currentCrypto);
   drawCrypto();
+  xTaskCreatePinnedToCore(netTask, "net", 10240, NULL, 1, NULL, 0);
 
   // Initialiser les timers
   lastInteraction = millis();
@@ -186,13 +288,39 @@ void drawDots() {
   }
 }
 
+void snapshotCrypto(int index, Crypto& out) {
+  portENTER_CRITICAL(&cryptoMux);
+  out = cryptos[index];
+  portEXIT_CRITICAL(&cryptoMux);
+}
+
+// Tache reseau, apres l'ecriture du prix et de l'historique
+void setPricesUpdated() {
+  portENTER_CRITICAL(&cryptoMux);
+  pricesUpdated = true;
+  portEXIT_CRITICAL(&cryptoMux);
+}
+
+// Changement de crypto : tout l'ecran sauf les boutons
 void drawCrypto() {
-  Crypto& c = cryptos[currentCrypto];
+  renderAll("crypto");
+}
 
-  // Effacer zone principale (garder footer)
-  tft.fillRect(0, 0, SCREEN_W, SCREEN_H - FOOTER_H, TFT_BLACK);
+void renderAll(const char* what) {
+  Crypto c;
+  snapshotCrypto(currentCrypto, c);
+  loadChartView(currentCrypto, c);
+  unsigned long t0 = micros();
+  uiDraws = 0;
+  uiPushUs = 0;
 
-  // Header: symbole et nom
+#if UI_DIRECT_RENDER
+  // Rendu d'avant : effacer toute la zone principale (garder le footer)
+  tft.fillRect(0, 0, SCREEN_W, SCREEN_H - FOOTER_H, TFT_BLACK);
+#else
+  // Header: symbole et nom (le prix a droite est un champ a part)
+  tft.fillRect(0, 0, priceField.x, HEADER_H, TFT_BLACK);
+#endif
   tft.setTextColor(c.color);
   tft.setTextSize(3);
   tft.setCursor(10, 8);
@@ -202,18 +330,86 @@ void drawCrypto() {
   tft.setTextSize(2);
   tft.setCursor(80, 12);
   tft.print(c.name);
+  uiDraws += 1 + strlen(c.symbol) + strlen(c.name);
+
+  renderChart(c);
+  drawPriceFields(c, true);
+
+  // Mettre a jour les dots
+  tft.fillRect(60, BTN_Y, 200, BTN_H, TFT_BLACK);
+  drawDots();
+  uiDraws += 1 + NUM_CRYPTOS;
+
+  logFrame(what, t0);
+}
+
+// Nouveaux prix : seules les cellules modifiees sont redessinees
+void updatePrices() {
+#if UI_DIRECT_RENDER
+  renderAll("prix");
+  return;
+#endif
+  Crypto c;
+  snapshotCrypto(currentCrypto, c);
+  unsigned long t0 = micros();
+  uiDraws = 0;
+  uiPushUs = 0;
+  drawPriceFields(c, false);
+  logFrame("prix", t0);
+}
+
+// Nouveau graphique pour la crypto affichee
+void updateChart() {
+#if UI_DIRECT_RENDER
+  renderAll("graphique");
+  return;
+#endif
+  Crypto c;
+  snapshotCrypto(currentCrypto, c);
+  loadChartView(currentCrypto, c);
+  unsigned long t0 = micros();
+  uiDraws = 0;
+  uiPushUs = 0;
+  renderChart(c);
+  logFrame("graphique", t0);
+}
+
+void logFrame(const char* what, unsigned long t0) {
+  Serial.printf("Rendu %s : %lu us (dont pushSprite %lu us), %lu appels de dessin\n",
+                what, micros() - t0, (unsigned long)uiPushUs, (unsigned long)uiDraws);
+}
 
+// Champ texte a chasse fixe cadre a droite. La police GLCD avec couleur de
+// fond peint toute sa cellule : pas d'effacement prealable, pas de
+// scintillement, et seules les cellules dont le caractere change partent
+// sur le bus.
+void drawGlyphField(GlyphField& f, const char* text, uint16_t color, bool force) {
+  char padded[sizeof(f.shown)];
+  int len = strlen(text);
+  if (len > f.chars) {
+    text += len - f.chars;
+    len = f.chars;
+  }
+  memset(padded, ' ', f.chars);
+  memcpy(padded + f.chars - len, text, len);
+  if (color != f.color) force = true;
+
+  for (int i = 0; i < f.chars; i++) {
+    if (!force && f.shown[i] == padded[i]) continue;
+    tft.drawChar(f.x + i * GLYPH_W, f.y, padded[i], color, TFT_BLACK, 2);
+    uiDraws++;
+  }
+  memcpy(f.shown, padded, f.chars);
+  f.color = color;
+}
+
+void drawPriceFields(const Crypto& c, bool force) {
   if (!c.dataValid) {
-    tft.setTextColor(TFT_DARKGREY);
-    tft.setTextSize(2);
-    tft.setCursor(100, 100);
-    tft.print("Chargement...");
+    drawGlyphField(priceField, "", TFT_WHITE, force);
+    drawGlyphField(changeField, "", TFT_WHITE, force);
     return;
   }
 
-  // Prix
-  tft.setTextColor(TFT_WHITE);
-  tft.setTextSize(1);
   char priceStr[20];
   if (c.price >= 1000) {
     sprintf(priceStr, "$%.2f", c.price);
@@ -222,52 +418,48 @@ void drawCrypto() {
   } else {
     sprintf(priceStr, "$%.6f", c.price);
   }
-
-  // Afficher le prix en grand a droite du header
-  tft.setTextSize(2);
-  int priceWidth = strlen(priceStr) * 12;
-  tft.setCursor(SCREEN_W - priceWidth - 10, 12);
-  tft.print(priceStr);
+  drawGlyphField(priceField, priceStr, TFT_WHITE, force);
 
   // Variation 24h
   uint16_t changeColor = (c.change24h >= 0) ? TFT_GREEN : TFT_RED;
-  tft.setTextColor(changeColor);
-  tft.setTextSize(2);
-
   char changeStr[15];
   if (c.change24h >= 0) {
     sprintf(changeStr, "+%.2f%%", c.change24h);
   } else {
     sprintf(changeStr, "%.2f%%", c.change24h);
   }
-
-  tft.setCursor(SCREEN_W - 90, HEADER_H + 5);
-  tft.print(changeStr);
-
-  // Dessiner le graphique
-  drawChart();
-
-  // Mettre a jour les dots
-  tft.fillRect(60, BTN_Y, 200, BTN_H, TFT_BLACK);
-  drawDots();
+  drawGlyphField(changeField, changeStr, changeColor, force);
 }
 
-void drawChart() {
-  Crypto& c = cryptos[currentCrypto];
-
-  if (c.chartPoints < 2) return;
-
-  // Cadre du graphique
-  tft.drawRect(CHART_X - 1, CHART_Y - 1, CHART_W + 2, CHART_H + 2, TFT_DARKGREY);
-
-  // Trouver min/max
-  float minVal = c.chartData[0];
-  float maxVal = c.chartData[0];
-  for (int i = 1; i < c.chartPoints; i++) {
-    if (c.chartData[i] < minVal) minVal = c.chartData[i];
-    if (c.chartData[i] > maxVal) maxVal = c.chartData[i];
+// Compose le graphique (cadre compris) dans le sprite puis le pousse d'un
+// bloc. Sans sprite (allocation refusee, UI_DIRECT_RENDER), trace direct
+// comme avant ; les appels de dessin ne comptent alors dans uiDraws que
+// s'ils vont au TFT.
+void renderChart(const Crypto& c) {
+  TFT_eSPI& g = chartSprOk ? (TFT_eSPI&)chartSpr : tft;
+  uint32_t draws = 2;                      // fond et cadre
+  int ox = chartSprOk ? 0 : CHART_X - 1;   // origine = coin du cadre
+  int oy = chartSprOk ? 0 : CHART_Y - 1;
+  int px = ox + 1, py = oy + 1;            // origine de la zone de trace
+
+  g.fillRect(ox, oy, CHART_SPR_W, CHART_SPR_H, TFT_BLACK);
+  g.drawRect(ox, oy, CHART_SPR_W, CHART_SPR_H, TFT_DARKGREY);
+
+  if (!c.dataValid || c.chartPoints < 2) {
+    g.setTextColor(TFT_DARKGREY);
+    g.setTextSize(2);
+    g.setCursor(px + 80, py + 50);
+    const char* msg = chartView == HIST_7D ? "Chargement..." : "Collecte...";
+    g.print(msg);
+    if (!chartSprOk) uiDraws += draws + strlen(msg);
+    pushChart();
+    return;
   }
 
+  // Min/max connus a la quantification
+  float minVal = c.chartMin;
+  float maxVal = c.chartMax;
+
   // Ajouter une marge de 5%
   float range = maxVal - minVal;
   if (range < 0.01) range = 0.01;
@@ -276,20 +468,23 @@ void drawChart() {
 
   // Lignes de grille horizontales
   for (int i = 0; i <= 4; i++) {
-    int y = CHART_Y + (CHART_H * i / 4);
-    tft.drawFastHLine(CHART_X, y, CHART_W, TFT_DARKGREY);
+    int y = py + (CHART_H * i / 4);
+    g.drawFastHLine(px, y, CHART_W, TFT_DARKGREY);
+    draws++;
   }
 
   // Dessiner la courbe
   int prevX = 0, prevY = 0;
   for (int i = 0; i < c.chartPoints; i++) {
-    int x = CHART_X + (i * CHART_W / (c.chartPoints - 1));
-    int y = CHART_Y + CHART_H - (int)((c.chartData[i] - minVal) / (maxVal - minVal) * CHART_H);
+    int x = px + (i * CHART_W / (c.chartPoints - 1));
+    float v = c.chartMin + c.chartData[i] * (c.chartMax - c.chartMin) / 65535.0f;
+    int y = py + CHART_H - (int)((v - minVal) / (maxVal - minVal) * CHART_H);
 
     if (i > 0) {
-      tft.drawLine(prevX, prevY, x, y, c.color);
+      g.drawLine(prevX, prevY, x, y, c.color);
       // Ligne plus epaisse
-      tft.drawLine(prevX, prevY + 1, x, y + 1, c.color);
+      g.drawLine(prevX, prevY + 1, x, y + 1, c.color);
+      draws += 2;
     }
 
     prevX = x;
@@ -297,21 +492,34 @@ void drawChart() {
   }
 
   // Labels min/max
-  tft.setTextColor(TFT_DARKGREY);
-  tft.setTextSize(1);
+  g.setTextColor(TFT_DARKGREY);
+  g.setTextSize(1);
 
   char minStr[15], maxStr[15];
   formatPrice(maxVal, maxStr);
   formatPrice(minVal, minStr);
 
-  tft.setCursor(CHART_X + 5, CHART_Y + 5);
-  tft.print(maxStr);
-  tft.setCursor(CHART_X + 5, CHART_Y + CHART_H - 10);
-  tft.print(minStr);
+  g.setCursor(px + 5, py + 5);
+  g.print(maxStr);
+  g.setCursor(px + 5, py + CHART_H - 10);
+  g.print(minStr);
+
+  // Label de la vue
+  const char* label = VIEW_LABELS[chartView];
+  g.setCursor(px + CHART_W - 6 * strlen(label) - 8, py + CHART_H - 10);
+  g.print(label);
+  draws += strlen(maxStr) + strlen(minStr) + strlen(label);
+
+  if (!chartSprOk) uiDraws += draws;
+  pushChart();
+}
 
-  // Label "7 jours"
-  tft.setCursor(CHART_X + CHART_W - 50, CHART_Y + CHART_H - 10);
-  tft.print("7 jours");
+void pushChart() {
+  if (!chartSprOk) return;
+  int64_t t0 = esp_timer_get_time();
+  chartSpr.pushSprite(CHART_X - 1, CHART_Y - 1);
+  uiPushUs += esp_timer_get_time() - t0;
+  uiDraws++;
 }
 
 void formatPrice(float price, char* buf) {
@@ -353,13 +561,20 @@ void fetchAllPrices() {
       for (int i = 0; i < NUM_CRYPTOS; i++) {
         JsonObject coin = doc[cryptos[i].id];
         if (!coin.isNull()) {
-          cryptos[i].price = coin["usd"].as<float>();
-          cryptos[i].change24h = coin["usd_24h_change"].as<float>();
+          float price = coin["usd"].as<float>();
+          float change = coin["usd_24h_change"].as<float>();
+          portENTER_CRITICAL(&cryptoMux);
+          cryptos[i].price = price;
+          cryptos[i].change24h = change;
           cryptos[i].dataValid = true;
-          Serial.printf("%s: $%.2f (%.2f%%)\n",
-            cryptos[i].symbol, cryptos[i].price, cryptos[i].change24h);
+          portEXIT_CRITICAL(&cryptoMux);
+          xSemaphoreTake(historyMutex, portMAX_DELAY);
+          history[i].add(uptimeS(), price);
+          xSemaphoreGive(historyMutex);
+          Serial.printf("%s: $%.2f (%.2f%%)\n", cryptos[i].symbol, price, change);
         }
       }
+      setPricesUpdated();
     }
   } else {
     Serial.printf("HTTP error: %d\n", httpCode);
@@ -368,17 +583,28 @@ void fetchAllPrices() {
   http.end();
 }
 
-void fetchChartData(int index) {
-  if (WiFi.status() != WL_CONNECTED) return;
-  if (index < 0 || index >= NUM_CRYPTOS) return;
+// Print branche sur le decodeur ; un write() incomplet arrete writeToStream
+class ChartSink : public Print {
+public:
+  ChartStreamDecoder dec;
 
-  Crypto& c = cryptos[index];
+  size_t write(uint8_t c) override { return dec.feed((char)c) ? 1 : 0; }
 
-  // Afficher indicateur de chargement
-  tft.setTextColor(TFT_DARKGREY);
-  tft.setTextSize(1);
-  tft.setCursor(CHART_X + CHART_W - 30, CHART_Y + 5);
-  tft.print("...");
+  size_t write(const uint8_t* buf, size_t len) override {
+    for (size_t i = 0; i < len; i++) {
+      if (!dec.feed((char)buf[i])) return i;
+    }
+    return len;
+  }
+};
+
+// Appelee par la tache reseau uniquement (pas d'acces ecran ici)
+bool fetchChartData(int index) {
+  if (WiFi.status() != WL_CONNECTED) return false;
+  if (index < 0 || index >= NUM_CRYPTOS) return false;
+
+  const Crypto& c = cryptos[index];   // id/symbol : constants
+  bool ok = false;
 
   HTTPClient http;
 
@@ -389,31 +615,223 @@ void fetchChartData(int index) {
   int httpCode = http.GET();
 
   if (httpCode == HTTP_CODE_OK) {
-    String payload = http.getString();
+    // Decodage en flux (structure: {"prices": [[timestamp, price], ...]}) :
+    // ni getString() ni document JSON, writeToStream gere le chunked et
+    // s'arrete des que le tableau "prices" est ferme.
+    static ChartSink sink;
+    sink.dec.begin(CHART_SPAN_MS);
+    http.writeToStream(&sink);
+
+    float points[CHART_POINTS];
+    int n = sink.dec.finish(points, CHART_POINTS);
+    if (sink.dec.finished() && n >= 2) {
+      storeChart(index, points, n);
+      ok = true;
+    }
+    Serial.printf("%s: %u paires -> %d points\n", c.symbol, (unsigned)sink.dec.pairs(), n);
+  } else {
+    Serial.printf("Chart HTTP error: %d\n", httpCode);
+  }
 
-    // Parser le JSON (structure: {"prices": [[timestamp, price], ...]})
-    DynamicJsonDocument doc(32768);
-    DeserializationError error = deserializeJson(doc, payload);
+  http.end();
+  return ok;
+}
 
-    if (!error) {
-      JsonArray prices = doc["prices"];
-      int total = prices.size();
+// Quantification sur 16 bits entre min et max (100 octets au lieu de 200)
+void quantizeChart(Crypto& c, const float* points, int n, float minVal, float maxVal) {
+  float range = maxVal - minVal;
+  for (int i = 0; i < n; i++) {
+    float q = (range > 0) ? (points[i] - minVal) / range * 65535.0f + 0.5f : 0;
+    c.chartData[i] = (uint16_t)constrain(q, 0.0f, 65535.0f);
+  }
+  c.chartMin = minVal;
+  c.chartMax = maxVal;
+  c.chartPoints = n;
+}
 
-      // Echantillonner pour avoir ~50 points
-      int step = max(1, total / 50);
-      c.chartPoints = 0;
+void storeChart(int index, const float* points, int n) {
+  float minVal = points[0], maxVal = points[0];
+  for (int i = 1; i < n; i++) {
+    if (points[i] < minVal) minVal = points[i];
+    if (points[i] > maxVal) maxVal = points[i];
+  }
+  Crypto q;
+  quantizeChart(q, points, n, minVal, maxVal);
 
-      for (int i = 0; i < total && c.chartPoints < 50; i += step) {
-        c.chartData[c.chartPoints++] = prices[i][1].as<float>();
-      }
+  portENTER_CRITICAL(&cryptoMux);
+  Crypto& c = cryptos[index];
+  memcpy(c.chartData, q.chartData, n * sizeof(uint16_t));
+  c.chartMin = q.chartMin;
+  c.chartMax = q.chartMax;
+  c.chartPoints = n;
+  c.chart.fetchedMs = millis();
+  c.chart.valid = true;
+  portEXIT_CRITICAL(&cryptoMux);
+}
+
+// Secondes depuis le boot (compteur 64 bits : pas de debordement a 49 j)
+uint32_t uptimeS() {
+  return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+// Remplace le graphique de la copie par la vue locale demandee. La vue
+// 7 jours garde le graphique CoinGecko tant qu'il existe ; l'historique
+// local ne sert qu'en son absence (hors ligne).
+void loadChartView(int index, Crypto& c) {
+  if (chartView == HIST_7D && c.chart.valid) return;
+
+  float points[CHART_POINTS];
+  float lo = 0, hi = 0;
+  uint32_t nowS = uptimeS();
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  int n = history[index].series((HistView)chartView, nowS, points, CHART_POINTS, lo, hi);
+  xSemaphoreGive(historyMutex);
+
+  if (n < 2) {
+    c.chartPoints = 0;
+    return;
+  }
+  quantizeChart(c, points, n, lo, hi);
+}
 
-      Serial.printf("%s: %d points charges\n", c.symbol, c.chartPoints);
+#if PRICE_STREAMING
+// Message miniTicker combine :
+// {"stream":"btcusdt@miniTicker","data":{"s":"BTCUSDT","c":"67000.1","o":"66000.0",...}}
+// Le stand-in local peut aussi envoyer directement l'objet "data".
+void handleTicker(const uint8_t* payload, size_t length) {
+  StaticJsonDocument<128> filter;
+  filter["data"]["s"] = true;
+  filter["data"]["c"] = true;
+  filter["data"]["o"] = true;
+  filter["s"] = true;
+  filter["c"] = true;
+  filter["o"] = true;
+
+  StaticJsonDocument<192> doc;
+  if (deserializeJson(doc, payload, length, DeserializationOption::Filter(filter))) return;
+
+  JsonObject d = doc["data"];
+  if (d.isNull()) d = doc.as<JsonObject>();
+  const char* pair = d["s"];
+  if (!pair) return;
+
+  int idx = -1;
+  for (int i = 0; i < NUM_CRYPTOS && idx < 0; i++) {
+    size_t n = strlen(cryptos[i].symbol);
+    if (strncasecmp(pair, cryptos[i].symbol, n) == 0 && strcasecmp(pair + n, WS_QUOTE) == 0) idx = i;
+  }
+  if (idx < 0) return;
+
+  // Prix transmis en chaines
+  float close = atof(d["c"] | "0");
+  float open = atof(d["o"] | "0");
+  if (close <= 0) return;
+  float change = open > 0 ? (close - open) / open * 100.0f : 0;
+
+  portENTER_CRITICAL(&cryptoMux);
+  cryptos[idx].price = close;
+  cryptos[idx].change24h = change;
+  cryptos[idx].dataValid = true;
+  portEXIT_CRITICAL(&cryptoMux);
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  history[idx].add(uptimeS(), close);
+  xSemaphoreGive(historyMutex);
+
+  wsLastMsg = millis();
+  wsMessages++;
+  setPricesUpdated();
+}
+
+void onWsEvent(WStype_t type, uint8_t* payload, size_t length) {
+  switch (type) {
+    case WStype_CONNECTED:
+      Serial.printf("Ticker WS connecte : %s:%d\n", WS_HOST, WS_PORT);
+      break;
+    case WStype_DISCONNECTED:
+      Serial.println("Ticker WS deconnecte");
+      break;
+    case WStype_TEXT:
+      handleTicker(payload, length);
+      break;
+    default:
+      break;
+  }
+}
+
+void wsBegin() {
+  int n = snprintf(wsPath, sizeof(wsPath), "/stream?streams=");
+  for (int i = 0; i < NUM_CRYPTOS && n < (int)sizeof(wsPath); i++) {
+    if (i > 0) wsPath[n++] = '/';
+    for (const char* p = cryptos[i].symbol; *p && n < (int)sizeof(wsPath) - 1; p++) {
+      wsPath[n++] = tolower(*p);
     }
-  } else {
-    Serial.printf("Chart HTTP error: %d\n", httpCode);
+    n += snprintf(wsPath + n, sizeof(wsPath) - n, WS_QUOTE "@miniTicker");
   }
 
-  http.end();
+#if WS_TLS
+  ws.beginSSL(WS_HOST, WS_PORT, wsPath);
+#else
+  ws.begin(WS_HOST, WS_PORT, wsPath);
+#endif
+  ws.onEvent(onWsEvent);
+  ws.setReconnectInterval(5000);
+  ws.enableHeartbeat(15000, 3000, 2);   // ping/pong : detecte un lien mort
+}
+
+// Flux vivant : connecte et un message recu recemment
+bool wsLive() {
+  return ws.isConnected() && wsMessages > 0 && millis() - wsLastMsg < WS_STALE_MS;
+}
+#endif
+
+// Tache reseau (core 0) : prix toutes les UPDATE_INTERVAL, graphiques
+// expires un par un selon chart_cache.h. L'UI n'attend jamais le reseau.
+void netTask(void* arg) {
+  unsigned long lastPrices = 0;
+  bool pricesOnce = false;
+  unsigned long lastChartFetch = millis() - CHART_MIN_GAP_MS;
+#if PRICE_STREAMING
+  bool wasLive = false;
+  wsBegin();
+#endif
+
+  for (;;) {
+    if (WiFi.status() == WL_CONNECTED) {
+#if PRICE_STREAMING
+      ws.loop();
+      bool live = wsLive();
+      if (live != wasLive) {
+        Serial.println(live ? "Prix : flux WebSocket" : "Prix : polling REST");
+        wasLive = live;
+      }
+#else
+      bool live = false;
+#endif
+      unsigned long now = millis();
+      if (!live && (!pricesOnce || now - lastPrices > UPDATE_INTERVAL)) {
+        lastPrices = now;
+        pricesOnce = true;
+        fetchAllPrices();
+      } else {
+        ChartCacheEntry entries[NUM_CRYPTOS];
+        portENTER_CRITICAL(&cryptoMux);
+        for (int i = 0; i < NUM_CRYPTOS; i++) entries[i] = cryptos[i].chart;
+        portEXIT_CRITICAL(&cryptoMux);
+
+        int idx = chartPickRefresh(entries, NUM_CRYPTOS, currentCrypto, now, lastChartFetch);
+        if (idx >= 0) {
+          lastChartFetch = now;
+          if (fetchChartData(idx)) {
+            portENTER_CRITICAL(&cryptoMux);
+            chartsUpdated |= 1UL << idx;
+            portEXIT_CRITICAL(&cryptoMux);
+          }
+        }
+      }
+    }
+    // ws.loop() doit tourner souvent pour vider la socket
+    vTaskDelay(pdMS_TO_TICKS(PRICE_STREAMING ? 20 : 500));
+  }
 }
 
 void handleTouch() {
@@ -435,6 +853,13 @@ void handleTouch() {
 
   Serial.printf("Touch: %d, %d\n", x, y);
 
+  // Graphique : vue suivante (7 jours -> 1 heure -> 24 heures)
+  if (y >= CHART_Y && y < CHART_Y + CHART_H) {
+    chartView = (chartView + 1) % HIST_VIEW_COUNT;
+    updateChart();
+    return;
+  }
+
   // Bouton precedent
   if (x < BTN_PREV_X + BTN_W + 20 && y > BTN_Y - 10) {
     // Animation bouton
@@ -452,7 +877,6 @@ void handleTouch() {
     tft.setCursor(BTN_PREV_X + 15, BTN_Y + 8);
     tft.print("<");
 
-    fetchChartData(currentCrypto);
     drawCrypto();
   }
   // Bouton suivant
@@ -472,7 +896,6 @@ void handleTouch() {
     tft.setCursor(BTN_NEXT_X + 15, BTN_Y + 8);
     tft.print(">");
 
-    fetchChartData(currentCrypto);
     drawCrypto();
   }
 }
@@ -487,18 +910,37 @@ void loop() {
     if (now - lastAutoRotate > AUTO_ROTATE_INTERVAL) {
       lastAutoRotate = now;
       currentCrypto = (currentCrypto + 1) % NUM_CRYPTOS;
-      fetchChartData(currentCrypto);
       drawCrypto();
     }
   }
 
-  // Mise a jour periodique des prix
-  if (now - lastUpdate > UPDATE_INTERVAL) {
-    lastUpdate = now;
-    fetchAllPrices();
-    fetchChartData(currentCrypto);
-    drawCrypto();
+  // Nouvelles donnees de la tache reseau : redessiner si elles concernent
+  // la crypto affichee (prix coalesces, PRICE_UI_MIN_MS au plus). Lecture
+  // et remise a zero atomiques, comme chartsUpdated : un prix recu entre
+  // les deux n'attend pas le prochain poll
+  bool prices = false;
+  if (now - lastPriceDraw >= PRICE_UI_MIN_MS) {
+    portENTER_CRITICAL(&cryptoMux);
+    prices = pricesUpdated;
+    pricesUpdated = false;
+    portEXIT_CRITICAL(&cryptoMux);
+  }
+  if (prices) {
+    lastPriceDraw = now;
+    updatePrices();
+    // Les vues locales suivent les nouveaux ticks
+    if (chartView != HIST_7D && now - lastLocalChart >= LOCAL_CHART_MS) {
+      lastLocalChart = now;
+      updateChart();
+    }
   }
+  // Lecture et remise a zero atomiques : un graphique recu entre les deux
+  // n'est pas perdu
+  portENTER_CRITICAL(&cryptoMux);
+  uint32_t charts = chartsUpdated;
+  chartsUpdated = 0;
+  portEXIT_CRITICAL(&cryptoMux);
+  if (charts & (1UL << currentCrypto)) updateChart();
 
   delay(50);
 }
@@ -0,0 +1,48 @@
+/*
+ * chart_cache.h - Politique de rafraichissement du cache des graphiques
+ *
+ * Les graphiques 7 jours evoluent a l'echelle de l'heure : chaque crypto
+ * garde son graphique CHART_TTL_MS, la tache reseau ne re-telecharge que
+ * les entrees expirees, une a la fois. Aucune dependance Arduino
+ * (simulable sur PC).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define CHART_TTL_MS      (30UL * 60UL * 1000UL)  // 30 min
+#define CHART_MIN_GAP_MS  (20UL * 1000UL)         // entre deux refresh de fond
+#define CHART_RETRY_MS    (5UL * 1000UL)          // apres un echec sans donnees
+
+struct ChartCacheEntry {
+  uint32_t fetchedMs;   // millis() du dernier telechargement reussi
+  bool     valid;
+};
+
+inline bool chartExpired(const ChartCacheEntry& e, uint32_t now) {
+  return !e.valid || now - e.fetchedMs >= CHART_TTL_MS;
+}
+
+// Prochaine entree a telecharger, -1 si rien a faire.
+// La crypto affichee passe en premier ; si elle n'a encore aucune donnee
+// (l'utilisateur attend), seul un court delai de reessai s'applique. Sinon,
+// la plus ancienne entree expiree, au plus une toutes les CHART_MIN_GAP_MS.
+inline int chartPickRefresh(const ChartCacheEntry* entries, int n, int current,
+                            uint32_t now, uint32_t lastFetchMs) {
+  if (!entries[current].valid) {
+    return (now - lastFetchMs >= CHART_RETRY_MS) ? current : -1;
+  }
+  if (now - lastFetchMs < CHART_MIN_GAP_MS) return -1;
+  if (chartExpired(entries[current], now)) return current;
+
+  int best = -1;
+  for (int i = 0; i < n; i++) {
+    if (!chartExpired(entries[i], now)) continue;
+    if (best < 0 || !entries[i].valid ||
+        (entries[best].valid && entries[i].fetchedMs < entries[best].fetchedMs)) {
+      best = i;
+    }
+  }
+  return best;
+}
@@ -0,0 +1,143 @@
+/*
+ * chart_stream.h - Decodeur en flux de la reponse market_chart CoinGecko
+ *
+ * Lit {"prices":[[t,p],[t,p],...], ...} caractere par caractere, sans
+ * jamais stocker la reponse : chaque paire est versee dans un bucket de
+ * temps (span / CHART_STREAM_BUCKETS), qui ne garde que son min et son
+ * max. A la fin, chaque bucket restitue ses extremes dans l'ordre
+ * chronologique : les pics restent visibles avec O(CHART_STREAM_BUCKETS)
+ * memoire. Les tableaux suivants (market_caps, total_volumes) sont
+ * ignores : feed() renvoie false des que "prices" est ferme.
+ *
+ * Aucune dependance Arduino (rejouable sur PC avec une reponse enregistree).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHART_STREAM_BUCKETS 25   // 2 points max par bucket
+
+class ChartStreamDecoder {
+public:
+  void begin(double spanMs) {
+    memset(this, 0, sizeof(*this));
+    span = spanMs;
+  }
+
+  // Retourne false quand la suite du flux est inutile
+  bool feed(char ch) {
+    if (done) return false;
+
+    if (inString) {
+      if (escape) {
+        escape = false;
+      } else if (ch == '\\') {
+        escape = true;
+      } else if (ch == '"') {
+        inString = false;
+        key[keyLen] = '\0';
+        if (depth == 1) pricesNext = !keyOverflow && strcmp(key, "prices") == 0;
+      } else if (keyLen < sizeof(key) - 1) {
+        key[keyLen++] = ch;
+      } else {
+        keyOverflow = true;   // trop long : ne peut pas etre "prices"
+      }
+      return true;
+    }
+
+    switch (ch) {
+      case '"':
+        inString = true;
+        keyLen = 0;
+        keyOverflow = false;
+        break;
+      case '{':
+      case '[':
+        depth++;
+        if (ch == '[' && depth == 2 && pricesNext) inPrices = true;
+        if (inPrices && depth == 3) field = 0;
+        break;
+      case ',':
+        if (inPrices && depth == 3) { endNumber(); field++; }
+        break;
+      case ']':
+      case '}':
+        if (inPrices && depth == 3) { endNumber(); pushPair(); }
+        if (inPrices && depth == 2) { done = true; depth--; return false; }
+        depth--;
+        break;
+      default:
+        if (inPrices && depth == 3 && numLen < sizeof(num) - 1 &&
+            ((ch >= '0' && ch <= '9') || ch == '.' || ch == '-' || ch == '+' ||
+             ch == 'e' || ch == 'E')) {
+          num[numLen++] = ch;
+        }
+        break;
+    }
+    return true;
+  }
+
+  bool finished() const { return done; }
+  uint32_t pairs() const { return pairCount; }
+
+  // Restitue jusqu'a maxPoints valeurs (ordre chronologique)
+  int finish(float* out, int maxPoints) const {
+    int n = 0;
+    for (int b = 0; b < CHART_STREAM_BUCKETS; b++) {
+      const Bucket& k = buckets[b];
+      if (!k.count) continue;
+      bool minFirst = k.minT <= k.maxT;
+      float first = minFirst ? k.minV : k.maxV;
+      float second = minFirst ? k.maxV : k.minV;
+      if (n < maxPoints) out[n++] = first;
+      if (k.minT != k.maxT && n < maxPoints) out[n++] = second;
+    }
+    return n;
+  }
+
+private:
+  struct Bucket {
+    double minT, maxT;
+    float minV, maxV;
+    uint16_t count;
+  };
+
+  void endNumber() {
+    if (!numLen) return;
+    num[numLen] = '\0';
+    if (field == 0) t = strtod(num, nullptr);
+    else if (field == 1) v = strtof(num, nullptr);
+    numLen = 0;
+  }
+
+  void pushPair() {
+    if (field != 1) return;
+    if (!pairCount) t0 = t;
+    pairCount++;
+
+    int b = (span > 0) ? (int)((t - t0) * CHART_STREAM_BUCKETS / span) : 0;
+    if (b < 0) b = 0;
+    if (b >= CHART_STREAM_BUCKETS) b = CHART_STREAM_BUCKETS - 1;
+
+    Bucket& k = buckets[b];
+    if (!k.count || v < k.minV) { k.minV = v; k.minT = t; }
+    if (!k.count || v > k.maxV) { k.maxV = v; k.maxT = t; }
+    if (k.count < 0xFFFF) k.count++;
+  }
+
+  Bucket buckets[CHART_STREAM_BUCKETS];
+  double span;
+  double t0, t;
+  float v;
+  uint32_t pairCount;
+  char num[32];
+  uint8_t numLen;
+  uint8_t field;
+  char key[16];
+  uint8_t keyLen;
+  int8_t depth;
+  bool inString, escape, keyOverflow, pricesNext, inPrices, done;
+};
@@ -0,0 +1,181 @@
+/*
+ * price_history.h - Historique local des prix en bougies OHLC
+ *
+ * Chaque tick (poll REST ou message du ticker) est agrege directement dans
+ * trois anneaux de bougies : 60 x 1 min (vue 1 h), 96 x 15 min (vue 24 h)
+ * et 168 x 1 h (vue 7 jours). Rien d'autre n'est garde : les vues se
+ * calculent sans reseau.
+ *
+ * Prix en virgule fixe logarithmique sur 16 bits :
+ *   code = round(ln(prix / ref) * PH_SCALE)
+ * ref = premier prix recu. Pas de 0,01 %, plage ref/26 .. ref*26, et
+ * l'ordre des codes est celui des prix : h/l s'agregent exactement.
+ * Bougie = 8 octets, historique complet d'une crypto ~2,6 Ko.
+ *
+ * Temps en secondes depuis le boot, sans debordement. Un tick en retard
+ * (plus ancien que le dernier recu) compte dans les meches de la bougie
+ * en cours sans en changer la cloture ; s'il tombe dans une bougie deja
+ * close, il est ignore. Aucune dependance Arduino (testable sur PC,
+ * test/price_history_test.cpp).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+#define PH_SCALE 10000.0f
+#define PH_EMPTY INT16_MIN    // bougie sans tick
+#define PH_MAX_POINTS 64      // points max d'une vue
+
+struct Candle {
+  int16_t o, h, l, c;
+};
+
+template <int N, uint32_t PERIOD_S>
+struct CandleRing {
+  Candle   buf[N];
+  uint32_t lastSlot;    // t / PERIOD_S de la bougie la plus recente
+  uint16_t head;        // index de la bougie la plus recente
+  uint16_t count;
+
+  void clear() {
+    lastSlot = 0;
+    head = 0;
+    count = 0;
+  }
+
+  // late : tick plus ancien qu'un tick deja recu
+  void add(uint32_t t, int16_t v, bool late = false) {
+    uint32_t slot = t / PERIOD_S;
+    if (count && slot < lastSlot) return;     // bougie close : ignore
+
+    if (count && slot == lastSlot) {
+      Candle& c = buf[head];
+      if (v > c.h) c.h = v;
+      if (v < c.l) c.l = v;
+      if (!late) c.c = v;
+      return;
+    }
+
+    // Nouveau slot : bougies vides pour les slots sans tick
+    if (count) {
+      uint32_t gap = slot - lastSlot;
+      if (gap > N) {
+        clear();
+      } else {
+        for (uint32_t k = 1; k < gap; k++) push({PH_EMPTY, PH_EMPTY, PH_EMPTY, PH_EMPTY});
+      }
+    }
+    push({v, v, v, v});
+    lastSlot = slot;
+  }
+
+  void push(const Candle& c) {
+    head = count ? (head + 1) % N : 0;
+    buf[head] = c;
+    if (count < N) count++;
+  }
+
+  // Bougie du slot donne, nullptr si hors anneau ou jamais vue
+  const Candle* find(uint32_t slot) const {
+    if (!count || slot > lastSlot || lastSlot - slot >= count) return nullptr;
+    const Candle& c = buf[(head + N - (lastSlot - slot)) % N];
+    return c.o == PH_EMPTY ? nullptr : &c;
+  }
+
+  // Fenetre des N slots se terminant a nowS (slots d'avant le boot
+  // compris), regroupee en maxPoints colonnes : cloture de chaque colonne
+  // (la derniere connue est reportee sur les trous), lo/hi sur les meches.
+  // Les colonnes avant le premier tick recoivent sa cloture : la vue garde
+  // toute sa duree au lieu d'etirer des donnees partielles. Retourne le
+  // nombre de points, maxPoints (au plus N) ou 0 si aucun tick.
+  int series(uint32_t nowS, int32_t* out, int maxPoints, int16_t& lo, int16_t& hi) const {
+    int64_t last = nowS / PERIOD_S;
+    int64_t first = last - N + 1;
+    if (maxPoints > N) maxPoints = N;
+
+    int lead = 0;
+    int32_t close = PH_EMPTY;
+    lo = INT16_MAX;
+    hi = PH_EMPTY;
+    for (int b = 0; b < maxPoints; b++) {
+      int64_t s0 = first + (int64_t)N * b / maxPoints;
+      int64_t s1 = first + (int64_t)N * (b + 1) / maxPoints;
+      for (int64_t s = s0 < 0 ? 0 : s0; s < s1; s++) {
+        const Candle* c = find((uint32_t)s);
+        if (!c) continue;
+        if (c->l < lo) lo = c->l;
+        if (c->h > hi) hi = c->h;
+        close = c->c;
+      }
+      if (close == PH_EMPTY) lead++;
+      else out[b] = close;
+    }
+    if (close == PH_EMPTY) return 0;
+    for (int b = 0; b < lead; b++) out[b] = out[lead];
+    return maxPoints;
+  }
+};
+
+enum HistView { HIST_1H, HIST_24H, HIST_7D, HIST_VIEW_COUNT };
+
+struct PriceHistory {
+  float ref;            // 0 tant qu'aucun tick
+  uint32_t ticks;
+  uint32_t lastS;       // tick le plus recent
+  CandleRing<60, 60>    m1;
+  CandleRing<96, 900>   m15;
+  CandleRing<168, 3600> h1;
+
+  void clear() {
+    ref = 0;
+    ticks = 0;
+    lastS = 0;
+    m1.clear();
+    m15.clear();
+    h1.clear();
+  }
+
+  int16_t encode(float price) const {
+    float q = roundf(logf(price / ref) * PH_SCALE);
+    if (q > INT16_MAX) q = INT16_MAX;
+    if (q < -INT16_MAX) q = -INT16_MAX;     // PH_EMPTY reserve
+    return (int16_t)q;
+  }
+
+  float decode(int32_t code) const {
+    return ref * expf(code / PH_SCALE);
+  }
+
+  void add(uint32_t tS, float price) {
+    if (!(price > 0)) return;
+    if (!ref) ref = price;
+    int16_t v = encode(price);
+    bool late = ticks && tS < lastS;
+    if (!late) lastS = tS;
+    m1.add(tS, v, late);
+    m15.add(tS, v, late);
+    h1.add(tS, v, late);
+    ticks++;
+  }
+
+  // Clotures de la vue en prix, lo/hi = extremes des meches
+  int series(HistView view, uint32_t nowS, float* out, int maxPoints, float& lo, float& hi) const {
+    int32_t codes[PH_MAX_POINTS];
+    int16_t cl, ch;
+    int n = 0;
+    if (!ticks) return 0;
+    if (maxPoints > PH_MAX_POINTS) maxPoints = PH_MAX_POINTS;
+    switch (view) {
+      case HIST_1H:  n = m1.series(nowS, codes, maxPoints, cl, ch); break;
+      case HIST_24H: n = m15.series(nowS, codes, maxPoints, cl, ch); break;
+      default:       n = h1.series(nowS, codes, maxPoints, cl, ch); break;
+    }
+    if (!n) return 0;
+    for (int i = 0; i < n; i++) out[i] = decode(codes[i]);
+    lo = decode(cl);
+    hi = decode(ch);
+    return n;
+  }
+};
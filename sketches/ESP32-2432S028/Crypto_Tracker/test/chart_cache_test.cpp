@@ -0,0 +1,78 @@
+/*
+ * chart_cache_test.cpp - Test PC de la politique de cache (chart_cache.h)
+ *
+ * Simule une heure de fonctionnement : rotation automatique toutes les
+ * 5 s sur les 6 cryptos, tache reseau qui appelle chartPickRefresh()
+ * toutes les 500 ms comme networkTask(). Compte les telechargements de
+ * graphiques et les compare aux 720/h de l'ancien code (un par rotation).
+ *
+ *   g++ -std=c++11 -Wall -I.. -I../../../common chart_cache_test.cpp -o /tmp/chart_cache_test && /tmp/chart_cache_test
+ */
+
+#include <stdio.h>
+#include "chart_cache.h"
+#include "host_test.h"
+
+#define NUM_CRYPTOS 6               // comme dans Crypto_Tracker.ino
+#define ROTATE_MS   5000UL
+#define TASK_MS     500UL
+#define HOUR_MS     (3600UL * 1000UL)
+
+struct Sim {
+  ChartCacheEntry entries[NUM_CRYPTOS] = {};
+  uint32_t lastFetch = (uint32_t)(0 - CHART_MIN_GAP_MS);   // premier appel sans attente
+  int requests = 0;
+  int current = 0;
+
+  // failUntil : les telechargements echouent jusqu'a cet instant
+  void run(uint32_t from, uint32_t to, uint32_t failUntil = 0) {
+    for (uint32_t now = from; now < to; now += TASK_MS) {
+      current = (now / ROTATE_MS) % NUM_CRYPTOS;
+      int idx = chartPickRefresh(entries, NUM_CRYPTOS, current, now, lastFetch);
+      if (idx < 0) continue;
+      CHECK(idx < NUM_CRYPTOS, "index %d", idx);
+      if (entries[current].valid) {
+        CHECK(now - lastFetch >= CHART_MIN_GAP_MS, "refresh de fond trop rapproche a %u ms", now);
+      }
+      lastFetch = now;
+      requests++;
+      if (now >= failUntil) {
+        entries[idx].valid = true;
+        entries[idx].fetchedMs = now;
+      }
+    }
+  }
+};
+
+int main() {
+  // Une heure de rotation, demarrage a froid
+  Sim s;
+  s.run(0, HOUR_MS);
+  int maxRequests = NUM_CRYPTOS * (int)(HOUR_MS / CHART_TTL_MS + 1);
+  printf("1 h de rotation : %d requetes graphiques (ancien code : %lu)\n",
+         s.requests, HOUR_MS / ROTATE_MS);
+  CHECK(s.requests <= maxRequests, "%d requetes > %d", s.requests, maxRequests);
+  CHECK(s.requests >= NUM_CRYPTOS, "%d requetes : cache jamais rempli", s.requests);
+  for (int i = 0; i < NUM_CRYPTOS; i++) {
+    CHECK(!chartExpired(s.entries[i], HOUR_MS - TASK_MS), "crypto %d expiree en fin d'heure", i);
+  }
+
+  // Premier affichage : chaque crypto a son graphique avant d'etre montree
+  // une deuxieme fois (6 x 5 s = 30 s)
+  Sim cold;
+  cold.run(0, NUM_CRYPTOS * ROTATE_MS);
+  for (int i = 0; i < NUM_CRYPTOS; i++) {
+    CHECK(cold.entries[i].valid, "crypto %d toujours vide apres un tour", i);
+  }
+
+  // API en echec pendant 1 min : la crypto affichee est reessayee toutes
+  // les CHART_RETRY_MS, pas en boucle
+  Sim fail;
+  fail.run(0, 60000UL, 60000UL);
+  int maxRetries = (int)(60000UL / CHART_RETRY_MS) + 1;
+  printf("1 min d'echecs : %d tentatives\n", fail.requests);
+  CHECK(fail.requests <= maxRetries, "%d tentatives > %d", fail.requests, maxRetries);
+  CHECK(fail.requests > 0, "aucune tentative");
+
+  return hostTestEnd();
+}
@@ -0,0 +1,170 @@
+/*
+ * chart_stream_test.cpp - Test PC du decodeur en flux (chart_stream.h)
+ *
+ * Rejoue une reponse market_chart et compare les min/max de chaque bucket
+ * a ceux d'une lecture complete en memoire, la reponse etant versee octet
+ * par octet puis en morceaux de taille aleatoire (comme writeToStream).
+ * Verifie l'arret a la fin de "prices", quelques cas de syntaxe (cles
+ * imbriquees, chaines echappees, exposants) et la memoire du decodeur,
+ * seule memoire utilisee quelle que soit la taille de la reponse.
+ *
+ * market_chart_7d.json : format de /coins/<id>/market_chart?days=7
+ * (169 points horaires, premier et dernier hors grille, un pic et un creux
+ * isoles ; market_caps et total_volumes tronques a 3 points). Une reponse
+ * enregistree se rejoue en argument :
+ *   curl -o /tmp/btc.json 'https://api.coingecko.com/api/v3/coins/bitcoin/market_chart?vs_currency=usd&days=7'
+ *
+ *   g++ -std=c++11 -Wall -I.. -I../../../common chart_stream_test.cpp -o /tmp/chart_stream_test && /tmp/chart_stream_test [reponse.json]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "chart_stream.h"
+#include "host_test.h"
+
+#define CHART_POINTS  50                         // comme dans Crypto_Tracker.ino
+#define CHART_SPAN_MS (7.0 * 24 * 3600 * 1000)
+
+// La memoire du decodeur est fixe : c'est le pic, quelle que soit la reponse
+static_assert(sizeof(ChartStreamDecoder) <= 1024, "decodeur > 1 Ko");
+
+static bool readFile(const char* path, std::string& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+// Reference : tableau "prices" lu d'un bloc, memes buckets que le decodeur.
+// Renvoie la position du ']' qui ferme "prices".
+static size_t referenceParse(const std::string& json, std::vector<float>& out, uint32_t& pairs,
+                             float& allLo, float& allHi) {
+  size_t pos = json.find("\"prices\"");
+  pos = json.find('[', pos);
+  const char* p = json.c_str() + pos + 1;
+  struct B { double minT, maxT; float minV, maxV; int n; } b[CHART_STREAM_BUCKETS] = {};
+  double t0 = 0;
+  pairs = 0;
+  allLo = 1e30f;
+  allHi = -1e30f;
+  for (;;) {
+    while (*p == ' ' || *p == ',' || *p == '\n') p++;
+    if (*p == ']') break;
+    char* end;
+    double t = strtod(p + 1, &end);          // apres '['
+    float v = strtof(end + 1, &end);         // apres ','
+    p = strchr(end, ']') + 1;
+    if (!pairs) t0 = t;
+    pairs++;
+    if (v < allLo) allLo = v;
+    if (v > allHi) allHi = v;
+    int k = (int)((t - t0) * CHART_STREAM_BUCKETS / CHART_SPAN_MS);
+    if (k < 0) k = 0;
+    if (k >= CHART_STREAM_BUCKETS) k = CHART_STREAM_BUCKETS - 1;
+    if (!b[k].n || v < b[k].minV) { b[k].minV = v; b[k].minT = t; }
+    if (!b[k].n || v > b[k].maxV) { b[k].maxV = v; b[k].maxT = t; }
+    b[k].n++;
+  }
+  for (int k = 0; k < CHART_STREAM_BUCKETS; k++) {
+    if (!b[k].n) continue;
+    bool minFirst = b[k].minT <= b[k].maxT;
+    out.push_back(minFirst ? b[k].minV : b[k].maxV);
+    if (b[k].minT != b[k].maxT) out.push_back(minFirst ? b[k].maxV : b[k].minV);
+  }
+  return p - json.c_str();
+}
+
+// Verse 'json' par morceaux de 1..maxChunk octets ; renvoie le nombre
+// d'octets acceptes (ChartSink::write s'arrete au premier refus)
+static size_t stream(ChartStreamDecoder& dec, const std::string& json, size_t maxChunk, uint32_t seed) {
+  dec.begin(CHART_SPAN_MS);
+  size_t off = 0;
+  while (off < json.size()) {
+    seed = seed * 1103515245u + 12345u;
+    size_t len = maxChunk > 1 ? 1 + (seed >> 8) % maxChunk : 1;
+    if (len > json.size() - off) len = json.size() - off;
+    size_t i = 0;
+    while (i < len && dec.feed(json[off + i])) i++;
+    off += i;
+    if (i < len) return off;
+  }
+  return off;
+}
+
+static void testResponse(const char* path) {
+  std::string json;
+  if (!readFile(path, json)) {
+    CHECK(false, "lecture de %s", path);
+    return;
+  }
+  std::vector<float> ref;
+  uint32_t refPairs;
+  float allLo, allHi;
+  size_t closing = referenceParse(json, ref, refPairs, allLo, allHi);
+  CHECK(ref.size() >= 2 && ref.size() <= CHART_POINTS, "%u points de reference", (unsigned)ref.size());
+
+  const size_t chunks[] = {1, 7, 64, 1460};   // octet par octet ... segment TCP
+  for (size_t c : chunks) {
+    for (uint32_t seed = 1; seed <= (c == 1 ? 1u : 20u); seed++) {
+      ChartStreamDecoder dec;
+      size_t used = stream(dec, json, c, seed);
+      CHECK(dec.finished(), "%s, morceaux <= %u : pas fini", path, (unsigned)c);
+      // Arret juste apres la fermeture de "prices" : le ']' est refuse
+      CHECK(used == closing, "%s, morceaux <= %u : arret a %u au lieu de %u", path,
+            (unsigned)c, (unsigned)used, (unsigned)closing);
+      CHECK(dec.pairs() == refPairs, "%u paires au lieu de %u", (unsigned)dec.pairs(), (unsigned)refPairs);
+      float pts[CHART_POINTS];
+      int n = dec.finish(pts, CHART_POINTS);
+      CHECK(n == (int)ref.size(), "%d points au lieu de %u", n, (unsigned)ref.size());
+      for (int i = 0; i < n && i < (int)ref.size(); i++) {
+        CHECK(pts[i] == ref[i], "point %d : %.6f au lieu de %.6f", i, pts[i], ref[i]);
+      }
+    }
+  }
+
+  // Les extremes de la reponse survivent a la reduction
+  float lo = ref[0], hi = ref[0];
+  for (float v : ref) { if (v < lo) lo = v; if (v > hi) hi = v; }
+  CHECK(lo <= allLo && hi >= allHi, "extremes perdus : [%.2f, %.2f] / [%.2f, %.2f]", lo, hi, allLo, allHi);
+
+  printf("%s : %u octets, %u paires -> %u points ; decodeur %u octets (%.1f %% de la reponse)\n",
+         path, (unsigned)json.size(), (unsigned)refPairs, (unsigned)ref.size(),
+         (unsigned)sizeof(ChartStreamDecoder), 100.0 * sizeof(ChartStreamDecoder) / json.size());
+}
+
+static int decode(const char* json, float* pts) {
+  ChartStreamDecoder dec;
+  dec.begin(CHART_SPAN_MS);
+  for (const char* p = json; *p && dec.feed(*p); p++) {}
+  return dec.finished() ? dec.finish(pts, CHART_POINTS) : -1;
+}
+
+static void testSyntax() {
+  float pts[CHART_POINTS];
+  // "prices" imbrique ou dans une valeur : ignore ; le vrai vient apres
+  int n = decode("{\"meta\":{\"prices\":[[0,9]]},\"note\":\"\\\"prices\\\" [\",\"prices\":[[0,1.5],[1000,2.5]]}", pts);
+  CHECK(n == 2 && pts[0] == 1.5f && pts[1] == 2.5f, "cle imbriquee : n=%d", n);
+  // "prices" en valeur : la cle suivante n'est pas prise pour "prices"
+  n = decode("{\"name\":\"prices\",\"b\":[[0,9]],\"prices\":[[0,1.5],[1000,2.5]]}", pts);
+  CHECK(n == 2 && pts[0] == 1.5f, "valeur \"prices\" : n=%d", n);
+  // Exposants (petites cryptos) et espaces
+  n = decode("{ \"prices\" : [ [ 0 , 1.5e-05 ] , [ 1000 , 2.5E-5 ] ] }", pts);
+  CHECK(n == 2 && pts[0] == 1.5e-05f && pts[1] == 2.5e-05f, "exposants : n=%d", n);
+  // Cle trop longue qui commence par "prices"
+  n = decode("{\"prices_and_more_than_16\":[[0,1]],\"prices\":[[0,3],[1,4]]}", pts);
+  CHECK(n == 2 && pts[0] == 3.0f, "cle longue : n=%d", n);
+  // Tableau vide, puis pas de "prices" du tout
+  CHECK(decode("{\"prices\":[]}", pts) == 0, "tableau vide");
+  CHECK(decode("{\"error\":\"coin not found\"}", pts) == -1, "reponse d'erreur acceptee");
+}
+
+int main(int argc, char** argv) {
+  testResponse(argc > 1 ? argv[1] : "market_chart_7d.json");
+  testSyntax();
+  return hostTestEnd();
+}
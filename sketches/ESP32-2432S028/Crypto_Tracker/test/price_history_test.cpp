@@ -0,0 +1,269 @@
+/*
+ * price_history_test.cpp - Test PC de l'historique en bougies (price_history.h)
+ *
+ * Agregation : une journee de ticks dans l'ordre, avec des trous de
+ * quelques minutes a plus d'une heure ; chaque bougie 15 min doit etre le
+ * regroupement des bougies 1 min qu'elle couvre, chaque bougie 1 h celui
+ * des bougies 15 min. Ticks en desordre : chaque bougie est comparee a un
+ * modele calcule sur les ticks bruts (ouverture = premier arrive, cloture
+ * = le plus recent, meches = tous les ticks gardes, tick d'une bougie
+ * deja close = perdu). Verifie aussi l'aller-retour du prix en virgule
+ * fixe logarithmique et l'empreinte annoncee (2,6 Ko par crypto).
+ *
+ *   g++ -std=c++11 -Wall -I.. -I../../../common price_history_test.cpp -o /tmp/price_history_test && /tmp/price_history_test
+ */
+
+#include <math.h>
+#include <map>
+#include <vector>
+#include "host_test.h"
+#include "price_history.h"
+
+// 3 anneaux de bougies de 8 octets + ref, ticks, lastS et l'en-tete de
+// chaque anneau. 6 cryptos = 15,8 Ko dans Crypto_Tracker.ino.
+static_assert(sizeof(Candle) == 8, "Candle annoncee a 8 octets");
+static_assert(sizeof(PriceHistory) == (60 + 96 + 168) * sizeof(Candle) + 3 * 8 + 12,
+              "PriceHistory != 2628 octets");
+
+static uint32_t rngState = 4242;
+static uint32_t rnd() {
+  rngState = rngState * 1103515245u + 12345u;
+  return rngState >> 8;
+}
+
+static bool sameCandle(const Candle* a, const Candle* b) {
+  if (!a || !b) return a == b;
+  return a->o == b->o && a->h == b->h && a->l == b->l && a->c == b->c;
+}
+
+// Regroupe les bougies [s0, s1) d'un anneau fin ; faux si aucune
+template <class Ring>
+static bool rollup(const Ring& r, uint32_t s0, uint32_t s1, Candle& out) {
+  bool any = false;
+  for (uint32_t s = s0; s < s1; s++) {
+    const Candle* c = r.find(s);
+    if (!c) continue;
+    if (!any) out = *c;
+    if (c->h > out.h) out.h = c->h;
+    if (c->l < out.l) out.l = c->l;
+    out.c = c->c;
+    any = true;
+  }
+  return any;
+}
+
+// Compare chaque bougie d'un anneau grossier au regroupement des bougies
+// fines qu'elle couvre, sur la partie commune aux deux anneaux
+template <class Coarse, class Fine>
+static void checkRollup(const char* name, const Coarse& coarse, uint32_t coarseS,
+                        const Fine& fine, uint32_t fineS, int fineN) {
+  uint32_t ratio = coarseS / fineS;
+  uint32_t firstFine = fine.lastSlot + 1 - fineN;
+  int compared = 0;
+  for (uint32_t s = coarse.lastSlot; s * ratio >= firstFine; s--) {
+    Candle r;
+    bool any = rollup(fine, s * ratio, (s + 1) * ratio, r);
+    const Candle* c = coarse.find(s);
+    CHECK(sameCandle(c, any ? &r : nullptr), "%s slot %u : %d/%d/%d/%d au lieu de %d/%d/%d/%d", name,
+          (unsigned)s, c ? c->o : 0, c ? c->h : 0, c ? c->l : 0, c ? c->c : 0,
+          any ? r.o : 0, any ? r.h : 0, any ? r.l : 0, any ? r.c : 0);
+    compared++;
+    if (s == 0) break;
+  }
+  CHECK(compared >= 4, "%s : %d bougies comparees", name, compared);
+}
+
+static void testRollup() {
+  PriceHistory h;
+  h.clear();
+  // 26 h de ticks toutes les 5..40 s, marche aleatoire autour de 60000,
+  // avec des trous : 7 min, 50 min et 2 h (vide tout l'anneau 1 min)
+  uint32_t t = 100;
+  float price = 60000;
+  while (t < 26 * 3600) {
+    h.add(t, price);
+    price *= 1 + ((int)(rnd() % 2001) - 1000) / 200000.0f;
+    t += 5 + rnd() % 36;
+    if (t / 60 == 200) t += 7 * 60;
+    if (t / 60 == 900) t += 50 * 60;
+  }
+  uint32_t before = h.lastS;
+  uint32_t resume = t + 2 * 3600;
+  t = resume;
+  for (int i = 0; i < 300; i++) {   // 85 min
+    h.add(t, price);
+    price *= 1.0005f;
+    t += 17;
+  }
+
+  // L'anneau 1 min a ete vide par le trou de 2 h, les autres non
+  CHECK(h.m1.count == 60 && h.m1.find(resume / 60 + 40), "m1 : %u bougies", h.m1.count);
+  CHECK(!h.m1.find(before / 60), "m1 : bougie d'avant le trou de 2 h encore presente");
+  CHECK(h.m15.count == 96 && h.h1.count == h.lastS / 3600 + 1, "m15 %u, h1 %u bougies",
+        h.m15.count, h.h1.count);
+  // Le trou de 2 h laisse des bougies 15 min vides, pas d'ouverture inventee
+  int empty = 0, gap = resume / 900 - before / 900 - 1;
+  for (uint32_t s = before / 900 + 1; s < resume / 900; s++) empty += !h.m15.find(s);
+  CHECK(gap >= 7 && empty == gap, "m15 : %d bougies vides sur %d dans le trou", empty, gap);
+
+  checkRollup("15 min <- 1 min", h.m15, 900, h.m1, 60, h.m1.count);
+  checkRollup("1 h <- 15 min", h.h1, 3600, h.m15, 900, 96);
+
+  // Sans trou qui vide l'anneau 1 min, et sur une petite crypto
+  PriceHistory g;
+  g.clear();
+  rngState = 7;
+  price = 0.42f;   // petite crypto : meme precision relative
+  for (uint32_t s = 3000; s < 3000 + 5 * 3600; s += 3 + rnd() % 50) {
+    if (s / 60 % 97 < 3) continue;   // quelques minutes sans tick
+    g.add(s, price);
+    price *= 1 + ((int)(rnd() % 2001) - 1000) / 100000.0f;
+  }
+  checkRollup("petite crypto 15 min <- 1 min", g.m15, 900, g.m1, 60, 60);
+  checkRollup("petite crypto 1 h <- 15 min", g.h1, 3600, g.m15, 900, g.m15.count);
+
+  // Les vues restituent les extremes des meches
+  float pts[PH_MAX_POINTS], lo, hi;
+  int n = g.series(HIST_24H, 3000 + 5 * 3600, pts, 48, lo, hi);
+  Candle all;
+  rollup(g.m15, 0, g.m15.lastSlot + 1, all);
+  CHECK(n == 48, "vue 24 h : %d points", n);
+  CHECK(lo == g.decode(all.l) && hi == g.decode(all.h), "vue 24 h : [%g, %g] au lieu de [%g, %g]",
+        lo, hi, g.decode(all.l), g.decode(all.h));
+}
+
+// Modele : bougies calculees sur les ticks bruts dans l'ordre d'arrivee
+struct ModelCandle {
+  int16_t o, h, l, c;
+  uint32_t closeT;
+};
+
+static void modelAdd(std::map<uint32_t, ModelCandle>& m, uint32_t& lastSlot, bool& any,
+                     uint32_t period, uint32_t t, int16_t v) {
+  uint32_t slot = t / period;
+  if (any && slot < lastSlot) return;   // bougie close
+  auto it = m.find(slot);
+  if (it == m.end()) {
+    m[slot] = {v, v, v, v, t};
+  } else {
+    ModelCandle& c = it->second;
+    if (v > c.h) c.h = v;
+    if (v < c.l) c.l = v;
+    if (t >= c.closeT) { c.c = v; c.closeT = t; }
+  }
+  lastSlot = slot;
+  any = true;
+}
+
+template <class Ring>
+static void checkModel(const char* name, const Ring& r, int n, const std::map<uint32_t, ModelCandle>& m) {
+  int nonEmpty = 0;
+  for (uint32_t k = 0; k < (uint32_t)n && k <= r.lastSlot; k++) {
+    uint32_t s = r.lastSlot - k;
+    auto it = m.find(s);
+    Candle ref;
+    if (it != m.end()) ref = {it->second.o, it->second.h, it->second.l, it->second.c};
+    const Candle* c = r.find(s);
+    CHECK(sameCandle(c, it != m.end() ? &ref : nullptr), "%s slot %u : %d/%d/%d/%d au lieu de %d/%d/%d/%d",
+          name, (unsigned)s, c ? c->o : 0, c ? c->h : 0, c ? c->l : 0, c ? c->c : 0,
+          ref.o, ref.h, ref.l, ref.c);
+    nonEmpty += c != nullptr;
+  }
+  CHECK(nonEmpty > 0, "%s : aucune bougie", name);
+}
+
+static void testOutOfOrder() {
+  // Ticks horodates tous les 10..30 s, livres avec un retard aleatoire
+  // (0..90 s, files REST et WebSocket independantes) : desordre a
+  // l'interieur d'une bougie et a cheval sur deux
+  std::vector<std::pair<uint32_t, float>> ticks;
+  uint32_t t = 500;
+  float price = 2500;
+  for (int i = 0; i < 3000; i++) {
+    ticks.push_back({t, price});
+    price *= 1 + ((int)(rnd() % 2001) - 1000) / 100000.0f;
+    t += 10 + rnd() % 21;
+  }
+  for (size_t i = 0; i + 1 < ticks.size(); i++) {
+    size_t j = i + rnd() % 4;
+    if (j < ticks.size() && ticks[j].first - ticks[i].first <= 90) std::swap(ticks[i], ticks[j]);
+  }
+
+  PriceHistory h;
+  h.clear();
+  std::map<uint32_t, ModelCandle> m1, m15, h1;
+  uint32_t l1 = 0, l15 = 0, l60 = 0;
+  bool a1 = false, a15 = false, a60 = false;
+  int late = 0;
+  uint32_t newest = 0;
+  for (auto& tk : ticks) {
+    h.add(tk.first, tk.second);
+    int16_t v = h.encode(tk.second);
+    modelAdd(m1, l1, a1, 60, tk.first, v);
+    modelAdd(m15, l15, a15, 900, tk.first, v);
+    modelAdd(h1, l60, a60, 3600, tk.first, v);
+    late += tk.first < newest;
+    if (tk.first > newest) newest = tk.first;
+  }
+  CHECK(late > 300, "seulement %d ticks en retard", late);
+  CHECK(h.lastS == newest, "lastS %u au lieu de %u", (unsigned)h.lastS, (unsigned)newest);
+  checkModel("desordre 1 min", h.m1, 60, m1);
+  checkModel("desordre 15 min", h.m15, 96, m15);
+  checkModel("desordre 1 h", h.h1, 168, h1);
+
+  // Cas simple : un tick en retard dans la bougie en cours elargit la
+  // meche sans devenir la cloture, dans une bougie close il est perdu
+  PriceHistory s;
+  s.clear();
+  s.add(120, 100.0f);
+  s.add(150, 101.0f);
+  s.add(130, 90.0f);   // en retard, meme minute
+  const Candle* c = s.m1.find(2);
+  CHECK(c && c->l == s.encode(90.0f) && c->c == s.encode(101.0f), "retard dans la bougie en cours");
+  s.add(185, 102.0f);
+  s.add(170, 80.0f);   // en retard, minute 2 close
+  c = s.m1.find(2);
+  CHECK(c && c->l == s.encode(90.0f), "retard dans une bougie close compte");
+  c = s.m15.find(0);
+  CHECK(c && c->l == s.encode(80.0f) && c->c == s.encode(102.0f), "15 min : retard mal agrege");
+}
+
+static void testEncoding() {
+  PriceHistory h;
+  h.clear();
+  h.add(0, 1234.5f);
+  CHECK(h.encode(1234.5f) == 0, "ref -> code %d", h.encode(1234.5f));
+
+  // Aller-retour : pas de 0,01 %, erreur <= un demi-pas sur toute la plage
+  double worst = 0;
+  int16_t prev = INT16_MIN;
+  for (double k = 1 / 26.0; k <= 26.0; k *= 1.0003) {
+    float p = (float)(1234.5 * k);
+    int16_t code = h.encode(p);
+    double err = fabs(h.decode(code) - p) / p;
+    if (err > worst) worst = err;
+    CHECK(code >= prev, "ordre perdu a %g : %d < %d", p, code, prev);
+    CHECK(code != PH_EMPTY, "%g code en PH_EMPTY", p);
+    prev = code;
+  }
+  CHECK(worst <= 0.5 / PH_SCALE * 1.01, "erreur aller-retour %.5f %%", worst * 100);
+  printf("aller-retour ref/26 .. ref*26 : erreur max %.5f %% (demi-pas %.3f %%)\n",
+         worst * 100, 50.0 / PH_SCALE);
+
+  // Hors plage : ecrete, jamais PH_EMPTY ; prix nul ou negatif ignore
+  CHECK(h.encode(1234.5f * 1000) == INT16_MAX, "haut %d", h.encode(1234.5f * 1000));
+  CHECK(h.encode(1234.5f / 1000) == -INT16_MAX, "bas %d", h.encode(1234.5f / 1000));
+  uint32_t ticks = h.ticks;
+  h.add(10, 0.0f);
+  h.add(10, -1.0f);
+  h.add(10, NAN);
+  CHECK(h.ticks == ticks, "prix invalide compte");
+}
+
+int main() {
+  testRollup();
+  testOutOfOrder();
+  testEncoding();
+  printf("PriceHistory : %u octets par crypto\n", (unsigned)sizeof(PriceHistory));
+  return hostTestEnd();
+}
@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+#
+# Stand-in local du flux miniTicker Binance pour le mode PRICE_STREAMING
+#
+# Envoie des messages au format du flux combine (un par paire et par
+# seconde, marche aleatoire autour d'un prix de depart). Dans le sketch :
+#   #define PRICE_STREAMING 1
+#   #define WS_HOST "<ip du PC>"   #define WS_PORT 8765   #define WS_TLS 0
+#
+# Usage : pip install websockets && ./ticker_standin.py [port] [intervalle_s]
+# Couper le script pour verifier le retour au polling REST.
+#
+
+import asyncio
+import json
+import random
+import sys
+
+import websockets
+
+PAIRS = {"BTCUSDT": 67000.0, "ETHUSDT": 3500.0, "SOLUSDT": 150.0,
+         "ADAUSDT": 0.45, "XRPUSDT": 0.52, "DOGEUSDT": 0.15}
+
+
+async def feed(ws, path=None):
+    opens = dict(PAIRS)
+    prices = dict(PAIRS)
+    print("client connecte")
+    try:
+        while True:
+            for pair in prices:
+                prices[pair] *= 1 + random.uniform(-0.002, 0.002)
+                msg = {"stream": pair.lower() + "@miniTicker",
+                       "data": {"e": "24hrMiniTicker", "s": pair,
+                                "c": "%.8g" % prices[pair], "o": "%.8g" % opens[pair]}}
+                await ws.send(json.dumps(msg))
+            await asyncio.sleep(INTERVAL)
+    except websockets.ConnectionClosed:
+        print("client deconnecte")
+
+
+async def main(port):
+    async with websockets.serve(feed, "0.0.0.0", port):
+        print("stand-in miniTicker sur ws://0.0.0.0:%d" % port)
+        await asyncio.Future()
+
+
+if __name__ == "__main__":
+    port = int(sys.argv[1]) if len(sys.argv) > 1 else 8765
+    INTERVAL = float(sys.argv[2]) if len(sys.argv) > 2 else 1.0
+    asyncio.run(main(port))
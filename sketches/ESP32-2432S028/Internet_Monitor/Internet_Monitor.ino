@@ -5,20 +5,31 @@
  * (WiFi / Box / Internet / DNS), affichage TFT permanent et
  * alerte sonore avec boutons silence tactiles.
  *
+ * Journal des transitions persistant en LittleFS, exportable via
+ * la commande serie 'j' ou http://<ip>/journal.bin (journal_decode.py).
+ * Metriques Prometheus sur http://<ip>/metrics.
+ *
  * Board: ESP32 Dev Module (CYD)
  * FQBN: esp32:esp32:esp32
  *
- * @dependencies TFT_eSPI, XPT2046_Touchscreen, ESP32Ping
+ * @dependencies TFT_eSPI, XPT2046_Touchscreen
  */
 
 #include <WiFi.h>
-#include <ESP32Ping.h>
 #include <time.h>
 #include <SPI.h>
 #include <TFT_eSPI.h>
 #include <XPT2046_Touchscreen.h>
 #include <esp_task_wdt.h>
+#include <LittleFS.h>
+#include <WebServer.h>
+#include "ping/ping_sock.h"
 #include "credentials.h"
+#include "cascade.h"
+#include "latency_stats.h"
+#include "journal.h"
+#include "sliding_max.h"
+#include "metrics.h"
 
 #define WDT_TIMEOUT_S 30
 #define QUIET_START_MIN (21 * 60)        // 21h00
@@ -47,11 +58,38 @@ struct Rect { int x, y, w, h; };
 #define COLOR_UNKNOWN  0x6B4D   // gris
 
 #define CHECK_INTERVAL_MS 5000
+#define PING_TIMEOUT_MS   1000
+#define PROBE_BURST       4      // paquets par cible et par cycle
+#define PROBE_BURST_GAP_MS 250   // intervalle entre paquets d'une rafale
+#define DNS_TIMEOUT_MS    2000
 #define SPEAKER_PIN 26
 #define DNS_TARGET "cloudflare.com"
 #define NTP_SERVER "pool.ntp.org"
 #define TZ_PARIS "CET-1CEST,M3.5.0,M10.5.0/3"
-const IPAddress INTERNET_TARGET(8, 8, 8, 8);
+
+// Cibles ICMP : la passerelle est resolue a chaque cycle, les deux cibles
+// Internet sont agregees dans la couche "Net" (une seule suffit pour OK).
+enum ProbeId { PROBE_GW, PROBE_NET1, PROBE_NET2, PROBE_COUNT };
+const IPAddress INTERNET_TARGETS[] = { IPAddress(8, 8, 8, 8), IPAddress(1, 1, 1, 1) };
+
+struct PingProbe {
+  esp_ping_handle_t hdl;
+  volatile uint8_t n;              // paquets traites dans la rafale
+  int16_t samples[PROBE_BURST];    // ms, -1 = perdu
+};
+
+// Cycle publie : verdicts pour la cascade + echantillons bruts pour les stats
+struct ProbeCycle {
+  ProbeResults res;
+  int16_t samples[PROBE_COUNT][PROBE_BURST];
+};
+
+// Stats par couche, alimentees par chaque paquet des rafales
+LatencyStats netStats;   // 8.8.8.8 + 1.1.1.1
+LatencyStats gwStats;    // passerelle
+LatWindowId statsWindow = LAT_WIN_1M;
+const char* latWindowNames[] = {"1m ", "1h ", "24h"};
+int16_t lastSample[PROBE_COUNT] = {-1, -1, -1};   // pour la gigue
 
 unsigned long alarmNextStepMs = 0;
 int alarmFreqIdx = 0;
@@ -87,22 +125,19 @@ const Rect btn5min   = {6,   206, 100, 32};
 const Rect btn30min  = {110, 206, 100, 32};
 const Rect btnPerm   = {214, 206, 100, 32};
 const Rect bandeau   = {6,   206, 308, 32};
+const Rect statsZone = {6,   124, 308, 74};   // tap = fenetre stats suivante
 
 bool inRect(int x, int y, Rect r) {
   return x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h;
 }
 
-enum State { ST_CHECKING, ST_OK, ST_WIFI_DOWN, ST_LAN_DOWN, ST_INTERNET_DOWN, ST_DNS_DOWN };
-const char* stateNames[] = {"CHECKING", "OK", "WIFI_DOWN", "LAN_DOWN", "INTERNET_DOWN", "DNS_DOWN"};
-
-State currentState = ST_CHECKING;
+CascadeState cascade;
 State previousState = ST_CHECKING;
-int wifiFail = 0, lanFail = 0, inetFail = 0, dnsFail = 0;
-bool wifiDown = false, lanDown = false, inetDown = false, dnsDown = false;
-int gwLatency = 0, inetLatency = 0, dnsLatency = 0;
 
 unsigned long bootMs = 0;
+unsigned long stateSinceMs = 0;
 unsigned long totalDowntimeMs = 0;
+uint32_t outageCount = 0;
 time_t outageStartEpoch = 0;
 unsigned long outageStartMs = 0;
 time_t lastOutageStartEpoch = 0;
@@ -112,9 +147,11 @@ unsigned long lastOutageDurationS = 0;
 int16_t latencyHistory[LATENCY_HISTORY_SIZE];
 int latencyHead = 0;
 bool latencyFull = false;
+SlidingMax<LATENCY_HISTORY_SIZE> latencyMax;
 
 void pushLatency(int16_t v) {
   latencyHistory[latencyHead] = v;
+  latencyMax.push(v);
   latencyHead = (latencyHead + 1) % LATENCY_HISTORY_SIZE;
   if (latencyHead == 0) latencyFull = true;
 }
@@ -192,16 +229,17 @@ void drawCascade() {
   if (wifi_ok) snprintf(wifiDet, sizeof(wifiDet), "%s %ddBm",
                         WiFi.SSID().c_str(), WiFi.RSSI());
   else snprintf(wifiDet, sizeof(wifiDet), "disconnected");
-  drawCascadeRow(28, "WiFi", wifi_ok && !wifiDown, true, wifiDet, 0);
+  drawCascadeRow(28, "WiFi", wifi_ok && !cascade.wifiDown, true, wifiDet, 0);
 
   String gw = WiFi.gatewayIP().toString();
-  drawCascadeRow(50, "Box ", !lanDown, wifi_ok, gw.c_str(), gwLatency);
+  drawCascadeRow(50, "Box ", !cascade.lanDown, wifi_ok, gw.c_str(), cascade.gwLatency);
 
-  drawCascadeRow(72, "Net ", !inetDown, !lanDown && wifi_ok,
-                 "8.8.8.8", inetLatency);
+  drawCascadeRow(72, "Net ", !cascade.inetDown, !cascade.lanDown && wifi_ok,
+                 "8.8.8.8 / 1.1.1.1", cascade.inetLatency);
 
-  drawCascadeRow(94, "DNS ", !dnsDown, !inetDown && !lanDown && wifi_ok,
-                 DNS_TARGET, dnsLatency);
+  drawCascadeRow(94, "DNS ", !cascade.dnsDown,
+                 !cascade.inetDown && !cascade.lanDown && wifi_ok,
+                 DNS_TARGET, cascade.dnsLatency);
 }
 
 void drawButton(Rect r, const char* label, uint16_t color) {
@@ -263,6 +301,11 @@ void handleTouch() {
   mapTouch(p.x, p.y, sx, sy);
   Serial.printf("TAP raw=(%d,%d) screen=(%d,%d)\n", p.x, p.y, sx, sy);
 
+  if (inRect(sx, sy, statsZone)) {
+    statsWindow = (LatWindowId)((statsWindow + 1) % LAT_WIN_COUNT);
+    return;
+  }
+
   if (isSilenced()) {
     if (inRect(sx, sy, bandeau)) clearSilence();
   } else {
@@ -274,6 +317,58 @@ void handleTouch() {
 
 int graphLastDrawnHead = -1;
 
+// Graphe latence : zone utile 306x48 en (7,149), une barre par echantillon
+#define GRAPH_X    7
+#define GRAPH_Y    149
+#define GRAPH_H    48
+#define GRAPH_BAR_W (308 / LATENCY_HISTORY_SIZE)
+
+uint8_t  graphColH[LATENCY_HISTORY_SIZE];       // barre actuellement affichee
+uint16_t graphColColor[LATENCY_HISTORY_SIZE];
+uint32_t graphSpiBytes = 0;       // octets SPI estimes pour la mise a jour en cours
+uint32_t graphLastSpiBytes = 0;   // ... et pour la precedente (log serie)
+
+// fillRect = CASET + PASET + RAMWR (11 octets) + 2 octets par pixel
+void graphFill(int x, int y, int w, int h, uint16_t color) {
+  if (h <= 0) return;
+  tft.fillRect(x, y, w, h, color);
+  graphSpiBytes += 11 + (uint32_t)w * h * 2;
+}
+
+void drawGraphColumn(int i, uint8_t h, uint16_t color) {
+  uint8_t oldH = graphColH[i];
+  uint16_t oldColor = graphColColor[i];
+  if (h == oldH && (color == oldColor || h == 0)) return;
+
+  int x = GRAPH_X + i * GRAPH_BAR_W;
+  int bottom = GRAPH_Y + GRAPH_H;
+  if (color != oldColor && h > 0 && oldH > 0) {
+    // Changement de couleur : barre entiere + reste de l'ancienne
+    graphFill(x, bottom - h, GRAPH_BAR_W, h, color);
+    if (oldH > h) graphFill(x, bottom - oldH, GRAPH_BAR_W, oldH - h, COLOR_BG);
+  } else if (h > oldH) {
+    graphFill(x, bottom - h, GRAPH_BAR_W, h - oldH, color);
+  } else {
+    graphFill(x, bottom - oldH, GRAPH_BAR_W, oldH - h, COLOR_BG);
+  }
+  graphColH[i] = h;
+  graphColColor[i] = color;
+}
+
+uint32_t statsNowS() { return (millis() - bootMs) / 1000; }
+
+// Une reponse ecartee par une perte ne compte pas dans la gigue
+void recordSamples(ProbeId id, const int16_t* samples) {
+  LatencyStats& st = (id == PROBE_GW) ? gwStats : netStats;
+  uint32_t t = statsNowS();
+  for (int i = 0; i < PROBE_BURST; i++) {
+    int16_t v = samples[i];
+    st.add(t, v);
+    if (v >= 0 && lastSample[id] >= 0) st.addJitter(t, abs(v - lastSample[id]));
+    lastSample[id] = v;
+  }
+}
+
 void drawStats() {
   tft.setTextColor(COLOR_TEXT, COLOR_BG);
   tft.setTextDatum(TL_DATUM);
@@ -294,6 +389,19 @@ void drawStats() {
   }
   tft.setTextPadding(180);
   tft.drawString(buf, 140, 124, 2);
+
+  // Ligne quantiles (police 1, 8px) entre le texte et le cadre du graphe
+  uint32_t t = statsNowS();
+  LatSummary net = netStats.summary(statsWindow, t);
+  LatSummary box = gwStats.summary(statsWindow, t);
+  int n = snprintf(buf, sizeof(buf), "%s Net ", latWindowNames[statsWindow]);
+  if (net.sent) n += snprintf(buf + n, sizeof(buf) - n, "%u/%u/%ums j%u %.1f%%",
+                              net.p50, net.p95, net.p99, net.jitter, net.lossPct);
+  else n += snprintf(buf + n, sizeof(buf) - n, "--");
+  if (box.sent) snprintf(buf + n, sizeof(buf) - n, "  Box %u/%u/%ums %.1f%%",
+                         box.p50, box.p95, box.p99, box.lossPct);
+  tft.setTextPadding(308);
+  tft.drawString(buf, 6, 140, 1);
   tft.setTextPadding(0);
 
   // Cadre graphe (zone 6..314 x 148..198) - dessine une fois
@@ -307,30 +415,29 @@ void drawStats() {
   if (graphLastDrawnHead == latencyHead) return;
   graphLastDrawnHead = latencyHead;
 
-  // Effacement et redessin complet (1x toutes les 5s a chaque check)
-  tft.fillRect(7, 149, 306, 48, COLOR_BG);
-  int barWidth = 308 / LATENCY_HISTORY_SIZE;
-  int graphH = 48;
-
-  int maxLat = 50;
-  for (int i = 0; i < LATENCY_HISTORY_SIZE; i++) {
-    if (latencyHistory[i] > maxLat) maxLat = latencyHistory[i];
-  }
-
+  // Rendu differentiel : chaque colonne ne repeint que l'ecart entre la
+  // barre affichee et la nouvelle (defilement = decalage d'un cran).
+  graphSpiBytes = 0;
+  int maxLat = latencyMax.max(50);
   int startIdx = latencyFull ? latencyHead : 0;
   int count = latencyFull ? LATENCY_HISTORY_SIZE : latencyHead;
-  for (int i = 0; i < count; i++) {
-    int idx = (startIdx + i) % LATENCY_HISTORY_SIZE;
-    int16_t v = latencyHistory[idx];
-    int x = 7 + i * barWidth;
-    if (v < 0) {
-      tft.fillRect(x, 149, barWidth, graphH, COLOR_KO);
-    } else if (v > 0) {
-      int h = (v * graphH) / maxLat;
-      if (h < 1) h = 1;
-      tft.fillRect(x, 149 + (graphH - h), barWidth, h, COLOR_OK);
+  for (int i = 0; i < LATENCY_HISTORY_SIZE; i++) {
+    uint8_t h = 0;
+    uint16_t color = COLOR_BG;
+    if (i < count) {
+      int16_t v = latencyHistory[(startIdx + i) % LATENCY_HISTORY_SIZE];
+      if (v < 0) {
+        h = GRAPH_H;
+        color = COLOR_KO;
+      } else if (v > 0) {
+        int bh = (v * GRAPH_H) / maxLat;
+        h = (bh < 1) ? 1 : bh;
+        color = COLOR_OK;
+      }
     }
+    drawGraphColumn(i, h, color);
   }
+  graphLastSpiBytes = graphSpiBytes;
 }
 
 State headerLastState = ST_CHECKING;
@@ -376,20 +483,20 @@ void drawHeader() {
   tft.setTextPadding(0);
 
   // Badge etat - redraw seulement sur changement
-  if (currentState != headerLastState) {
-    uint16_t color = (currentState == ST_OK) ? COLOR_OK :
-                     (currentState == ST_CHECKING) ? COLOR_UNKNOWN : COLOR_KO;
+  if (cascade.state != headerLastState) {
+    uint16_t color = (cascade.state == ST_OK) ? COLOR_OK :
+                     (cascade.state == ST_CHECKING) ? COLOR_UNKNOWN : COLOR_KO;
     const char* label =
-      (currentState == ST_OK)            ? "OK"   :
-      (currentState == ST_CHECKING)      ? "..."  :
-      (currentState == ST_WIFI_DOWN)     ? "WIFI" :
-      (currentState == ST_LAN_DOWN)      ? "BOX"  :
-      (currentState == ST_INTERNET_DOWN) ? "NET"  : "DNS";
+      (cascade.state == ST_OK)            ? "OK"   :
+      (cascade.state == ST_CHECKING)      ? "..."  :
+      (cascade.state == ST_WIFI_DOWN)     ? "WIFI" :
+      (cascade.state == ST_LAN_DOWN)      ? "BOX"  :
+      (cascade.state == ST_INTERNET_DOWN) ? "NET"  : "DNS";
     tft.fillRoundRect(265, 2, 50, 20, 4, color);
     tft.setTextColor(COLOR_TEXT, color);
     tft.setTextDatum(MC_DATUM);
     tft.drawString(label, 290, 12, 2);
-    headerLastState = currentState;
+    headerLastState = cascade.state;
   }
 }
 
@@ -398,73 +505,330 @@ float uptimePct() {
   unsigned long total = now - bootMs;
   if (total == 0) return 100.0f;
   unsigned long down = totalDowntimeMs;
-  if (currentState != ST_OK && currentState != ST_CHECKING) {
+  if (cascade.state != ST_OK && cascade.state != ST_CHECKING) {
     down += now - outageStartMs;
   }
   if (down > total) down = total;
   return 100.0f * (total - down) / total;
 }
 
-void checkCascade() {
-  // Layer 1 : WiFi
-  bool wifi_ok = (WiFi.status() == WL_CONNECTED);
-  if (wifi_ok) { wifiFail = 0; wifiDown = false; }
-  else {
-    wifiFail++;
-    if (wifiFail >= 2) wifiDown = true;
-    WiFi.reconnect();
-  }
-
-  // Layer 2 : Gateway
-  bool lan_ok = false;
-  if (wifi_ok) {
-    lan_ok = Ping.ping(WiFi.gatewayIP(), 1);
-    if (lan_ok) {
-      lanFail = 0; lanDown = false;
-      gwLatency = (int)Ping.averageTime();
-    } else {
-      lanFail++;
-      if (lanFail >= 2) lanDown = true;
+// --- Moteur de sondes asynchrone ---
+// Tache dediee (core 0) : une rafale de PROBE_BURST pings par cible, les
+// trois cibles en parallele via esp_ping (une session lwIP par cible,
+// timeout individuel), resolution DNS pendant ce temps. Le cycle complet
+// est publie d'un bloc sous spinlock : la loop UI ne bloque plus jamais
+// sur le reseau.
+
+EventGroupHandle_t probeEvents = nullptr;
+PingProbe probes[PROBE_COUNT];
+
+portMUX_TYPE probeMux = portMUX_INITIALIZER_UNLOCKED;
+ProbeCycle probeShared;
+uint32_t probeSeq = 0;       // incremente a chaque cycle publie
+uint32_t probeSeqSeen = 0;   // dernier cycle consomme par la loop
+
+void onPingSuccess(esp_ping_handle_t hdl, void* args) {
+  PingProbe* p = (PingProbe*)args;
+  uint32_t ms = 0;
+  esp_ping_get_profile(hdl, ESP_PING_PROF_TIMEGAP, &ms, sizeof(ms));
+  if (p->n < PROBE_BURST) p->samples[p->n++] = (ms > INT16_MAX) ? INT16_MAX : (int16_t)ms;
+}
+
+void onPingTimeout(esp_ping_handle_t hdl, void* args) {
+  PingProbe* p = (PingProbe*)args;
+  if (p->n < PROBE_BURST) p->samples[p->n++] = -1;
+}
+
+void onPingEnd(esp_ping_handle_t hdl, void* args) {
+  PingProbe* p = (PingProbe*)args;
+  xEventGroupSetBits(probeEvents, BIT(p - probes));
+}
+
+bool startPing(PingProbe& p, const IPAddress& target) {
+  p.n = 0;
+  p.hdl = nullptr;
+  for (int i = 0; i < PROBE_BURST; i++) p.samples[i] = -1;
+
+  esp_ping_config_t cfg = ESP_PING_DEFAULT_CONFIG();
+  IP_ADDR4(&cfg.target_addr, target[0], target[1], target[2], target[3]);
+  cfg.count = PROBE_BURST;
+  cfg.timeout_ms = PING_TIMEOUT_MS;
+  cfg.interval_ms = PROBE_BURST_GAP_MS;
+
+  esp_ping_callbacks_t cbs = {};
+  cbs.cb_args = &p;
+  cbs.on_ping_success = onPingSuccess;
+  cbs.on_ping_timeout = onPingTimeout;
+  cbs.on_ping_end = onPingEnd;
+
+  if (esp_ping_new_session(&cfg, &cbs, &p.hdl) != ESP_OK) {
+    p.hdl = nullptr;
+    return false;
+  }
+  esp_ping_start(p.hdl);
+  return true;
+}
+
+void stopPing(PingProbe& p) {
+  if (!p.hdl) return;
+  esp_ping_stop(p.hdl);
+  esp_ping_delete_session(p.hdl);
+  p.hdl = nullptr;
+}
+
+// Moyenne des reponses de plusieurs rafales ; false si aucune reponse
+bool burstAverage(const int16_t (*samples)[PROBE_BURST], int from, int to, int& ms) {
+  int sum = 0, n = 0;
+  for (int id = from; id <= to; id++) {
+    for (int i = 0; i < PROBE_BURST; i++) {
+      if (samples[id][i] >= 0) { sum += samples[id][i]; n++; }
     }
   }
+  ms = n ? sum / n : 0;
+  return n > 0;
+}
+
+// hostByName n'a pas de timeout reglable : au-dela de DNS_TIMEOUT_MS la
+// reponse est consideree comme un echec.
+bool probeDns(int& ms) {
+  IPAddress resolved;
+  unsigned long t0 = millis();
+  bool ok = WiFi.hostByName(DNS_TARGET, resolved);
+  ms = (int)(millis() - t0);
+  return ok && ms <= DNS_TIMEOUT_MS;
+}
 
-  // Layer 3 : Internet
-  bool inet_ok = false;
-  if (lan_ok) {
-    inet_ok = Ping.ping(INTERNET_TARGET, 1);
-    if (inet_ok) {
-      inetFail = 0; inetDown = false;
-      inetLatency = (int)Ping.averageTime();
+void probeTask(void* arg) {
+  esp_task_wdt_add(NULL);
+  for (;;) {
+    unsigned long cycleStart = millis();
+    esp_task_wdt_reset();
+
+    ProbeCycle c = {};
+    ProbeResults& r = c.res;
+    for (int id = 0; id < PROBE_COUNT; id++) {
+      for (int i = 0; i < PROBE_BURST; i++) c.samples[id][i] = -1;
+    }
+
+    r.wifiOk = (WiFi.status() == WL_CONNECTED);
+    if (!r.wifiOk) {
+      WiFi.reconnect();
     } else {
-      inetFail++;
-      if (inetFail >= 2) inetDown = true;
+      xEventGroupClearBits(probeEvents, BIT(PROBE_COUNT) - 1);
+      EventBits_t pending = 0;
+      if (startPing(probes[PROBE_GW], WiFi.gatewayIP())) pending |= BIT(PROBE_GW);
+      if (startPing(probes[PROBE_NET1], INTERNET_TARGETS[0])) pending |= BIT(PROBE_NET1);
+      if (startPing(probes[PROBE_NET2], INTERNET_TARGETS[1])) pending |= BIT(PROBE_NET2);
+
+      r.dnsOk = probeDns(r.dnsMs);
+
+      if (pending) {
+        xEventGroupWaitBits(probeEvents, pending, pdTRUE, pdTRUE,
+                            pdMS_TO_TICKS(PROBE_BURST * PING_TIMEOUT_MS + 500));
+      }
+      for (int id = 0; id < PROBE_COUNT; id++) {
+        stopPing(probes[id]);
+        memcpy(c.samples[id], probes[id].samples, sizeof(c.samples[id]));
+      }
+      r.gwOk = burstAverage(c.samples, PROBE_GW, PROBE_GW, r.gwMs);
+      r.inetOk = burstAverage(c.samples, PROBE_NET1, PROBE_NET2, r.inetMs);
+    }
+
+    portENTER_CRITICAL(&probeMux);
+    probeShared = c;
+    probeSeq++;
+    portEXIT_CRITICAL(&probeMux);
+
+    unsigned long elapsed = millis() - cycleStart;
+    if (elapsed < CHECK_INTERVAL_MS) {
+      vTaskDelay(pdMS_TO_TICKS(CHECK_INTERVAL_MS - elapsed));
     }
   }
+}
 
-  // Layer 4 : DNS
-  bool dns_ok = false;
-  if (inet_ok) {
-    IPAddress resolved;
-    unsigned long t0 = millis();
-    dns_ok = WiFi.hostByName(DNS_TARGET, resolved);
-    if (dns_ok) {
-      dnsFail = 0; dnsDown = false;
-      dnsLatency = (int)(millis() - t0);
-    } else {
-      dnsFail++;
-      if (dnsFail >= 2) dnsDown = true;
+// Copie le dernier cycle publie s'il n'a pas encore ete consomme
+bool takeProbeCycle(ProbeCycle& out) {
+  bool fresh = false;
+  portENTER_CRITICAL(&probeMux);
+  if (probeSeq != probeSeqSeen) {
+    out = probeShared;
+    probeSeqSeen = probeSeq;
+    fresh = true;
+  }
+  portEXIT_CRITICAL(&probeMux);
+  return fresh;
+}
+
+// --- Journal persistant des transitions ---
+// Deux segments LittleFS : ajout en fin de JOURNAL_CUR (O(1)), et quand il
+// depasse JOURNAL_SEG_BYTES il devient JOURNAL_OLD (l'ancien est supprime).
+// LittleFS repartit lui-meme l'usure (copy-on-write). 2 x 4 Ko = ~340
+// transitions, soit plusieurs semaines d'historique en usage normal.
+
+#define JOURNAL_CUR       "/journal.bin"
+#define JOURNAL_OLD       "/journal.old"
+#define JOURNAL_SEG_BYTES 4096
+
+WebServer server(80);
+bool journalReady = false;
+uint16_t journalSeq = 0;
+
+bool epochValid(time_t t) { return t > 1700000000; }
+
+void journalAppend(JournalRecord& r) {
+  if (!journalReady) return;
+  r.seq = journalSeq++;
+  journalSeal(r);
+
+  File f = LittleFS.open(JOURNAL_CUR, FILE_APPEND);
+  if (!f) return;
+  f.write((const uint8_t*)&r, sizeof(r));
+  size_t size = f.size();
+  f.close();
+
+  if (size >= JOURNAL_SEG_BYTES) {
+    LittleFS.remove(JOURNAL_OLD);
+    LittleFS.rename(JOURNAL_CUR, JOURNAL_OLD);
+  }
+}
+
+void journalFill(JournalRecord& r, uint8_t type, uint8_t states, uint32_t durationS) {
+  time_t now = time(nullptr);
+  memset(&r, 0, sizeof(r));
+  r.epoch = epochValid(now) ? (uint32_t)now : 0;
+  r.uptimeS = (millis() - bootMs) / 1000;
+  r.durationS = durationS;
+  r.gwMs = cascade.gwLatency;
+  r.inetMs = cascade.inetLatency;
+  r.dnsMs = cascade.dnsLatency;
+  r.type = type;
+  r.states = states;
+  r.rssi = (WiFi.status() == WL_CONNECTED) ? WiFi.RSSI() : 0;
+}
+
+void journalTransition(State from, State to) {
+  JournalRecord r;
+  journalFill(r, JREC_TRANSITION, (from << 4) | to, (millis() - stateSinceMs) / 1000);
+  journalAppend(r);
+}
+
+void journalBoot() {
+  JournalRecord r;
+  journalFill(r, JREC_BOOT, (uint8_t)esp_reset_reason(), 0);
+  journalAppend(r);
+}
+
+// Relit les segments (ancien puis courant) : reprend le numero d'ordre et
+// la derniere coupure, perdus au reboot watchdog.
+void journalRestore() {
+  const char* paths[] = {JOURNAL_OLD, JOURNAL_CUR};
+  bool outStarted = false;
+  uint32_t outStartEpoch = 0;
+  uint32_t outStartUptimeS = 0;
+  for (const char* path : paths) {
+    File f = LittleFS.open(path, FILE_READ);
+    if (!f) continue;
+    JournalRecord r;
+    while (f.read((uint8_t*)&r, sizeof(r)) == sizeof(r)) {
+      if (!journalValid(r)) continue;
+      journalSeq = r.seq + 1;
+      if (r.type == JREC_BOOT) {
+        outStarted = false;     // comme a l'execution : pas de coupure a cheval sur un reboot
+        continue;
+      }
+      // Comme dans la loop : la coupure commence en quittant ST_OK, quels
+      // que soient les etats traverses ensuite (WIFI_DOWN -> LAN_DOWN -> OK)
+      if (journalFrom(r) == ST_OK && journalTo(r) != ST_OK) {
+        outStarted = true;
+        outStartEpoch = r.epoch;
+        outStartUptimeS = r.uptimeS;
+      } else if (journalTo(r) == ST_OK && journalFrom(r) != ST_CHECKING && outStarted) {
+        outStarted = false;
+        uint32_t durationS = r.uptimeS - outStartUptimeS;
+        if (outStartEpoch) lastOutageStartEpoch = outStartEpoch;
+        else if (r.epoch) lastOutageStartEpoch = r.epoch - durationS;
+        else continue;
+        lastOutageDurationS = durationS;
+      }
     }
+    f.close();
   }
+}
 
-  // Détermination de l'état (couche la plus haute en panne)
-  if (wifiDown) currentState = ST_WIFI_DOWN;
-  else if (lanDown) currentState = ST_LAN_DOWN;
-  else if (inetDown) currentState = ST_INTERNET_DOWN;
-  else if (dnsDown) currentState = ST_DNS_DOWN;
-  else currentState = ST_OK;
+void journalBegin() {
+  if (!LittleFS.begin(true)) {
+    Serial.println("LittleFS indisponible, journal desactive");
+    return;
+  }
+  journalReady = true;
+  journalRestore();
+  Serial.printf("Journal : seq %u, %u/%u octets\n", journalSeq,
+                LittleFS.usedBytes(), LittleFS.totalBytes());
+}
 
-  if (currentState == ST_OK) pushLatency(inetLatency);
-  else pushLatency(-1);
+// Export serie : une ligne "J <hex>" par enregistrement
+void journalDumpSerial() {
+  const char* paths[] = {JOURNAL_OLD, JOURNAL_CUR};
+  for (const char* path : paths) {
+    File f = LittleFS.open(path, FILE_READ);
+    if (!f) continue;
+    uint8_t rec[JOURNAL_RECORD_SIZE];
+    while (f.read(rec, sizeof(rec)) == sizeof(rec)) {
+      Serial.print("J ");
+      for (size_t i = 0; i < sizeof(rec); i++) Serial.printf("%02x", rec[i]);
+      Serial.println();
+      esp_task_wdt_reset();
+    }
+    f.close();
+  }
+  Serial.println("J END");
+}
+
+void handleJournal() {
+  File fo = LittleFS.open(JOURNAL_OLD, FILE_READ);
+  File fc = LittleFS.open(JOURNAL_CUR, FILE_READ);
+  size_t total = (fo ? fo.size() : 0) + (fc ? fc.size() : 0);
+  server.setContentLength(total);
+  server.send(200, "application/octet-stream", "");
+  uint8_t buf[256];
+  File* files[] = {&fo, &fc};
+  for (File* f : files) {
+    if (!*f) continue;
+    size_t n;
+    while ((n = f->read(buf, sizeof(buf))) > 0) server.sendContent((const char*)buf, n);
+    f->close();
+  }
+}
+
+// --- Endpoint Prometheus /metrics ---
+// Rendu dans un buffer statique pre-dimensionne (metrics.h) : aucune
+// String, aucune allocation. Le scrape tourne dans la loop UI, les sondes
+// ont leur propre tache et ne sont pas retardees.
+
+char metricsBuf[METRICS_BUF_SIZE];
+
+void handleMetrics() {
+  MetricsInput in;
+  in.cascade = cascade;
+  uint32_t t = statsNowS();
+  for (int w = 0; w < LAT_WIN_COUNT; w++) {
+    in.box[w] = gwStats.summary((LatWindowId)w, t);
+    in.net[w] = netStats.summary((LatWindowId)w, t);
+  }
+  in.uptimeRatio = uptimePct() / 100.0f;
+  in.outages = outageCount;
+  in.downtimeS = totalDowntimeMs / 1000;
+  in.rssi = (WiFi.status() == WL_CONNECTED) ? WiFi.RSSI() : 0;
+  in.bootS = t;
+
+  size_t metricsLen = metricsRender(metricsBuf, sizeof(metricsBuf), in);
+  if (metricsLen == 0) {
+    server.send(500, "text/plain", "metrics buffer overflow\n");
+    return;
+  }
+  server.setContentLength(metricsLen);
+  server.send(200, "text/plain; version=0.0.4", "");
+  server.sendContent(metricsBuf, metricsLen);
 }
 
 void setup() {
@@ -530,9 +894,20 @@ void setup() {
   } else {
     Serial.println("\nWiFi connection timeout");
   }
+
+  netStats.clear();
+  gwStats.clear();
+  journalBegin();
+  journalBoot();
+  server.on("/journal.bin", handleJournal);
+  server.on("/metrics", handleMetrics);
+  server.begin();
+  stateSinceMs = millis();
+
+  probeEvents = xEventGroupCreate();
+  xTaskCreatePinnedToCore(probeTask, "probe", 4096, NULL, 1, NULL, 0);
 }
 
-unsigned long lastCheckMs = 0;
 unsigned long lastUiFastMs = 0;
 unsigned long lastUiSlowMs = 0;
 unsigned long lastNtpSyncMs = 0;
@@ -540,21 +915,33 @@ unsigned long lastNtpSyncMs = 0;
 void loop() {
   esp_task_wdt_reset();
   handleTouch();
+  server.handleClient();
+
+  if (Serial.available()) {
+    char c = Serial.read();
+    if (c == 'j') journalDumpSerial();
+  }
 
   if (millis() - lastNtpSyncMs > 3600UL * 1000UL) {
     configTzTime(TZ_PARIS, NTP_SERVER);
     lastNtpSyncMs = millis();
   }
 
-  if (millis() - lastCheckMs >= CHECK_INTERVAL_MS) {
-    lastCheckMs = millis();
-    checkCascade();
+  ProbeCycle probe;
+  if (takeProbeCycle(probe)) {
+    cascadeApply(cascade, probe.res);
+    if (probe.res.wifiOk) {
+      for (int id = 0; id < PROBE_COUNT; id++) recordSamples((ProbeId)id, probe.samples[id]);
+    }
+    if (cascade.state == ST_OK) pushLatency(cascade.inetLatency);
+    else pushLatency(-1);
 
     bool wasOk = (previousState == ST_OK);
-    bool isOk = (currentState == ST_OK);
+    bool isOk = (cascade.state == ST_OK);
 
     if (wasOk && !isOk) {
       outageStartEpoch = time(nullptr);
+      outageCount++;
       outageStartMs = millis();
       Serial.printf("⚠ Coupure debut a epoch %ld\n", (long)outageStartEpoch);
     }
@@ -566,15 +953,19 @@ void loop() {
       clearSilence();
       Serial.printf("✓ Retour reseau, coupure de %lus\n", lastOutageDurationS);
     }
-    previousState = currentState;
+    if (cascade.state != previousState) {
+      journalTransition(previousState, cascade.state);
+      stateSinceMs = millis();
+    }
+    previousState = cascade.state;
 
-    Serial.printf("[%s] RSSI:%d GW:%dms NET:%dms DNS:%dms Uptime:%.2f%% TotalDown:%lus\n",
-      stateNames[currentState], WiFi.RSSI(),
-      gwLatency, inetLatency, dnsLatency,
-      uptimePct(), totalDowntimeMs / 1000);
+    Serial.printf("[%s] RSSI:%d GW:%dms NET:%dms DNS:%dms Uptime:%.2f%% TotalDown:%lus GraphSPI:%luB\n",
+      stateNames[cascade.state], WiFi.RSSI(),
+      cascade.gwLatency, cascade.inetLatency, cascade.dnsLatency,
+      uptimePct(), totalDowntimeMs / 1000, (unsigned long)graphLastSpiBytes);
   }
 
-  bool alarmActive = (currentState != ST_OK && currentState != ST_CHECKING && !audioMuted());
+  bool alarmActive = (cascade.state != ST_OK && cascade.state != ST_CHECKING && !audioMuted());
   tickAlarm(alarmActive);
 
   unsigned long now = millis();
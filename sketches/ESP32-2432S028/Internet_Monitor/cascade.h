@@ -0,0 +1,74 @@
+/*
+ * cascade.h - Machine d'etat du diagnostic en cascade (Internet_Monitor)
+ *
+ * Aucune dependance Arduino : les resultats bruts des sondes sont injectes
+ * via ProbeResults, ce qui permet de rejouer des scenarios sur PC.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+enum State { ST_CHECKING, ST_OK, ST_WIFI_DOWN, ST_LAN_DOWN, ST_INTERNET_DOWN, ST_DNS_DOWN };
+
+static const char* const stateNames[] = {"CHECKING", "OK", "WIFI_DOWN", "LAN_DOWN", "INTERNET_DOWN", "DNS_DOWN"};
+
+#define CASCADE_FAIL_THRESHOLD 2   // echecs consecutifs avant DOWN
+
+// Resultats bruts d'un cycle de sondes (lancees en parallele)
+struct ProbeResults {
+  bool wifiOk;
+  bool gwOk;
+  int  gwMs;
+  bool inetOk;
+  int  inetMs;
+  bool dnsOk;
+  int  dnsMs;
+};
+
+struct CascadeState {
+  State state = ST_CHECKING;
+  int wifiFail = 0, lanFail = 0, inetFail = 0, dnsFail = 0;
+  bool wifiDown = false, lanDown = false, inetDown = false, dnsDown = false;
+  int gwLatency = 0, inetLatency = 0, dnsLatency = 0;
+};
+
+// Hysteresis asymetrique : 2 echecs -> DOWN, 1 succes -> OK
+inline void cascadeLayer(bool ok, int& fail, bool& down) {
+  if (ok) { fail = 0; down = false; }
+  else {
+    fail++;
+    if (fail >= CASCADE_FAIL_THRESHOLD) down = true;
+  }
+}
+
+// Les sondes tournent toutes en meme temps, mais une couche n'est comptee
+// que si la couche inferieure a repondu dans le meme cycle : meme semantique
+// que l'ancienne cascade sequentielle (sortie au premier echec).
+inline void cascadeApply(CascadeState& c, const ProbeResults& r) {
+  cascadeLayer(r.wifiOk, c.wifiFail, c.wifiDown);
+
+  bool lan_ok = r.wifiOk && r.gwOk;
+  if (r.wifiOk) {
+    cascadeLayer(r.gwOk, c.lanFail, c.lanDown);
+    if (r.gwOk) c.gwLatency = r.gwMs;
+  }
+
+  bool inet_ok = lan_ok && r.inetOk;
+  if (lan_ok) {
+    cascadeLayer(r.inetOk, c.inetFail, c.inetDown);
+    if (r.inetOk) c.inetLatency = r.inetMs;
+  }
+
+  if (inet_ok) {
+    cascadeLayer(r.dnsOk, c.dnsFail, c.dnsDown);
+    if (r.dnsOk) c.dnsLatency = r.dnsMs;
+  }
+
+  // Etat = couche la plus basse en panne
+  if (c.wifiDown) c.state = ST_WIFI_DOWN;
+  else if (c.lanDown) c.state = ST_LAN_DOWN;
+  else if (c.inetDown) c.state = ST_INTERNET_DOWN;
+  else if (c.dnsDown) c.state = ST_DNS_DOWN;
+  else c.state = ST_OK;
+}
@@ -0,0 +1,59 @@
+/*
+ * journal.h - Format binaire du journal des coupures (Internet_Monitor)
+ *
+ * Enregistrements fixes de 24 octets, little-endian, ajoutes en fin de
+ * segment LittleFS (voir journalAppend dans le sketch). Aucune dependance
+ * Arduino : journal_decode.py reprend exactement cette structure.
+ *
+ * Offsets : 0 epoch | 4 uptimeS | 8 durationS | 12 gwMs | 14 inetMs |
+ *           16 dnsMs | 18 seq | 20 type | 21 states | 22 rssi | 23 crc
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JOURNAL_RECORD_SIZE 24
+
+enum JournalType : uint8_t {
+  JREC_BOOT       = 1,   // states = esp_reset_reason()
+  JREC_TRANSITION = 2    // states = (from << 4) | to
+};
+
+struct JournalRecord {
+  uint32_t epoch;       // heure de l'evenement, 0 si NTP pas encore synchro
+  uint32_t uptimeS;     // secondes depuis le boot
+  uint32_t durationS;   // temps passe dans l'etat 'from'
+  uint16_t gwMs;        // latences au moment de la transition
+  uint16_t inetMs;
+  uint16_t dnsMs;
+  uint16_t seq;         // numero d'ordre (boucle a 65535)
+  uint8_t  type;
+  uint8_t  states;
+  int8_t   rssi;
+  uint8_t  crc;         // CRC-8 (poly 0x07) des 23 octets precedents
+};
+
+static_assert(sizeof(JournalRecord) == JOURNAL_RECORD_SIZE, "format journal");
+
+inline uint8_t journalCrc8(const uint8_t* p, size_t n) {
+  uint8_t crc = 0;
+  while (n--) {
+    crc ^= *p++;
+    for (int i = 0; i < 8; i++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+inline void journalSeal(JournalRecord& r) {
+  r.crc = journalCrc8((const uint8_t*)&r, JOURNAL_RECORD_SIZE - 1);
+}
+
+inline bool journalValid(const JournalRecord& r) {
+  return (r.type == JREC_BOOT || r.type == JREC_TRANSITION) &&
+         r.crc == journalCrc8((const uint8_t*)&r, JOURNAL_RECORD_SIZE - 1);
+}
+
+inline uint8_t journalFrom(const JournalRecord& r) { return r.states >> 4; }
+inline uint8_t journalTo(const JournalRecord& r)   { return r.states & 0x0F; }
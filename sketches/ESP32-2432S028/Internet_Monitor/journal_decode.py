@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+#
+# Decodeur du journal des coupures Internet_Monitor (voir journal.h)
+#
+# Entrees acceptees :
+#   - fichier binaire recupere via HTTP :  curl -o j.bin http://<ip>/journal.bin
+#   - capture serie de la commande 'j' :   lignes "J <48 hex>"
+#
+# Usage : ./journal_decode.py j.bin      ou      ./journal_decode.py capture.txt
+#
+
+import struct
+import sys
+from datetime import datetime
+
+RECORD = struct.Struct("<IIIHHHHBBbB")   # 24 octets, little-endian
+JREC_BOOT = 1
+JREC_TRANSITION = 2
+
+STATES = ["CHECKING", "OK", "WIFI_DOWN", "LAN_DOWN", "INTERNET_DOWN", "DNS_DOWN"]
+RESET_REASONS = ["UNKNOWN", "POWERON", "EXT", "SW", "PANIC", "INT_WDT",
+                 "TASK_WDT", "WDT", "DEEPSLEEP", "BROWNOUT", "SDIO"]
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def load(path):
+    raw = open(path, "rb").read()
+    if raw.startswith(b"J ") or b"\nJ " in raw:
+        out = bytearray()
+        for line in raw.decode("ascii", "replace").splitlines():
+            parts = line.strip().split()
+            if len(parts) == 2 and parts[0] == "J" and len(parts[1]) == 2 * RECORD.size:
+                out += bytes.fromhex(parts[1])
+        return bytes(out)
+    return raw
+
+
+def state_name(s):
+    return STATES[s] if s < len(STATES) else "?%d" % s
+
+
+def fmt_time(epoch, uptime):
+    if epoch:
+        return datetime.fromtimestamp(epoch).strftime("%Y-%m-%d %H:%M:%S")
+    return "boot+%ds" % uptime
+
+
+def fmt_duration(s):
+    if s >= 3600:
+        return "%dh%02dm%02ds" % (s // 3600, s % 3600 // 60, s % 60)
+    return "%dm%02ds" % (s // 60, s % 60)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("usage: journal_decode.py <journal.bin | capture serie>")
+        sys.exit(1)
+
+    data = load(sys.argv[1])
+    bad = 0
+    outages = 0
+    downtime = 0
+    out_start = None    # uptime du passage OK -> panne, None hors coupure
+    for off in range(0, len(data) - RECORD.size + 1, RECORD.size):
+        chunk = data[off:off + RECORD.size]
+        (epoch, uptime, duration, gw, inet, dns, seq,
+         rtype, states, rssi, crc) = RECORD.unpack(chunk)
+        if crc != crc8(chunk[:-1]) or rtype not in (JREC_BOOT, JREC_TRANSITION):
+            bad += 1
+            continue
+
+        when = fmt_time(epoch, uptime)
+        if rtype == JREC_BOOT:
+            reason = RESET_REASONS[states] if states < len(RESET_REASONS) else str(states)
+            print("#%-5d %s  BOOT (reset %s)" % (seq, when, reason))
+            out_start = None    # pas de coupure a cheval sur un reboot
+            continue
+
+        frm, to = states >> 4, states & 0x0F
+        print("#%-5d %s  %-13s -> %-13s apres %-10s GW:%dms NET:%dms DNS:%dms RSSI:%d"
+              % (seq, when, state_name(frm), state_name(to), fmt_duration(duration),
+                 gw, inet, dns, rssi))
+        # Comme journalRestore() : la coupure commence en quittant OK et se
+        # termine au retour a OK, quels que soient les etats traverses
+        # (WIFI_DOWN -> LAN_DOWN -> OK) ; duree = ecart d'uptime
+        if frm == 1 and to != 1:
+            out_start = uptime
+        elif to == 1 and frm != 0 and out_start is not None:
+            outages += 1
+            downtime += uptime - out_start
+            print("       coupure terminee : %s" % fmt_duration(uptime - out_start))
+            out_start = None
+
+    print("--")
+    if out_start is not None:
+        print("coupure en cours depuis boot+%ds" % out_start)
+    print("%d coupure(s), %s cumules, %d enregistrement(s) invalide(s)"
+          % (outages, fmt_duration(downtime), bad))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,160 @@
+/*
+ * latency_stats.h - Statistiques de latence en memoire fixe (Internet_Monitor)
+ *
+ * Histogramme log-lineaire (type HDR) : 0..15 ms exacts, puis 8 sous-buckets
+ * par octave jusqu'a 2047 ms, soit 72 buckets. Un bucket est represente
+ * par son milieu : erreur relative <= 1/16 (6,25 %, LAT_REL_ERROR).
+ * Chaque fenetre glissante est un anneau de tranches ; une tranche perimee
+ * est remise a zero a sa reutilisation. Aucune allocation, aucune dependance
+ * Arduino (testable sur PC).
+ *
+ * Empreinte : LatSlot = 160 octets, LatencyStats (1 min + 1 h + 24 h)
+ * = 42 tranches = ~6,7 Ko.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define LAT_SUB_BITS 3
+#define LAT_SUB      (1 << LAT_SUB_BITS)        // sous-buckets par octave
+#define LAT_LINEAR   16                         // 0..15 ms exacts
+#define LAT_MAX_MS   2047                       // au-dela : ecrete
+#define LAT_BUCKETS  (LAT_LINEAR + 7 * LAT_SUB) // octaves 16..2047
+#define LAT_REL_ERROR (0.5 / LAT_SUB)           // demi-bucket / bas d'octave
+
+inline int latBucket(uint16_t ms) {
+  if (ms > LAT_MAX_MS) ms = LAT_MAX_MS;
+  if (ms < LAT_LINEAR) return ms;
+  int msb = 31 - __builtin_clz(ms);   // 4..10
+  int sub = (ms >> (msb - LAT_SUB_BITS)) & (LAT_SUB - 1);
+  return LAT_LINEAR + (msb - 4) * LAT_SUB + sub;
+}
+
+// Valeur representative (milieu) d'un bucket
+inline uint16_t latBucketValue(int b) {
+  if (b < LAT_LINEAR) return b;
+  int octave = (b - LAT_LINEAR) / LAT_SUB;
+  int sub = (b - LAT_LINEAR) % LAT_SUB;
+  int shift = octave + 4 - LAT_SUB_BITS;
+  uint16_t low = (uint16_t)((LAT_SUB + sub) << shift);
+  return low + ((1 << shift) >> 1);
+}
+
+inline void satInc16(uint16_t& v, uint16_t n = 1) {
+  v = (v > 0xFFFF - n) ? 0xFFFF : v + n;
+}
+
+struct LatSlot {
+  uint32_t epoch;             // numero de tranche (t / duree tranche)
+  uint16_t hist[LAT_BUCKETS];
+  uint16_t sent, lost;
+  uint32_t jitterSum;         // somme des |ecarts| entre reponses consecutives
+  uint16_t jitterN;
+};
+
+struct LatSummary {
+  uint32_t samples;           // reponses recues
+  uint32_t sent;
+  uint32_t lost;
+  uint16_t p50, p95, p99;     // ms
+  uint16_t jitter;            // ms, ecart moyen
+  float    lossPct;
+};
+
+template <int NSLOTS, uint32_t SLOT_S>
+struct LatWindow {
+  LatSlot slots[NSLOTS];
+
+  void clear() {
+    memset(slots, 0, sizeof(slots));
+    for (int i = 0; i < NSLOTS; i++) slots[i].epoch = UINT32_MAX;
+  }
+
+  LatSlot& slotAt(uint32_t t) {
+    uint32_t e = t / SLOT_S;
+    LatSlot& s = slots[e % NSLOTS];
+    if (s.epoch != e) {
+      memset(&s, 0, sizeof(s));
+      s.epoch = e;
+    }
+    return s;
+  }
+
+  // ms < 0 : paquet perdu
+  void add(uint32_t t, int16_t ms) {
+    LatSlot& s = slotAt(t);
+    satInc16(s.sent);
+    if (ms < 0) satInc16(s.lost);
+    else satInc16(s.hist[latBucket((uint16_t)ms)]);
+  }
+
+  void addJitter(uint32_t t, uint16_t delta) {
+    LatSlot& s = slotAt(t);
+    s.jitterSum += delta;
+    satInc16(s.jitterN);
+  }
+
+  LatSummary summary(uint32_t t) const {
+    uint32_t cur = t / SLOT_S;
+    uint32_t merged[LAT_BUCKETS] = {};
+    uint32_t jitterSum = 0, jitterN = 0;
+    LatSummary r = {};
+    for (int i = 0; i < NSLOTS; i++) {
+      const LatSlot& s = slots[i];
+      if (s.epoch > cur || cur - s.epoch >= NSLOTS) continue;
+      for (int b = 0; b < LAT_BUCKETS; b++) {
+        merged[b] += s.hist[b];
+        r.samples += s.hist[b];
+      }
+      r.sent += s.sent;
+      r.lost += s.lost;
+      jitterSum += s.jitterSum;
+      jitterN += s.jitterN;
+    }
+    r.p50 = quantile(merged, r.samples, 500);
+    r.p95 = quantile(merged, r.samples, 950);
+    r.p99 = quantile(merged, r.samples, 990);
+    r.jitter = jitterN ? (uint16_t)((jitterSum + jitterN / 2) / jitterN) : 0;
+    r.lossPct = r.sent ? 100.0f * r.lost / r.sent : 0.0f;
+    return r;
+  }
+
+  // q en pour mille ; rang = ceil(q * n)
+  static uint16_t quantile(const uint32_t* hist, uint32_t n, uint32_t q) {
+    if (n == 0) return 0;
+    uint32_t rank = (q * n + 999) / 1000;
+    if (rank == 0) rank = 1;
+    uint32_t acc = 0;
+    for (int b = 0; b < LAT_BUCKETS; b++) {
+      acc += hist[b];
+      if (acc >= rank) return latBucketValue(b);
+    }
+    return LAT_MAX_MS;
+  }
+};
+
+enum LatWindowId { LAT_WIN_1M, LAT_WIN_1H, LAT_WIN_24H, LAT_WIN_COUNT };
+
+struct LatencyStats {
+  LatWindow<6, 10>    m1;     // 6 x 10 s
+  LatWindow<12, 300>  h1;     // 12 x 5 min
+  LatWindow<24, 3600> d1;     // 24 x 1 h
+
+  void clear() { m1.clear(); h1.clear(); d1.clear(); }
+
+  void add(uint32_t t, int16_t ms) {
+    m1.add(t, ms); h1.add(t, ms); d1.add(t, ms);
+  }
+
+  void addJitter(uint32_t t, uint16_t delta) {
+    m1.addJitter(t, delta); h1.addJitter(t, delta); d1.addJitter(t, delta);
+  }
+
+  LatSummary summary(LatWindowId w, uint32_t t) const {
+    if (w == LAT_WIN_1H) return h1.summary(t);
+    if (w == LAT_WIN_24H) return d1.summary(t);
+    return m1.summary(t);
+  }
+};
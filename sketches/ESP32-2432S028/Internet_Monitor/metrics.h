@@ -0,0 +1,133 @@
+/*
+ * metrics.h - Rendu Prometheus de /metrics (Internet_Monitor)
+ *
+ * Le sketch copie l'etat courant dans un MetricsInput, metricsRender()
+ * l'ecrit au format texte Prometheus 0.0.4 dans un buffer fourni, par
+ * vsnprintf : aucune String, aucune allocation. Renvoie la longueur, ou 0
+ * si le buffer est trop petit (l'appelant repond 500, jamais une page
+ * tronquee). Aucune dependance Arduino : test/metrics_test.cpp rend le
+ * pire cas sur PC et verifie qu'il tient dans METRICS_BUF_SIZE.
+ */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "cascade.h"
+#include "latency_stats.h"
+
+#define METRICS_BUF_SIZE 6144
+
+struct MetricsInput {
+  CascadeState cascade;
+  LatSummary box[LAT_WIN_COUNT];   // passerelle, par fenetre
+  LatSummary net[LAT_WIN_COUNT];   // Internet, par fenetre
+  float uptimeRatio;               // 0..1
+  uint32_t outages;
+  uint32_t downtimeS;
+  int rssi;
+  uint32_t bootS;
+};
+
+struct MetricsOut {
+  char* buf;
+  size_t size;
+  size_t len;
+  bool overflow;
+};
+
+inline void metricsPrintf(MetricsOut& o, const char* fmt, ...) {
+  if (o.overflow) return;
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(o.buf + o.len, o.size - o.len, fmt, ap);
+  va_end(ap);
+  if (n < 0 || (size_t)n >= o.size - o.len) {
+    o.overflow = true;
+    return;
+  }
+  o.len += n;
+}
+
+inline void metricsHeader(MetricsOut& o, const char* name, const char* type, const char* help) {
+  metricsPrintf(o, "# HELP inetmon_%s %s\n# TYPE inetmon_%s %s\n", name, help, name, type);
+}
+
+inline size_t metricsRender(char* buf, size_t size, const MetricsInput& in) {
+  MetricsOut o = {buf, size, 0, size == 0};
+  if (size > 0) buf[0] = '\0';
+  const CascadeState& c = in.cascade;
+
+  metricsHeader(o, "state", "gauge", "Etat courant de la cascade (1 = actif)");
+  for (int i = 0; i <= ST_DNS_DOWN; i++) {
+    metricsPrintf(o, "inetmon_state{state=\"%s\"} %d\n", stateNames[i], c.state == i);
+  }
+
+  metricsHeader(o, "layer_up", "gauge", "Couche fonctionnelle (1) ou en panne (0)");
+  metricsPrintf(o, "inetmon_layer_up{layer=\"wifi\"} %d\n", !c.wifiDown);
+  metricsPrintf(o, "inetmon_layer_up{layer=\"box\"} %d\n", !c.lanDown);
+  metricsPrintf(o, "inetmon_layer_up{layer=\"net\"} %d\n", !c.inetDown);
+  metricsPrintf(o, "inetmon_layer_up{layer=\"dns\"} %d\n", !c.dnsDown);
+
+  metricsHeader(o, "layer_failures", "gauge", "Echecs consecutifs par couche");
+  metricsPrintf(o, "inetmon_layer_failures{layer=\"wifi\"} %d\n", c.wifiFail);
+  metricsPrintf(o, "inetmon_layer_failures{layer=\"box\"} %d\n", c.lanFail);
+  metricsPrintf(o, "inetmon_layer_failures{layer=\"net\"} %d\n", c.inetFail);
+  metricsPrintf(o, "inetmon_layer_failures{layer=\"dns\"} %d\n", c.dnsFail);
+
+  metricsHeader(o, "last_latency_ms", "gauge", "Derniere latence mesuree par couche");
+  metricsPrintf(o, "inetmon_last_latency_ms{layer=\"box\"} %d\n", c.gwLatency);
+  metricsPrintf(o, "inetmon_last_latency_ms{layer=\"net\"} %d\n", c.inetLatency);
+  metricsPrintf(o, "inetmon_last_latency_ms{layer=\"dns\"} %d\n", c.dnsLatency);
+
+  // Fenetres glissantes : quantiles, gigue, pertes
+  struct { const char* layer; const LatSummary* sum; } layers[] = {
+    {"box", in.box}, {"net", in.net}
+  };
+  const char* windows[] = {"1m", "1h", "24h"};
+
+  metricsHeader(o, "latency_ms", "gauge", "Quantiles de latence ICMP par fenetre");
+  for (int l = 0; l < 2; l++) {
+    for (int w = 0; w < LAT_WIN_COUNT; w++) {
+      const LatSummary& m = layers[l].sum[w];
+      const char* fmt = "inetmon_latency_ms{layer=\"%s\",window=\"%s\",quantile=\"%s\"} %u\n";
+      metricsPrintf(o, fmt, layers[l].layer, windows[w], "0.5", m.p50);
+      metricsPrintf(o, fmt, layers[l].layer, windows[w], "0.95", m.p95);
+      metricsPrintf(o, fmt, layers[l].layer, windows[w], "0.99", m.p99);
+    }
+  }
+
+  metricsHeader(o, "jitter_ms", "gauge", "Ecart moyen entre reponses consecutives");
+  for (int l = 0; l < 2; l++) {
+    for (int w = 0; w < LAT_WIN_COUNT; w++) {
+      metricsPrintf(o, "inetmon_jitter_ms{layer=\"%s\",window=\"%s\"} %u\n",
+                    layers[l].layer, windows[w], layers[l].sum[w].jitter);
+    }
+  }
+
+  metricsHeader(o, "loss_ratio", "gauge", "Taux de paquets ICMP perdus");
+  for (int l = 0; l < 2; l++) {
+    for (int w = 0; w < LAT_WIN_COUNT; w++) {
+      metricsPrintf(o, "inetmon_loss_ratio{layer=\"%s\",window=\"%s\"} %.4f\n",
+                    layers[l].layer, windows[w], layers[l].sum[w].lossPct / 100.0f);
+    }
+  }
+
+  metricsHeader(o, "uptime_ratio", "gauge", "Disponibilite depuis le boot");
+  metricsPrintf(o, "inetmon_uptime_ratio %.5f\n", in.uptimeRatio);
+
+  metricsHeader(o, "outages_total", "counter", "Coupures depuis le boot");
+  metricsPrintf(o, "inetmon_outages_total %lu\n", (unsigned long)in.outages);
+
+  metricsHeader(o, "downtime_seconds_total", "counter", "Duree cumulee des coupures terminees");
+  metricsPrintf(o, "inetmon_downtime_seconds_total %lu\n", (unsigned long)in.downtimeS);
+
+  metricsHeader(o, "wifi_rssi_dbm", "gauge", "Puissance du signal WiFi");
+  metricsPrintf(o, "inetmon_wifi_rssi_dbm %d\n", in.rssi);
+
+  metricsHeader(o, "boot_seconds", "counter", "Secondes depuis le boot");
+  metricsPrintf(o, "inetmon_boot_seconds %lu\n", (unsigned long)in.bootS);
+
+  return o.overflow ? 0 : o.len;
+}
@@ -0,0 +1,41 @@
+/*
+ * sliding_max.h - Maximum glissant sur les N derniers echantillons
+ *
+ * Deque monotone (valeurs decroissantes) dans un anneau de N cases :
+ * push et max en O(1) amorti, au lieu de rebalayer tout l'historique.
+ * Les valeurs negatives (echecs) font avancer la fenetre sans y entrer.
+ * Aucune dependance Arduino (testable sur PC).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+template <int N>
+struct SlidingMax {
+  int16_t  val[N];
+  uint32_t seq[N];      // numero d'ordre de l'echantillon
+  int head = 0;         // plus ancien (= maximum courant)
+  int count = 0;
+  uint32_t pushed = 0;
+
+  void push(int16_t v) {
+    uint32_t s = pushed++;
+    // Sortie de fenetre
+    while (count && seq[head] + N <= s) {
+      head = (head + 1) % N;
+      count--;
+    }
+    if (v < 0) return;
+    // Les valeurs <= v ne pourront plus jamais etre le maximum
+    while (count && val[(head + count - 1) % N] <= v) count--;
+    int tail = (head + count) % N;
+    val[tail] = v;
+    seq[tail] = s;
+    count++;
+  }
+
+  int16_t max(int16_t floor) const {
+    return (count && val[head] > floor) ? val[head] : floor;
+  }
+};
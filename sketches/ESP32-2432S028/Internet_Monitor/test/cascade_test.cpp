@@ -0,0 +1,111 @@
+/*
+ * cascade_test.cpp - Test PC de la machine d'etat (cascade.h)
+ *
+ * Rejoue des suites de ProbeResults et verifie l'etat apres chaque cycle :
+ * couche en panne seulement apres CASCADE_FAIL_THRESHOLD echecs
+ * consecutifs, retour a OK au premier succes, couche la plus basse
+ * prioritaire, couches superieures ignorees quand l'inferieure echoue,
+ * latences conservees pendant une panne.
+ *
+ *   g++ -std=c++11 -Wall -I.. -I../../../common cascade_test.cpp -o /tmp/cascade_test && /tmp/cascade_test
+ */
+
+#include "cascade.h"
+#include "host_test.h"
+
+// Cycles types : tout repond, ou echec a partir d'une couche
+static const ProbeResults P_OK      = {true,  true,  5,  true,  20, true,  30};
+static const ProbeResults P_NO_WIFI = {false, false, 0,  false, 0,  false, 0};
+static const ProbeResults P_NO_GW   = {true,  false, 0,  true,  20, true,  30};
+static const ProbeResults P_NO_INET = {true,  true,  6,  false, 0,  true,  30};
+static const ProbeResults P_NO_DNS  = {true,  true,  7,  true,  21, false, 0};
+
+struct Step {
+  const ProbeResults* probe;
+  State expected;
+};
+
+// Applique les cycles un par un ; 'name' identifie le scenario en echec
+static void play(const char* name, const Step* steps, int n) {
+  CascadeState c;
+  CHECK(c.state == ST_CHECKING, "%s : etat initial %s", name, stateNames[c.state]);
+  for (int i = 0; i < n; i++) {
+    cascadeApply(c, *steps[i].probe);
+    CHECK(c.state == steps[i].expected, "%s, cycle %d : %s au lieu de %s",
+          name, i + 1, stateNames[c.state], stateNames[steps[i].expected]);
+  }
+}
+
+#define PLAY(name, ...)                                   \
+  do {                                                    \
+    static const Step steps[] = {__VA_ARGS__};            \
+    play(name, steps, (int)(sizeof(steps) / sizeof(steps[0]))); \
+  } while (0)
+
+static void testDebounceAndRecovery() {
+  // Un echec isole ne change rien, le deuxieme consecutif passe DOWN
+  PLAY("wifi", {&P_OK, ST_OK}, {&P_NO_WIFI, ST_OK}, {&P_NO_WIFI, ST_WIFI_DOWN},
+       {&P_NO_WIFI, ST_WIFI_DOWN}, {&P_OK, ST_OK});
+  PLAY("box", {&P_OK, ST_OK}, {&P_NO_GW, ST_OK}, {&P_NO_GW, ST_LAN_DOWN}, {&P_OK, ST_OK});
+  PLAY("internet", {&P_OK, ST_OK}, {&P_NO_INET, ST_OK}, {&P_NO_INET, ST_INTERNET_DOWN},
+       {&P_OK, ST_OK});
+  PLAY("dns", {&P_OK, ST_OK}, {&P_NO_DNS, ST_OK}, {&P_NO_DNS, ST_DNS_DOWN}, {&P_OK, ST_OK});
+
+  // Echecs non consecutifs : le compteur repart a zero a chaque succes
+  PLAY("intermittent", {&P_NO_GW, ST_OK}, {&P_OK, ST_OK}, {&P_NO_GW, ST_OK}, {&P_OK, ST_OK},
+       {&P_NO_GW, ST_OK});
+
+  // Premier cycle : sortie de CHECKING meme sur un echec isole
+  PLAY("demarrage", {&P_NO_INET, ST_OK}, {&P_NO_INET, ST_INTERNET_DOWN});
+}
+
+static void testLowestLayerWins() {
+  // Internet en panne, puis le WiFi tombe : WIFI_DOWN masque INTERNET_DOWN
+  PLAY("internet puis wifi", {&P_NO_INET, ST_OK}, {&P_NO_INET, ST_INTERNET_DOWN},
+       {&P_NO_WIFI, ST_INTERNET_DOWN}, {&P_NO_WIFI, ST_WIFI_DOWN});
+
+  // Le WiFi revient mais Internet n'a pas encore repondu : la couche
+  // Internet reste DOWN (pas sondee pendant la panne WiFi) jusqu'a un succes
+  PLAY("retour partiel", {&P_NO_INET, ST_OK}, {&P_NO_INET, ST_INTERNET_DOWN},
+       {&P_NO_WIFI, ST_INTERNET_DOWN}, {&P_NO_WIFI, ST_WIFI_DOWN},
+       {&P_NO_INET, ST_INTERNET_DOWN}, {&P_OK, ST_OK});
+}
+
+static void testUpperLayersSkipped() {
+  // Sans WiFi, les couches superieures ne sont pas comptees
+  CascadeState c;
+  for (int i = 0; i < 5; i++) cascadeApply(c, P_NO_WIFI);
+  CHECK(c.wifiFail == 5, "wifiFail %d", c.wifiFail);
+  CHECK(c.lanFail == 0 && c.inetFail == 0 && c.dnsFail == 0, "couches superieures comptees : %d %d %d",
+        c.lanFail, c.inetFail, c.dnsFail);
+  CHECK(!c.lanDown && !c.inetDown && !c.dnsDown, "couche superieure DOWN sans sonde");
+
+  // Box muette : Internet et DNS ont repondu mais ne comptent pas
+  CascadeState d;
+  for (int i = 0; i < 3; i++) cascadeApply(d, P_NO_GW);
+  CHECK(d.lanFail == 3 && d.inetFail == 0 && d.dnsFail == 0, "box muette : %d %d %d",
+        d.lanFail, d.inetFail, d.dnsFail);
+  CHECK(d.inetLatency == 0 && d.dnsLatency == 0, "latence prise malgre la box muette");
+}
+
+static void testLatencyKept() {
+  CascadeState c;
+  cascadeApply(c, P_OK);
+  CHECK(c.gwLatency == 5 && c.inetLatency == 20 && c.dnsLatency == 30, "latences %d %d %d",
+        c.gwLatency, c.inetLatency, c.dnsLatency);
+  // Internet en echec : la derniere latence Internet reste affichee
+  cascadeApply(c, P_NO_INET);
+  CHECK(c.gwLatency == 6, "latence box %d", c.gwLatency);
+  CHECK(c.inetLatency == 20, "latence internet ecrasee : %d", c.inetLatency);
+  CHECK(c.dnsLatency == 30, "latence dns ecrasee : %d", c.dnsLatency);
+  cascadeApply(c, P_NO_DNS);
+  CHECK(c.inetLatency == 21 && c.dnsLatency == 30, "latences %d %d", c.inetLatency, c.dnsLatency);
+}
+
+int main() {
+  testDebounceAndRecovery();
+  testLowestLayerWins();
+  testUpperLayersSkipped();
+  testLatencyKept();
+  return hostTestEnd();
+}
@@ -0,0 +1,145 @@
+/*
+ * latency_stats_test.cpp - Test PC des statistiques de latence
+ *
+ * Compare p50/p95/p99 de l'histogramme aux quantiles exacts (meme rang,
+ * ceil(q * n)) sur des distributions connues : l'ecart relatif doit rester
+ * sous LAT_REL_ERROR, exact dans la zone lineaire 0..15 ms. Verifie aussi
+ * pertes, gigue, expiration des tranches et l'empreinte memoire annoncee
+ * dans latency_stats.h.
+ *
+ *   g++ -std=c++11 -Wall -I.. -I../../../common latency_stats_test.cpp -o /tmp/latency_stats_test && /tmp/latency_stats_test
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "host_test.h"
+#include "latency_stats.h"
+
+static_assert(sizeof(LatSlot) == 160, "LatSlot annonce a 160 octets");
+static_assert(sizeof(LatencyStats) == 42 * sizeof(LatSlot), "LatencyStats = 42 tranches");
+
+static uint32_t rngState = 12345;
+static uint32_t rnd() {
+  rngState = rngState * 1103515245u + 12345u;
+  return rngState >> 8;
+}
+
+static uint16_t exactQuantile(std::vector<uint16_t> v, uint32_t q) {
+  std::sort(v.begin(), v.end());
+  uint32_t rank = (q * (uint32_t)v.size() + 999) / 1000;
+  if (rank == 0) rank = 1;
+  return v[rank - 1];
+}
+
+// Injecte les echantillons sur 50 s (une fenetre 1 min) et compare
+static void checkDistribution(const char* name, const std::vector<uint16_t>& v) {
+  LatencyStats st;
+  st.clear();
+  for (size_t i = 0; i < v.size(); i++) st.add(1000 + (uint32_t)(i * 50 / v.size()), v[i]);
+
+  const uint32_t qs[] = {500, 950, 990};
+  for (int w = 0; w < LAT_WIN_COUNT; w++) {
+    LatSummary s = st.summary((LatWindowId)w, 1049);
+    CHECK(s.samples == v.size(), "%s fenetre %d : %u echantillons", name, w, (unsigned)s.samples);
+    const uint16_t got[] = {s.p50, s.p95, s.p99};
+    for (int k = 0; k < 3; k++) {
+      uint16_t exact = exactQuantile(v, qs[k]);
+      double err = exact ? fabs((double)got[k] - exact) / exact : (double)got[k];
+      CHECK(err <= LAT_REL_ERROR, "%s fenetre %d q%u : %u ms au lieu de %u (%.1f %%)",
+            name, w, (unsigned)qs[k] / 10, got[k], exact, err * 100);
+      if (exact < LAT_LINEAR) CHECK(got[k] == exact, "%s : %u ms non exact", name, exact);
+      if (w == LAT_WIN_1M) {
+        printf("%-10s q%-2u exact %4u  histo %4u  (%+.1f %%)\n", name, (unsigned)qs[k] / 10,
+               exact, got[k], exact ? 100.0 * ((double)got[k] - exact) / exact : 0.0);
+      }
+    }
+  }
+}
+
+static void testQuantiles() {
+  std::vector<uint16_t> v;
+  for (int i = 0; i < 5000; i++) v.push_back(1 + rnd() % 1500);
+  checkDistribution("uniforme", v);
+
+  v.clear();   // queue longue : exponentielle de moyenne 40 ms
+  for (int i = 0; i < 5000; i++) {
+    double u = (rnd() % 1000000 + 1) / 1000001.0;
+    double ms = -40.0 * log(u);
+    v.push_back((uint16_t)std::min(ms, (double)LAT_MAX_MS));
+  }
+  checkDistribution("expo", v);
+
+  v.clear();   // bimodale : reseau local rapide, 3 % de detours lents
+  for (int i = 0; i < 5000; i++) v.push_back(rnd() % 100 < 3 ? 600 + rnd() % 300 : 8 + rnd() % 6);
+  checkDistribution("bimodale", v);
+
+  v.clear();   // zone lineaire : resultat exact
+  for (int i = 0; i < 1000; i++) v.push_back(rnd() % 16);
+  checkDistribution("lineaire", v);
+
+  // Pire cas de l'arrondi : chaque valeur en bas de son bucket
+  for (int b = LAT_LINEAR; b < LAT_BUCKETS; b++) {
+    uint16_t lo = 0;
+    while (latBucket(lo) != b) lo++;
+    uint16_t mid = latBucketValue(b);
+    double err = fabs((double)mid - lo) / lo;
+    CHECK(err <= LAT_REL_ERROR, "bucket %d : %u ms -> %u ms (%.2f %%)", b, lo, mid, err * 100);
+  }
+}
+
+static void testLossAndJitter() {
+  LatencyStats st;
+  st.clear();
+  // 100 envois sur 50 s, 1 sur 8 perdu
+  int lost = 0;
+  for (int i = 0; i < 100; i++) {
+    bool drop = i % 8 == 0;
+    lost += drop;
+    st.add(2000 + i / 2, drop ? -1 : 20);
+  }
+  LatSummary s = st.summary(LAT_WIN_1M, 2049);
+  CHECK(s.sent == 100 && s.lost == (uint32_t)lost, "envoyes %u perdus %u", (unsigned)s.sent, (unsigned)s.lost);
+  CHECK(s.samples == (uint32_t)(100 - lost), "reponses %u", (unsigned)s.samples);
+  CHECK(fabsf(s.lossPct - 100.0f * lost / 100) < 0.01f, "pertes %.2f %%", s.lossPct);
+
+  // Gigue : moyenne arrondie des ecarts
+  const uint16_t deltas[] = {1, 2, 2, 10};   // 15 / 4 = 3,75 -> 4
+  for (uint16_t d : deltas) st.addJitter(2010, d);
+  s = st.summary(LAT_WIN_1M, 2049);
+  CHECK(s.jitter == 4, "gigue %u", s.jitter);
+
+  LatencyStats empty;
+  empty.clear();
+  s = empty.summary(LAT_WIN_24H, 5000);
+  CHECK(s.samples == 0 && s.p99 == 0 && s.jitter == 0 && s.lossPct == 0.0f, "fenetre vide");
+}
+
+static void testExpiry() {
+  LatencyStats st;
+  st.clear();
+  st.add(3600, 500);   // ancien pic
+  st.add(3700, 10);
+  // 1 min : le pic sort apres 6 tranches de 10 s
+  CHECK(st.summary(LAT_WIN_1M, 3659).samples == 1, "1 min : pic perdu trop tot");
+  CHECK(st.summary(LAT_WIN_1M, 3700).p99 == 10, "1 min : pic encore compte");
+  // 1 h et 24 h gardent les deux
+  CHECK(st.summary(LAT_WIN_1H, 3700).samples == 2, "1 h");
+  CHECK(st.summary(LAT_WIN_24H, 3700).samples == 2, "24 h");
+  // Au bout de 24 h, la tranche de 3600 est reutilisee et remise a zero
+  CHECK(st.summary(LAT_WIN_24H, 3600 + 24 * 3600).samples == 0, "24 h : tranche perimee comptee");
+  st.add(3600 + 24 * 3600, 12);
+  LatSummary s = st.summary(LAT_WIN_24H, 3600 + 24 * 3600);
+  CHECK(s.samples == 1 && s.p50 == 12, "24 h apres reutilisation : %u echantillons, p50 %u",
+        (unsigned)s.samples, s.p50);
+}
+
+int main() {
+  testQuantiles();
+  testLossAndJitter();
+  testExpiry();
+  printf("LatencyStats : %u octets (%u par tranche)\n", (unsigned)sizeof(LatencyStats),
+         (unsigned)sizeof(LatSlot));
+  return hostTestEnd();
+}
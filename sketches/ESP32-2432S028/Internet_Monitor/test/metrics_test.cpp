@@ -0,0 +1,137 @@
+/*
+ * metrics_test.cpp - Test PC du rendu /metrics (metrics.h)
+ *
+ * Rend le pire cas (chaque champ a la largeur maximale de son type),
+ * verifie qu'il tient dans METRICS_BUF_SIZE, qu'un buffer d'un octet trop
+ * court donne un echec propre, et relit la sortie comme du texte
+ * Prometheus 0.0.4 (HELP/TYPE avant les echantillons, noms, labels,
+ * valeurs numeriques).
+ *
+ *   g++ -std=c++11 -Wall -I.. -I../../../common metrics_test.cpp -o /tmp/metrics_test && /tmp/metrics_test
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <set>
+#include <string>
+#include "host_test.h"
+#include "metrics.h"
+
+static bool isNameStart(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':'; }
+static bool isNameChar(char c) { return isNameStart(c) || (c >= '0' && c <= '9'); }
+
+// Nom de metrique en debut de p ; renvoie sa longueur (0 si invalide)
+static size_t nameLen(const char* p) {
+  if (!isNameStart(*p)) return 0;
+  size_t n = 1;
+  while (isNameChar(p[n])) n++;
+  return n;
+}
+
+// Verifie le format d'exposition texte ; renvoie le nombre d'echantillons
+static int parsePrometheus(const std::string& text) {
+  std::set<std::string> typed, helped;
+  int samples = 0;
+  CHECK(!text.empty() && text.back() == '\n', "derniere ligne non terminee");
+
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t eol = text.find('\n', pos);
+    std::string line = text.substr(pos, eol - pos);
+    pos = eol + 1;
+    const char* p = line.c_str();
+
+    if (line.compare(0, 7, "# HELP ") == 0 || line.compare(0, 7, "# TYPE ") == 0) {
+      bool type = line[2] == 'T';
+      size_t n = nameLen(p + 7);
+      CHECK(n > 0 && p[7 + n] == ' ', "%s", p);
+      std::string name(p + 7, n);
+      if (type) {
+        std::string kind(p + 8 + n);
+        CHECK(kind == "gauge" || kind == "counter", "%s", p);
+        CHECK(typed.insert(name).second, "TYPE en double : %s", p);
+      } else {
+        CHECK(helped.insert(name).second, "HELP en double : %s", p);
+      }
+      continue;
+    }
+    CHECK(line[0] != '#', "commentaire inattendu : %s", p);
+
+    size_t n = nameLen(p);
+    CHECK(n > 0, "nom invalide : %s", p);
+    std::string name(p, n);
+    CHECK(typed.count(name) && helped.count(name), "echantillon sans HELP/TYPE : %s", p);
+    p += n;
+    if (*p == '{') {
+      p++;
+      for (;;) {
+        size_t k = nameLen(p);
+        CHECK(k > 0 && p[k] == '=' && p[k + 1] == '"', "label invalide : %s", line.c_str());
+        if (!(k > 0 && p[k] == '=' && p[k + 1] == '"')) break;
+        p += k + 2;
+        while (*p && *p != '"') {
+          CHECK(*p != '\\' && *p != '\n', "echappement inattendu : %s", line.c_str());
+          p++;
+        }
+        CHECK(*p == '"', "label non ferme : %s", line.c_str());
+        p++;
+        if (*p == ',') { p++; continue; }
+        CHECK(*p == '}', "labels non fermes : %s", line.c_str());
+        p++;
+        break;
+      }
+    }
+    CHECK(*p == ' ', "espace attendu avant la valeur : %s", line.c_str());
+    char* end;
+    strtod(p + 1, &end);
+    CHECK(end != p + 1 && *end == '\0', "valeur invalide : %s", line.c_str());
+    samples++;
+  }
+  return samples;
+}
+
+static MetricsInput worstCase() {
+  MetricsInput in;
+  in.cascade.state = ST_INTERNET_DOWN;    // nom d'etat le plus long
+  in.cascade.wifiFail = in.cascade.lanFail = in.cascade.inetFail = in.cascade.dnsFail = INT_MIN;
+  in.cascade.gwLatency = in.cascade.inetLatency = in.cascade.dnsLatency = INT_MIN;
+  for (int w = 0; w < LAT_WIN_COUNT; w++) {
+    LatSummary m = {};
+    m.samples = m.sent = m.lost = UINT32_MAX;
+    m.p50 = m.p95 = m.p99 = m.jitter = UINT16_MAX;
+    m.lossPct = 100.0f;                   // borne par construction (lost <= sent)
+    in.box[w] = in.net[w] = m;
+  }
+  in.uptimeRatio = 1.0f;
+  in.outages = in.downtimeS = in.bootS = UINT32_MAX;
+  in.rssi = INT_MIN;
+  return in;
+}
+
+int main() {
+  static char buf[METRICS_BUF_SIZE];
+
+  // Pire cas : doit tenir, avec la marge affichee
+  MetricsInput in = worstCase();
+  size_t len = metricsRender(buf, sizeof(buf), in);
+  CHECK(len > 0, "pire cas hors de METRICS_BUF_SIZE (%d)", METRICS_BUF_SIZE);
+  CHECK(len == strlen(buf), "longueur %zu != strlen %zu", len, strlen(buf));
+  int samples = parsePrometheus(std::string(buf, len));
+  CHECK(samples == 6 + 4 + 4 + 3 + 18 + 6 + 6 + 5, "%d echantillons", samples);
+  printf("pire cas : %zu / %d octets, %d echantillons\n", len, METRICS_BUF_SIZE, samples);
+
+  // Un octet de moins que necessaire (place du '\0') : echec, pas de troncature
+  static char small[METRICS_BUF_SIZE];
+  CHECK(metricsRender(small, len, in) == 0, "debordement non detecte");
+  CHECK(metricsRender(small, len + 1, in) == len, "ajustement exact refuse");
+  CHECK(metricsRender(small, 0, in) == 0, "buffer vide");
+
+  // Etat de demarrage (tout a zero) : format valide aussi
+  MetricsInput zero = {};
+  len = metricsRender(buf, sizeof(buf), zero);
+  CHECK(len > 0, "etat initial");
+  parsePrometheus(std::string(buf, len));
+
+  return hostTestEnd();
+}
@@ -23,6 +23,8 @@
 #include <TAMC_GT911.h>
 #include "credentials.h"
 #include "prim_config.h"
+#include "perf_overlay.h"
+#include "ui_bind.h"
 #include "esp32s3/rom/cache.h"
 
 /* ── Display configuration ─────────────────────────────────── */
@@ -298,11 +300,13 @@ static void fetchDepartures()
     https.setTimeout(10000);
     esp_task_wdt_reset();
 
+    perfFetchBegin();
     if (https.begin(client, url)) {
         https.addHeader("Accept", "application/json");
         https.addHeader("apikey", PRIM_API_KEY);
 
         int httpCode = https.GET();
+        perfFetchEnd(httpCode);
         esp_task_wdt_reset();
         Serial.printf("HTTP code: %d\n", httpCode);
 
@@ -407,37 +411,37 @@ static void fetchDepartures()
 static void updateUI()
 {
     // Hide spinner, show button
-    lv_obj_add_flag(spinner, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_clear_flag(btn_refresh, LV_OBJ_FLAG_HIDDEN);
+    uiSetHidden(spinner, true);
+    uiSetHidden(btn_refresh, false);
 
     // Night mode overlay
     if (nightMode) {
-        lv_obj_clear_flag(night_overlay, LV_OBJ_FLAG_HIDDEN);
-        lv_label_set_text(label_status, "Mode veille (06h-20h)");
+        uiSetHidden(night_overlay, false);
+        uiSetText(label_status, "Mode veille (06h-20h)");
         return;
     }
-    lv_obj_add_flag(night_overlay, LV_OBJ_FLAG_HIDDEN);
+    uiSetHidden(night_overlay, true);
 
     // Update header
     char buf[64];
     snprintf(buf, sizeof(buf), LV_SYMBOL_GPS " %s", stops[currentStop].stopName);
-    lv_label_set_text(label_stop, buf);
+    uiSetText(label_stop, buf);
 
     // Update status
     if (!dataValid) {
         if (strlen(errorMsg) > 0) {
-            lv_label_set_text(label_status, errorMsg);
+            uiSetText(label_status, errorMsg);
         }
     } else if (departureCount == 0) {
-        lv_label_set_text(label_status, "Aucun bus prevu");
+        uiSetText(label_status, "Aucun bus prevu");
     } else {
         snprintf(buf, sizeof(buf), "%d passage%s", departureCount, departureCount > 1 ? "s" : "");
-        lv_label_set_text(label_status, buf);
+        uiSetText(label_status, buf);
     }
 
     // Update time
     snprintf(buf, sizeof(buf), "MAJ: %s", lastUpdateTime);
-    lv_label_set_text(label_update_time, buf);
+    uiSetText(label_update_time, buf);
 
     // Update departures
     for (int i = 0; i < MAX_DEPARTURES; i++) {
@@ -467,17 +471,19 @@ static void updateUI()
                 color = lv_color_hex(COLOR_NORMAL);
             }
 
-            lv_label_set_text(labels_time[i], timeStr);
-            lv_obj_set_style_text_color(labels_time[i], color, 0);
+            uiSetText(labels_time[i], timeStr);
+            uiSetTextColor(labels_time[i], color);
 
             char destBuf[60];
             snprintf(destBuf, sizeof(destBuf), "[%s] %s", departures[i].lineName, departures[i].destination);
-            lv_label_set_text(labels_dest[i], destBuf);
-            lv_obj_clear_flag(lv_obj_get_parent(labels_time[i]), LV_OBJ_FLAG_HIDDEN);
+            uiSetText(labels_dest[i], destBuf);
+            uiSetHidden(lv_obj_get_parent(labels_time[i]), false);
         } else {
-            lv_obj_add_flag(lv_obj_get_parent(labels_time[i]), LV_OBJ_FLAG_HIDDEN);
+            uiSetHidden(lv_obj_get_parent(labels_time[i]), true);
         }
     }
+
+    uiBindPrint(Serial);
 }
 
 /* ── Forward declaration ───────────────────────────────────── */
@@ -516,11 +522,11 @@ static void btn_eglise_cb(lv_event_t *e)
 static void updateStopButtons()
 {
     if (currentStop == STOP_FOCH) {
-        lv_obj_set_style_bg_color(btn_foch, lv_color_hex(COLOR_ACCENT), 0);
-        lv_obj_set_style_bg_color(btn_eglise, lv_color_hex(COLOR_CARD), 0);
+        uiSetBgColor(btn_foch, lv_color_hex(COLOR_ACCENT));
+        uiSetBgColor(btn_eglise, lv_color_hex(COLOR_CARD));
     } else {
-        lv_obj_set_style_bg_color(btn_foch, lv_color_hex(COLOR_CARD), 0);
-        lv_obj_set_style_bg_color(btn_eglise, lv_color_hex(COLOR_ACCENT), 0);
+        uiSetBgColor(btn_foch, lv_color_hex(COLOR_CARD));
+        uiSetBgColor(btn_eglise, lv_color_hex(COLOR_ACCENT));
     }
 }
 
@@ -719,6 +725,8 @@ void setup()
 
     // Create UI
     createUI();
+    perfOverlayBegin();
+    uiRedrawCounterBegin();
 
     // Connect WiFi
     lv_label_set_text(label_status, "Connexion WiFi...");
@@ -18,6 +18,7 @@
 #include <WiFi.h>
 #include <PubSubClient.h>
 #include "credentials.h"
+#include "perf_overlay.h"
 #include "esp32s3/rom/cache.h"
 
 /* ── Display configuration ─────────────────────────────────── */
@@ -544,6 +545,7 @@ void setup() {
 
     // Build UI
     ui_init();
+    perfOverlayBegin();
 
     // Start WiFi (non-blocking)
     WiFi.mode(WIFI_STA);
@@ -3,6 +3,8 @@
  *
  * Dashboard systeme interactif : jauges RAM/PSRAM, infos WiFi,
  * controle des 3 relais par boutons tactiles.
+ * Les widgets ne sont touches que si leur valeur change (ui_bind.h) :
+ * ligne "ui,..." sur le port serie toutes les 10 s.
  *
  * Board: ESP32-4848S040C_I_Y_3 (Guition 4" 480x480 IPS)
  * FQBN: PlatformIO esp32-s3-devkitm-1
@@ -20,6 +22,7 @@
 #include <esp_system.h>
 #include <esp_chip_info.h>
 #include "credentials.h"
+#include "ui_bind.h"
 #include "esp32s3/rom/cache.h"
 
 /* ── Display configuration ─────────────────────────────────── */
@@ -104,6 +107,11 @@ static const unsigned long UPDATE_INTERVAL = 1000;
 static unsigned long last_wifi_check = 0;
 static const unsigned long WIFI_CHECK_INTERVAL = 10000;
 
+/* ── Redraw statistics ─────────────────────────────────────── */
+
+static unsigned long last_ui_log = 0;
+static const unsigned long UI_LOG_INTERVAL = 10000;
+
 /* ── LVGL display flush callback ───────────────────────────── */
 
 static void disp_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area,
@@ -319,9 +327,9 @@ static void update_display(void) {
     size_t ram_used = ram_total - ram_free;
     int ram_pct = (ram_total > 0) ? (int)(ram_used * 100 / ram_total) : 0;
 
-    lv_arc_set_value(arc_ram, ram_pct);
-    lv_label_set_text_fmt(lbl_ram_pct, "%d%%", ram_pct);
-    lv_label_set_text_fmt(lbl_ram_val, "%d/%d KB", (int)(ram_used / 1024), (int)(ram_total / 1024));
+    uiSetArc(arc_ram, ram_pct);
+    uiSetTextFmt(lbl_ram_pct, "%d%%", ram_pct);
+    uiSetTextFmt(lbl_ram_val, "%d/%d KB", (int)(ram_used / 1024), (int)(ram_total / 1024));
 
     // ── PSRAM ──
     size_t psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
@@ -329,37 +337,36 @@ static void update_display(void) {
     size_t psram_used = psram_total - psram_free;
     int psram_pct = (psram_total > 0) ? (int)(psram_used * 100 / psram_total) : 0;
 
-    lv_arc_set_value(arc_psram, psram_pct);
-    lv_label_set_text_fmt(lbl_psram_pct, "%d%%", psram_pct);
-    // Use integer math (LV_SPRINTF_USE_FLOAT is off)
+    uiSetArc(arc_psram, psram_pct);
+    uiSetTextFmt(lbl_psram_pct, "%d%%", psram_pct);
     int psram_used_kb = (int)(psram_used / 1024);
     int psram_total_kb = (int)(psram_total / 1024);
-    lv_label_set_text_fmt(lbl_psram_val, "%d.%d/%d.%d MB",
+    uiSetTextFmt(lbl_psram_val, "%d.%d/%d.%d MB",
                           psram_used_kb / 1024, (psram_used_kb % 1024) * 10 / 1024,
                           psram_total_kb / 1024, (psram_total_kb % 1024) * 10 / 1024);
 
     // ── Chip info ──
     uint32_t cpu_mhz = getCpuFrequencyMhz();
-    lv_label_set_text_fmt(lbl_chip, LV_SYMBOL_SETTINGS "  ESP32-S3 2 cores    %lu MHz", (unsigned long)cpu_mhz);
+    uiSetTextFmt(lbl_chip, LV_SYMBOL_SETTINGS "  ESP32-S3 2 cores    %lu MHz", (unsigned long)cpu_mhz);
 
     // ── Uptime ──
     unsigned long sec = millis() / 1000;
     unsigned long h = sec / 3600;
     unsigned long m = (sec % 3600) / 60;
     unsigned long s = sec % 60;
-    lv_label_set_text_fmt(lbl_uptime, LV_SYMBOL_LOOP " %02lu:%02lu:%02lu", h, m, s);
+    uiSetTextFmt(lbl_uptime, LV_SYMBOL_LOOP " %02lu:%02lu:%02lu", h, m, s);
 
     // ── WiFi ──
     if (WiFi.status() == WL_CONNECTED) {
         int rssi = WiFi.RSSI();
-        lv_label_set_text_fmt(lbl_wifi, LV_SYMBOL_WIFI "  %s  IP: %s  %d dBm",
-                              WiFi.SSID().c_str(),
-                              WiFi.localIP().toString().c_str(),
-                              rssi);
-        lv_obj_set_style_text_color(lbl_wifi, lv_color_hex(0xaaaaaa), 0);
+        uiSetTextFmt(lbl_wifi, LV_SYMBOL_WIFI "  %s  IP: %s  %d dBm",
+                     WiFi.SSID().c_str(),
+                     WiFi.localIP().toString().c_str(),
+                     rssi);
+        uiSetTextColor(lbl_wifi, lv_color_hex(0xaaaaaa));
     } else {
-        lv_label_set_text(lbl_wifi, LV_SYMBOL_WIFI "  Non connecte");
-        lv_obj_set_style_text_color(lbl_wifi, lv_color_hex(0xff4444), 0);
+        uiSetText(lbl_wifi, LV_SYMBOL_WIFI "  Non connecte");
+        uiSetTextColor(lbl_wifi, lv_color_hex(0xff4444));
     }
 }
 
@@ -417,6 +424,7 @@ void setup() {
 
     // Build UI
     ui_init();
+    uiRedrawCounterBegin();
 
     // Start WiFi (non-blocking)
     WiFi.mode(WIFI_STA);
@@ -443,6 +451,12 @@ void loop() {
         update_display();
     }
 
+    // Widget writes vs skipped, frames redrawn
+    if (now - last_ui_log >= UI_LOG_INTERVAL) {
+        last_ui_log = now;
+        uiBindPrint(Serial);
+    }
+
     // WiFi auto-reconnect
     if (now - last_wifi_check >= WIFI_CHECK_INTERVAL) {
         last_wifi_check = now;
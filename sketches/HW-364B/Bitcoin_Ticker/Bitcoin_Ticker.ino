@@ -4,6 +4,12 @@
  * Affiche le cours du Bitcoin en USD via l'API CoinGecko.
  * Mise a jour toutes les 60 secondes.
  *
+ * Requete HTTP ecrite a la main sur un seul WiFiClientSecure reutilise
+ * (keep-alive + reprise de session TLS), tampons BearSSL reduits si le
+ * serveur accepte MFLN, reponse decodee en flux (simple_price.h) :
+ * aucune String, tas stable sur des jours. Stats du tas sur le port serie.
+ * Test en local : API_HOST = IP du PC, API_PORT 8443, price_standin.py.
+ *
  * Pins OLED sur HW-364B:
  *   SDA -> GPIO14 (D5)
  *   SCL -> GPIO12 (D6)
@@ -11,17 +17,16 @@
  * Board: NodeMCU 1.0 (ESP-12E Module)
  * FQBN: esp8266:esp8266:nodemcuv2
  *
- * @dependencies U8g2, ArduinoJson
+ * @dependencies U8g2
  */
 
 #include <U8g2lib.h>
 #include <Wire.h>
 #include <ESP8266WiFi.h>
-#include <ESP8266HTTPClient.h>
 #include <WiFiClientSecure.h>
-#include <ArduinoJson.h>
 #include <time.h>
 #include "credentials.h"
+#include "simple_price.h"
 
 // Configuration OLED
 U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2(
@@ -36,8 +41,12 @@ U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2(
 
 // API CoinGecko (gratuite, sans cle)
 const char* API_HOST = "api.coingecko.com";
+const uint16_t API_PORT = 443;
 const char* API_PATH = "/api/v3/simple/price?ids=bitcoin&vs_currencies=usd&include_24hr_change=true";
 
+#define TLS_MFLN_SIZE   512     // tampons BearSSL si MFLN accepte (sinon 16 Ko en RX)
+#define HTTP_TIMEOUT_MS 5000
+
 // Donnees Bitcoin
 float btcPrice = 0;
 float btcChange24h = 0;
@@ -45,8 +54,18 @@ bool dataValid = false;
 unsigned long lastUpdate = 0;
 char lastUpdateTime[10] = "--:--";
 
-// WiFi client
-WiFiClientSecure client;
+// WiFi client : une seule instance pour toute la vie du sketch, les
+// tampons BearSSL ne sont alloues qu'a la connexion
+BearSSL::WiFiClientSecure client;
+BearSSL::Session tlsSession;    // reprise de session : handshake abrege
+bool tlsMfln = false;
+SimplePriceParser parser;
+
+// Statistiques (port serie)
+uint32_t fetchCount = 0;
+uint32_t fetchFail = 0;
+uint32_t tlsConnects = 0;
+uint32_t heapMin = 0xFFFFFFFF;
 
 void setupWiFi() {
   u8g2.clearBuffer();
@@ -69,7 +88,10 @@ void setupWiFi() {
   }
 
   if (WiFi.status() == WL_CONNECTED) {
-    u8g2.drawStr(5, 50, WiFi.localIP().toString().c_str());
+    IPAddress ip = WiFi.localIP();
+    char ipStr[16];
+    snprintf(ipStr, sizeof(ipStr), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    u8g2.drawStr(5, 50, ipStr);
     u8g2.sendBuffer();
     delay(1000);
   }
@@ -78,6 +100,120 @@ void setupWiFi() {
   configTime(1 * 3600, 0, "pool.ntp.org");
 }
 
+// Tampons TLS : 2 x 512 octets si le serveur negocie MFLN, sinon la
+// taille standard en reception (un enregistrement TLS complet)
+void setupTLS() {
+  client.setInsecure();  // Skip certificate verification
+  tlsMfln = client.probeMaxFragmentLength(API_HOST, API_PORT, TLS_MFLN_SIZE);
+  if (tlsMfln) {
+    client.setBufferSizes(TLS_MFLN_SIZE, TLS_MFLN_SIZE);
+  } else {
+    client.setBufferSizes(16384, 512);
+  }
+  client.setSession(&tlsSession);
+  client.setTimeout(HTTP_TIMEOUT_MS);
+  Serial.printf("TLS %s:%u MFLN %s\n", API_HOST, API_PORT, tlsMfln ? "oui (512)" : "non (16K)");
+}
+
+// Lit une ligne sans \r\n, tronquee a len-1 (le reste est jete).
+// Retourne sa longueur, -1 sur timeout ou connexion fermee.
+int readLine(char* buf, size_t len) {
+  size_t n = 0;
+  unsigned long t0 = millis();
+  while (millis() - t0 < HTTP_TIMEOUT_MS) {
+    int c = client.read();
+    if (c < 0) {
+      if (!client.connected()) break;
+      delay(1);
+      continue;
+    }
+    if (c == '\n') {
+      if (n && buf[n - 1] == '\r') n--;
+      buf[n] = '\0';
+      return n;
+    }
+    if (n < len - 1) buf[n++] = c;
+  }
+  buf[n] = '\0';
+  return -1;
+}
+
+// Verse 'len' octets du corps dans le parser (-1 : jusqu'a la fermeture)
+bool readBody(long len) {
+  unsigned long t0 = millis();
+  while (len != 0 && millis() - t0 < HTTP_TIMEOUT_MS) {
+    int c = client.read();
+    if (c < 0) {
+      if (!client.connected()) return len < 0;
+      delay(1);
+      continue;
+    }
+    parser.feed(c);
+    if (len > 0) len--;
+  }
+  return len == 0;
+}
+
+// GET API_PATH sur la connexion ouverte. Le corps est toujours lu en
+// entier pour que la connexion reste reutilisable.
+int httpGet() {
+  char line[96];
+  char req[256];
+
+  // Un seul write : un seul enregistrement TLS
+  int len = snprintf(req, sizeof(req),
+                     "GET %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: HW-364B\r\n"
+                     "Accept: application/json\r\nConnection: keep-alive\r\n\r\n",
+                     API_PATH, API_HOST);
+  if (len <= 0 || len >= (int)sizeof(req)) return -1;
+  if (client.write((const uint8_t*)req, len) != (size_t)len) return -1;
+
+  if (readLine(line, sizeof(line)) < 12 || strncmp(line, "HTTP/1.", 7) != 0) return -1;
+  int code = atoi(line + 9);
+
+  // Pic d'occupation du tas : tampons TLS alloues, reponse en cours
+  uint32_t heap = ESP.getFreeHeap();
+  if (heap < heapMin) heapMin = heap;
+
+  long contentLength = -1;
+  bool chunked = false;
+  bool closeAfter = false;
+  for (;;) {
+    int n = readLine(line, sizeof(line));
+    if (n < 0) return -1;
+    if (n == 0) break;
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      contentLength = atol(line + 15);
+    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+      chunked = strstr(line + 18, "chunked") != nullptr;
+    } else if (strncasecmp(line, "Connection:", 11) == 0) {
+      closeAfter = strstr(line + 11, "close") != nullptr;
+    }
+  }
+
+  parser.begin();
+  bool ok;
+  if (chunked) {
+    ok = false;
+    for (;;) {
+      if (readLine(line, sizeof(line)) < 0) break;
+      long size = strtol(line, nullptr, 16);
+      if (size == 0) {
+        readLine(line, sizeof(line));   // ligne vide finale
+        ok = true;
+        break;
+      }
+      if (!readBody(size) || readLine(line, sizeof(line)) < 0) break;
+    }
+  } else {
+    ok = readBody(contentLength);
+    closeAfter |= contentLength < 0;
+  }
+
+  if (!ok || closeAfter) client.stop();
+  return ok ? code : -1;
+}
+
 void fetchBitcoinPrice() {
   if (WiFi.status() != WL_CONNECTED) {
     return;
@@ -88,43 +224,50 @@ void fetchBitcoinPrice() {
   u8g2.drawStr(100, 63, "...");
   u8g2.sendBuffer();
 
-  client.setInsecure();  // Skip certificate verification
-
-  HTTPClient https;
-
-  String url = "https://" + String(API_HOST) + String(API_PATH);
+  unsigned long t0 = millis();
+  fetchCount++;
 
-  if (https.begin(client, url)) {
-    int httpCode = https.GET();
-
-    if (httpCode == HTTP_CODE_OK) {
-      String payload = https.getString();
-
-      // Parser JSON
-      StaticJsonDocument<256> doc;
-      DeserializationError error = deserializeJson(doc, payload);
-
-      if (!error) {
-        btcPrice = doc["bitcoin"]["usd"].as<float>();
-        btcChange24h = doc["bitcoin"]["usd_24h_change"].as<float>();
-        dataValid = true;
+  // Connexion gardee d'un appel a l'autre ; si le serveur l'a fermee,
+  // la session TLS memorisee evite un handshake complet
+  bool reused = client.connected();
+  bool connected = reused;
+  if (!connected) {
+    tlsConnects++;
+    connected = client.connect(API_HOST, API_PORT);
+  }
+  int httpCode = connected ? httpGet() : -1;
+
+  // Connexion morte entre deux appels : un seul nouvel essai
+  if (httpCode < 0 && reused) {
+    client.stop();
+    reused = false;
+    tlsConnects++;
+    if (client.connect(API_HOST, API_PORT)) httpCode = httpGet();
+  }
 
-        // Mettre a jour l'heure
-        time_t now = time(nullptr);
-        struct tm* ti = localtime(&now);
-        sprintf(lastUpdateTime, "%02d:%02d", ti->tm_hour, ti->tm_min);
+  if (httpCode == 200 && parser.complete()) {
+    btcPrice = parser.price;
+    btcChange24h = parser.change;
+    dataValid = true;
 
-        Serial.printf("BTC: $%.2f (%.2f%%)\n", btcPrice, btcChange24h);
-      } else {
-        Serial.println("JSON parse error");
-      }
-    } else {
-      Serial.printf("HTTP error: %d\n", httpCode);
-    }
+    // Mettre a jour l'heure
+    time_t now = time(nullptr);
+    struct tm* ti = localtime(&now);
+    sprintf(lastUpdateTime, "%02d:%02d", ti->tm_hour, ti->tm_min);
 
-    https.end();
+    Serial.printf("BTC: $%.2f (%.2f%%)\n", btcPrice, btcChange24h);
+  } else {
+    fetchFail++;
+    Serial.printf("HTTP error: %d\n", httpCode);
   }
 
+  // Une ligne cle=valeur par requete, facile a tracer sur plusieurs jours
+  Serial.printf("HEAP free=%u max_block=%u frag=%u min_free=%u fetch=%u fail=%u"
+                " tls_connects=%u reused=%d mfln=%d ms=%lu\n",
+                ESP.getFreeHeap(), ESP.getMaxFreeBlockSize(), ESP.getHeapFragmentation(),
+                heapMin, fetchCount, fetchFail, tlsConnects, reused, tlsMfln,
+                millis() - t0);
+
   lastUpdate = millis();
 }
 
@@ -219,6 +362,7 @@ void setup() {
 
   u8g2.begin();
   setupWiFi();
+  setupTLS();
 
   // Premier fetch
   fetchBitcoinPrice();
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+#
+# Stand-in HTTPS local de CoinGecko simple/price pour Bitcoin_Ticker
+#
+# Reponses HTTP/1.1 keep-alive, en Content-Length ou en chunked (--chunked)
+# pour exercer les deux chemins du decodeur. Dans le sketch :
+#   API_HOST = "<ip du PC>"   API_PORT = 8443
+#
+# Certificat auto-signe (le sketch ne le verifie pas) :
+#   openssl req -x509 -newkey rsa:2048 -nodes -keyout key.pem -out cert.pem \
+#           -days 365 -subj /CN=standin
+#
+# Usage : ./price_standin.py [--port 8443] [--chunked]
+#
+
+import argparse
+import json
+import random
+import ssl
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+price = 67000.0
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"   # keep-alive
+    chunked = False
+
+    def do_GET(self):
+        global price
+        if not self.path.startswith("/api/v3/simple/price"):
+            self.send_error(404)
+            return
+        price *= 1 + random.uniform(-0.003, 0.003)
+        body = json.dumps({"bitcoin": {"usd": round(price, 2),
+                                       "usd_24h_change": round(random.uniform(-5, 5), 3)}},
+                          separators=(",", ":")).encode()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        if self.chunked:
+            self.send_header("Transfer-Encoding", "chunked")
+            self.end_headers()
+            half = len(body) // 2
+            for part in (body[:half], body[half:]):
+                self.wfile.write(b"%x\r\n%s\r\n" % (len(part), part))
+            self.wfile.write(b"0\r\n\r\n")
+        else:
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--port", type=int, default=8443)
+    ap.add_argument("--chunked", action="store_true")
+    ap.add_argument("--cert", default="cert.pem")
+    ap.add_argument("--key", default="key.pem")
+    args = ap.parse_args()
+
+    Handler.chunked = args.chunked
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    ctx.load_cert_chain(args.cert, args.key)
+    server = ThreadingHTTPServer(("0.0.0.0", args.port), Handler)
+    server.socket = ctx.wrap_socket(server.socket, server_side=True)
+    print("stand-in simple/price sur https://0.0.0.0:%d (%s)"
+          % (args.port, "chunked" if args.chunked else "Content-Length"))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,95 @@
+/*
+ * simple_price.h - Decodeur en flux de la reponse CoinGecko simple/price
+ *
+ * {"bitcoin":{"usd":67012.3,"usd_24h_change":-1.234}}
+ * Lu caractere par caractere depuis la socket : ni payload en memoire,
+ * ni document JSON, seuls la derniere cle et le nombre en cours sont
+ * gardes (~40 octets). Aucune dependance Arduino (testable sur PC).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+class SimplePriceParser {
+public:
+  float price;
+  float change;
+
+  void begin() {
+    memset(this, 0, sizeof(*this));
+  }
+
+  bool complete() const { return hasPrice && hasChange; }
+
+  void feed(char ch) {
+    if (inString) {
+      if (escape) {
+        escape = false;
+      } else if (ch == '\\') {
+        escape = true;
+      } else if (ch == '"') {
+        inString = false;
+        key[keyLen] = '\0';
+      } else if (keyLen < sizeof(key) - 1) {
+        key[keyLen++] = ch;
+      }
+      return;
+    }
+
+    switch (ch) {
+      case '"':
+        inString = true;
+        keyLen = 0;
+        break;
+      case '{':
+      case '[':
+        depth++;
+        break;
+      case '}':
+      case ']':
+        endNumber();
+        depth--;
+        break;
+      case ',':
+        endNumber();
+        break;
+      case ':':
+        inValue = true;
+        numLen = 0;
+        break;
+      default:
+        if (inValue && numLen < sizeof(num) - 1 &&
+            ((ch >= '0' && ch <= '9') || ch == '.' || ch == '-' || ch == '+' ||
+             ch == 'e' || ch == 'E')) {
+          num[numLen++] = ch;
+        }
+        break;
+    }
+  }
+
+private:
+  // Valeur numerique d'une cle de l'objet "bitcoin" (profondeur 2)
+  void endNumber() {
+    if (inValue && numLen && depth == 2) {
+      num[numLen] = '\0';
+      if (strcmp(key, "usd") == 0) {
+        price = strtof(num, nullptr);
+        hasPrice = true;
+      } else if (strcmp(key, "usd_24h_change") == 0) {
+        change = strtof(num, nullptr);
+        hasChange = true;
+      }
+    }
+    inValue = false;
+    numLen = 0;
+  }
+
+  char key[16];
+  char num[24];
+  uint8_t keyLen, numLen;
+  int8_t depth;
+  bool inString, escape, inValue, hasPrice, hasChange;
+};
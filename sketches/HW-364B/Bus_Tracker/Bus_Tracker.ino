@@ -26,6 +26,8 @@
 #include <time.h>
 #include "credentials.h"
 #include "prim_config.h"
+#include "html_stream.h"
+#include "json_writer.h"
 
 // Configuration OLED
 U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2(
@@ -37,6 +39,7 @@ U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2(
 
 #define YELLOW_ZONE_HEIGHT 16
 #define MAX_DEPARTURES 2
+#define API_JSON_MAX 384             // reponse /api, texte echappe compris
 
 // Intervalles selon plages horaires (en millisecondes)
 #define INTERVAL_RUSH_HOUR 30000      // 30s pour rester sous 1000 req/jour (limite API PRIM)
@@ -444,9 +447,8 @@ void updateDisplay() {
   u8g2.sendBuffer();
 }
 
-// === Pages Web ===
-void handleRoot() {
-  String html = R"=====(
+// === Pages Web (stockee en PROGMEM, champs {{nom}} remplis par rootField) ===
+const char PAGE_ROOT[] PROGMEM = R"=====(
 <!DOCTYPE html>
 <html>
 <head>
@@ -498,11 +500,7 @@ void handleRoot() {
 <body>
   <h1>Bus Tracker</h1>
   <div class="card">
-    <h3>)=====";
-  html += config.lineName;
-  html += " - ";
-  html += config.stopName;
-  html += R"=====(</h3>
+    <h3>{{lineName}} - {{stopName}}</h3>
     <div class="departures" id="deps">Chargement...</div>
     <div class="info">Mise a jour: ~1 min (6h-9h, 16h-18h), ~2 min (autres), veille (20h-6h)</div>
   </div>
@@ -511,25 +509,15 @@ void handleRoot() {
     <h3>Configuration</h3>
     <form action="/config" method="POST">
       <label>ID Arret (ex: 413248)</label>
-      <input type="text" name="stopId" value=")=====";
-  html += config.stopId;
-  html += R"=====(">
+      <input type="text" name="stopId" value="{{stopId}}">
       <label>Nom Arret</label>
-      <input type="text" name="stopName" value=")=====";
-  html += config.stopName;
-  html += R"=====(">
+      <input type="text" name="stopName" value="{{stopName}}">
       <label>Ligne (affichage)</label>
-      <input type="text" name="lineName" value=")=====";
-  html += config.lineName;
-  html += R"=====(">
+      <input type="text" name="lineName" value="{{lineName}}">
       <label>ID Ligne (ex: C01252)</label>
-      <input type="text" name="lineRef" value=")=====";
-  html += config.lineRef;
-  html += R"=====(">
+      <input type="text" name="lineRef" value="{{lineRef}}">
       <label>Direction</label>
-      <input type="text" name="direction" value=")=====";
-  html += config.direction;
-  html += R"=====(">
+      <input type="text" name="direction" value="{{direction}}">
       <button type="submit">Enregistrer</button>
     </form>
     <div class="info">
@@ -563,32 +551,61 @@ void handleRoot() {
 </html>
 )=====";
 
-  server.send(200, "text/html", html);
+// Valeurs des champs {{nom}} de PAGE_ROOT (saisies utilisateur, donc echappees)
+void rootField(HtmlStream& out, const char* name) {
+  if (!strcmp(name, "stopId")) out.escaped(config.stopId);
+  else if (!strcmp(name, "stopName")) out.escaped(config.stopName);
+  else if (!strcmp(name, "lineName")) out.escaped(config.lineName);
+  else if (!strcmp(name, "lineRef")) out.escaped(config.lineRef);
+  else if (!strcmp(name, "direction")) out.escaped(config.direction);
+}
+
+void sendChunk(const char* data, size_t len) {
+  server.sendContent(data, len);
+}
+
+// Page envoyee en chunked par blocs de HTML_STREAM_BUF, sans String
+void handleRoot() {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/html", "");
+
+  HtmlStream out(sendChunk);
+  out.render_P(PAGE_ROOT, rootField);
+  out.flush();
+  server.sendContent("");
+}
+
+// Reponse depuis le tampon JSON ; 500 si le JSON n'y a pas tenu
+void sendJson(const JsonWriter& json) {
+  if (!json.ok()) {
+    server.send(500, "application/json", "{\"error\":\"json overflow\"}");
+    return;
+  }
+  server.setContentLength(json.length());
+  server.send(200, "application/json", "");
+  server.sendContent(json.c_str(), json.length());
 }
 
 void handleApi() {
-  String json = "{\"departures\":[";
+  char buf[API_JSON_MAX];
+  JsonWriter json(buf, sizeof(buf));
 
+  json.beginObject();
+  json.beginArray("departures");
   for (int i = 0; i < departureCount; i++) {
-    if (i > 0) json += ",";
-    json += "{\"minutes\":";
-    json += departures[i].minutesLeft;
-    json += ",\"destination\":\"";
-    json += departures[i].destination;
-    json += "\",\"atStop\":";
-    json += departures[i].atStop ? "true" : "false";
-    json += "}";
+    json.beginObject();
+    json.number("minutes", departures[i].minutesLeft);
+    json.string("destination", departures[i].destination);
+    json.boolean("atStop", departures[i].atStop);
+    json.endObject();
   }
+  json.endArray();
+  json.string("stopName", config.stopName);
+  json.string("lineName", config.lineName);
+  json.string("lastUpdate", lastUpdateTime);
+  json.endObject();
 
-  json += "],\"stopName\":\"";
-  json += config.stopName;
-  json += "\",\"lineName\":\"";
-  json += config.lineName;
-  json += "\",\"lastUpdate\":\"";
-  json += lastUpdateTime;
-  json += "\"}";
-
-  server.send(200, "application/json", json);
+  sendJson(json);
 }
 
 void handleRefresh() {
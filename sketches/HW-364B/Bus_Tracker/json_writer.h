@@ -0,0 +1,137 @@
+/*
+ * json_writer.h - Ecriture JSON dans un tampon fixe, sans String
+ *
+ * Les virgules sont gerees automatiquement ; les chaines sont echappees
+ * (guillemets, antislash, caracteres de controle), le texte saisi par
+ * l'utilisateur ne peut donc pas casser le JSON. Si le tampon est trop
+ * petit, l'ecriture s'arrete, ok() renvoie false et le tampon reste une
+ * chaine terminee : l'appelant repond une erreur au lieu d'un JSON coupe.
+ *
+ * Meme fichier dans Mini_Dashboard, Bus_Tracker et NTP_Clock.
+ * Aucune dependance Arduino (testable sur PC).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define JSON_DEPTH_MAX 8
+
+class JsonWriter {
+public:
+  JsonWriter(char *buf, size_t size)
+    : buf(buf), size(size), len(0), depth(0), overflowed(size == 0), first(0) {
+    if (size > 0) buf[0] = '\0';
+  }
+
+  // key : nom du membre dans un objet, nullptr dans un tableau
+  void beginObject(const char *key = nullptr) { open(key, '{'); }
+  void endObject() { close('}'); }
+  void beginArray(const char *key = nullptr) { open(key, '['); }
+  void endArray() { close(']'); }
+
+  void number(const char *key, long v) {
+    char tmp[21];
+    char *p = tmp + sizeof(tmp);
+    unsigned long u = v < 0 ? 0ul - (unsigned long)v : (unsigned long)v;
+    do {
+      *--p = '0' + u % 10;
+      u /= 10;
+    } while (u);
+    if (v < 0) *--p = '-';
+    member(key);
+    raw(p, tmp + sizeof(tmp) - p);
+  }
+
+  void boolean(const char *key, bool v) {
+    member(key);
+    raw(v ? "true" : "false");
+  }
+
+  void string(const char *key, const char *s) {
+    member(key);
+    quoted(s);
+  }
+
+  bool ok() const { return !overflowed && depth == 0; }
+  size_t length() const { return len; }     // octets ecrits, sans le '\0'
+  const char *c_str() const { return buf; }
+
+private:
+  void open(const char *key, char c) {
+    member(key);
+    raw(&c, 1);
+    if (depth < JSON_DEPTH_MAX) {
+      depth++;
+      first |= 1u << depth;
+    } else {
+      overflowed = true;
+    }
+  }
+
+  void close(char c) {
+    if (depth == 0) {
+      overflowed = true;
+      return;
+    }
+    depth--;
+    raw(&c, 1);
+  }
+
+  // Virgule avant tout element sauf le premier du conteneur, puis la cle
+  void member(const char *key) {
+    if (first & (1u << depth)) first &= ~(1u << depth);
+    else if (depth > 0) raw(",", 1);
+    if (key) {
+      quoted(key);
+      raw(":", 1);
+    }
+  }
+
+  // Les suites sans echappement (UTF-8 compris) sont copiees d'un bloc
+  void quoted(const char *s) {
+    raw("\"", 1);
+    for (;;) {
+      const char *run = s;
+      while ((uint8_t)*s >= 0x20 && *s != '"' && *s != '\\') s++;
+      raw(run, s - run);
+      uint8_t c = *s;
+      if (c == '\0') break;
+      s++;
+      switch (c) {
+        case '"': raw("\\\"", 2); break;
+        case '\\': raw("\\\\", 2); break;
+        case '\n': raw("\\n", 2); break;
+        case '\r': raw("\\r", 2); break;
+        case '\t': raw("\\t", 2); break;
+        default: {
+          char tmp[7];
+          raw(tmp, snprintf(tmp, sizeof(tmp), "\\u%04x", c));
+        }
+      }
+    }
+    raw("\"", 1);
+  }
+
+  void raw(const char *s) { raw(s, strlen(s)); }
+
+  void raw(const char *s, size_t n) {
+    if (overflowed) return;
+    if (len + n >= size) {
+      overflowed = true;
+      return;
+    }
+    memcpy(buf + len, s, n);
+    len += n;
+    buf[len] = '\0';
+  }
+
+  char *buf;
+  size_t size;
+  size_t len;
+  uint8_t depth;
+  bool overflowed;
+  uint32_t first;   // bit n : aucun element encore ecrit au niveau n
+};
@@ -4,6 +4,11 @@
  * Dashboard web avec controles (sliders, boutons, toggles).
  * L'ecran OLED affiche l'etat en temps reel.
  *
+ * Les pages ouvertes recoivent les changements d'etat par /events
+ * (Server-Sent Events) au lieu d'interroger /api toutes les 2 s.
+ * Ligne "web,<req api>,<evenements>,<onglets>,<tas libre>,<plus grand bloc>"
+ * sur le port serie toutes les 30 s.
+ *
  * Pins OLED sur HW-364B:
  *   SDA -> GPIO14 (D5)
  *   SCL -> GPIO12 (D6)
@@ -19,6 +24,8 @@
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
 #include "credentials.h"
+#include "html_stream.h"
+#include "json_writer.h"
 
 // Configuration OLED
 U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2(
@@ -47,8 +54,26 @@ struct DashboardState {
 unsigned long lastDisplayUpdate = 0;
 bool displayNeedsUpdate = true;
 
-// === Page Web (stockee en PROGMEM) ===
-const char HTML_PART1[] PROGMEM = R"=====(
+// Evenements serveur (SSE) : une connexion /events par onglet ouvert
+#define SSE_MAX_CLIENTS 4
+#define SSE_EVENT_MAX 192
+#define API_JSON_MAX 256
+#define SSE_KEEPALIVE_MS 15000
+
+WiFiClient sseClients[SSE_MAX_CLIENTS];
+uint8_t sseNext = 0;           // connexion remplacee quand tout est pris
+DashboardState sseSent;        // dernier etat pousse aux onglets
+int sseRssi = 0;
+unsigned long lastSseKeepAlive = 0;
+
+// Statistiques web
+#define WEB_LOG_INTERVAL 30000
+uint32_t apiRequests = 0;
+uint32_t sseEvents = 0;
+unsigned long lastWebLog = 0;
+
+// === Page Web (stockee en PROGMEM, champs {{nom}} remplis par rootField) ===
+const char PAGE_ROOT[] PROGMEM = R"=====(
 <!DOCTYPE html>
 <html>
 <head>
@@ -130,23 +155,15 @@ const char HTML_PART1[] PROGMEM = R"=====(
     <div class="card">
       <h3>LUMINOSITE</h3>
       <div class="slider-container">
-        <input type="range" class="slider" id="brightness" min="0" max="100" value=")=====";
-
-const char HTML_PART2[] PROGMEM = R"=====(">
-        <span class="value" id="brightnessVal">)=====";
-
-const char HTML_PART3[] PROGMEM = R"=====(%</span>
+        <input type="range" class="slider" id="brightness" min="0" max="100" value="{{brightness}}">
+        <span class="value" id="brightnessVal">{{brightness}}%</span>
       </div>
     </div>
     <div class="card">
       <h3>TEMPERATURE</h3>
       <div class="slider-container">
-        <input type="range" class="slider" id="temp" min="16" max="30" value=")=====";
-
-const char HTML_PART4[] PROGMEM = R"=====(">
-        <span class="value" id="tempVal">)=====";
-
-const char HTML_PART5[] PROGMEM = R"=====(&deg;C</span>
+        <input type="range" class="slider" id="temp" min="16" max="30" value="{{temperature}}">
+        <span class="value" id="tempVal">{{temperature}}&deg;C</span>
       </div>
     </div>
     <div class="card">
@@ -180,15 +197,7 @@ const char HTML_PART5[] PROGMEM = R"=====(&deg;C</span>
   </div>
   <div class="info" id="info">Connexion...</div>
 <script>
-var brightness=)=====";
-
-const char HTML_PART6[] PROGMEM = R"=====(,temperature=)=====";
-const char HTML_PART7[] PROGMEM = R"=====(,mode=)=====";
-const char HTML_PART8[] PROGMEM = R"=====(,ledOn=)=====";
-const char HTML_PART9[] PROGMEM = R"=====(,soundOn=)=====";
-const char HTML_PART10[] PROGMEM = R"=====(,counter=)=====";
-
-const char HTML_SCRIPT[] PROGMEM = R"=====(;
+var brightness={{brightness}},temperature={{temperature}},mode={{mode}},ledOn={{ledOn}},soundOn={{soundOn}},counter={{counter}};
 function $(id){return document.getElementById(id);}
 function upd(p,v){
   var x=new XMLHttpRequest();
@@ -196,19 +205,28 @@ function upd(p,v){
   x.onload=function(){if(x.status==200){var d=JSON.parse(x.responseText);sync(d);}};
   x.send();
 }
+var ip="...",rssi=0;
 function sync(d){
-  $("brightness").value=d.brightness;
-  $("brightnessVal").textContent=d.brightness+"%";
-  $("temp").value=d.temperature;
-  $("tempVal").textContent=d.temperature+"\u00B0C";
-  var btns=$("modeGrp").getElementsByClassName("btn");
-  for(var i=0;i<btns.length;i++){
-    btns[i].className=btns[i].getAttribute("data-mode")==d.mode?"btn active":"btn";
+  if("brightness" in d){
+    $("brightness").value=d.brightness;
+    $("brightnessVal").textContent=d.brightness+"%";
+  }
+  if("temperature" in d){
+    $("temp").value=d.temperature;
+    $("tempVal").textContent=d.temperature+"\u00B0C";
   }
-  $("led").className=d.ledOn?"toggle on":"toggle";
-  $("sound").className=d.soundOn?"toggle on":"toggle";
-  $("counter").textContent=d.counter;
-  $("info").textContent="IP: "+d.ip+" | RSSI: "+d.rssi+" dBm";
+  if("mode" in d){
+    var btns=$("modeGrp").getElementsByClassName("btn");
+    for(var i=0;i<btns.length;i++){
+      btns[i].className=btns[i].getAttribute("data-mode")==d.mode?"btn active":"btn";
+    }
+  }
+  if("ledOn" in d)$("led").className=d.ledOn?"toggle on":"toggle";
+  if("soundOn" in d)$("sound").className=d.soundOn?"toggle on":"toggle";
+  if("counter" in d)$("counter").textContent=d.counter;
+  if("ip" in d)ip=d.ip;
+  if("rssi" in d)rssi=d.rssi;
+  $("info").textContent="IP: "+ip+" | RSSI: "+rssi+" dBm";
 }
 $("brightness").oninput=function(){$("brightnessVal").textContent=this.value+"%";};
 $("brightness").onchange=function(){upd("brightness",this.value);};
@@ -223,48 +241,64 @@ $("sound").onclick=function(){upd("sound","toggle");};
 $("counter").onclick=function(){upd("counter","inc");};
 $("sendBtn").onclick=function(){var m=$("msg").value;if(m)upd("message",encodeURIComponent(m));};
 $("msg").onkeypress=function(e){if(e.key=="Enter"){$("sendBtn").click();}};
-sync({brightness:brightness,temperature:temperature,mode:mode,ledOn:ledOn,soundOn:soundOn,counter:counter,ip:"...",rssi:0});
-setInterval(function(){
-  var x=new XMLHttpRequest();
-  x.open("GET","/api",true);
-  x.onload=function(){if(x.status==200){sync(JSON.parse(x.responseText));}};
-  x.send();
-},2000);
+sync({brightness:brightness,temperature:temperature,mode:mode,ledOn:ledOn,soundOn:soundOn,counter:counter});
+if(window.EventSource){
+  // Seuls les champs modifies arrivent ; reconnexion automatique du navigateur
+  var es=new EventSource("/events");
+  es.onmessage=function(e){sync(JSON.parse(e.data));};
+  es.onerror=function(){$("info").textContent="Reconnexion...";};
+}else{
+  setInterval(function(){
+    var x=new XMLHttpRequest();
+    x.open("GET","/api",true);
+    x.onload=function(){if(x.status==200){sync(JSON.parse(x.responseText));}};
+    x.send();
+  },2000);
+}
 </script>
 </body>
 </html>
 )=====";
 
+// Valeurs des champs {{nom}} de PAGE_ROOT
+void rootField(HtmlStream& out, const char* name) {
+  if (!strcmp(name, "brightness")) out.number(state.brightness);
+  else if (!strcmp(name, "temperature")) out.number(state.temperature);
+  else if (!strcmp(name, "mode")) out.number(state.mode);
+  else if (!strcmp(name, "ledOn")) out.text(state.ledOn ? "true" : "false");
+  else if (!strcmp(name, "soundOn")) out.text(state.soundOn ? "true" : "false");
+  else if (!strcmp(name, "counter")) out.number(state.counter);
+}
+
+void sendChunk(const char* data, size_t len) {
+  server.sendContent(data, len);
+}
+
+// Page envoyee en chunked par blocs de HTML_STREAM_BUF, sans String
 void handleRoot() {
-  String html;
-  html.reserve(4000);
-
-  html += FPSTR(HTML_PART1);
-  html += String(state.brightness);
-  html += FPSTR(HTML_PART2);
-  html += String(state.brightness);
-  html += FPSTR(HTML_PART3);
-  html += String(state.temperature);
-  html += FPSTR(HTML_PART4);
-  html += String(state.temperature);
-  html += FPSTR(HTML_PART5);
-  html += String(state.brightness);
-  html += FPSTR(HTML_PART6);
-  html += String(state.temperature);
-  html += FPSTR(HTML_PART7);
-  html += String(state.mode);
-  html += FPSTR(HTML_PART8);
-  html += String(state.ledOn ? "true" : "false");
-  html += FPSTR(HTML_PART9);
-  html += String(state.soundOn ? "true" : "false");
-  html += FPSTR(HTML_PART10);
-  html += String(state.counter);
-  html += FPSTR(HTML_SCRIPT);
-
-  server.send(200, "text/html", html);
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/html", "");
+
+  HtmlStream out(sendChunk);
+  out.render_P(PAGE_ROOT, rootField);
+  out.flush();
+  server.sendContent("");
+}
+
+// Reponse depuis le tampon JSON ; 500 si le JSON n'y a pas tenu
+void sendJson(const JsonWriter& json) {
+  if (!json.ok()) {
+    server.send(500, "application/json", "{\"error\":\"json overflow\"}");
+    return;
+  }
+  server.setContentLength(json.length());
+  server.send(200, "application/json", "");
+  server.sendContent(json.c_str(), json.length());
 }
 
 void handleApi() {
+  apiRequests++;
+
   // Traitement des parametres
   if (server.hasArg("brightness")) {
     state.brightness = constrain(server.arg("brightness").toInt(), 0, 100);
@@ -297,19 +331,128 @@ void handleApi() {
   }
 
   // Reponse JSON
-  String json = "{";
-  json += "\"brightness\":" + String(state.brightness) + ",";
-  json += "\"temperature\":" + String(state.temperature) + ",";
-  json += "\"mode\":" + String(state.mode) + ",";
-  json += "\"ledOn\":" + String(state.ledOn ? "true" : "false") + ",";
-  json += "\"soundOn\":" + String(state.soundOn ? "true" : "false") + ",";
-  json += "\"counter\":" + String(state.counter) + ",";
-  json += "\"message\":\"" + String(state.message) + "\",";
-  json += "\"ip\":\"" + WiFi.localIP().toString() + "\",";
-  json += "\"rssi\":" + String(WiFi.RSSI());
-  json += "}";
-
-  server.send(200, "application/json", json);
+  char buf[API_JSON_MAX];
+  char ip[16];
+  IPAddress addr = WiFi.localIP();
+  sprintf(ip, "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+
+  JsonWriter json(buf, sizeof(buf));
+  json.beginObject();
+  json.number("brightness", state.brightness);
+  json.number("temperature", state.temperature);
+  json.number("mode", state.mode);
+  json.boolean("ledOn", state.ledOn);
+  json.boolean("soundOn", state.soundOn);
+  json.number("counter", state.counter);
+  json.string("message", state.message);
+  json.string("ip", ip);
+  json.number("rssi", WiFi.RSSI());
+  json.endObject();
+
+  sendJson(json);
+}
+
+// === Evenements serveur (SSE) ===
+
+// Evenement "data: {...}" avec les seuls champs changes depuis sseSent
+// (tous si full). Renvoie 0 si rien n'a change.
+size_t buildEvent(char* buf, size_t size, bool full, int rssi) {
+  const char prefix[] = "data: ";
+  const size_t head = sizeof(prefix) - 1;
+  JsonWriter json(buf + head, size - head - 2);   // place pour "\n\n"
+
+  json.beginObject();
+  if (full || state.brightness != sseSent.brightness) json.number("brightness", state.brightness);
+  if (full || state.temperature != sseSent.temperature) json.number("temperature", state.temperature);
+  if (full || state.mode != sseSent.mode) json.number("mode", state.mode);
+  if (full || state.ledOn != sseSent.ledOn) json.boolean("ledOn", state.ledOn);
+  if (full || state.soundOn != sseSent.soundOn) json.boolean("soundOn", state.soundOn);
+  if (full || state.counter != sseSent.counter) json.number("counter", state.counter);
+  if (full || rssi != sseRssi) json.number("rssi", rssi);
+  if (full) {
+    char ip[16];
+    IPAddress addr = WiFi.localIP();
+    sprintf(ip, "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+    json.string("ip", ip);
+  }
+  if (json.length() == 1) return 0;     // "{" seul : rien n'a change
+  json.endObject();
+  if (!json.ok()) return 0;
+
+  size_t len = head + json.length();
+  memcpy(buf, prefix, head);
+  memcpy(buf + len, "\n\n", 3);
+  return len + 2;
+}
+
+// Meme message ecrit sur toutes les connexions : le cout ne depend pas du
+// nombre d'onglets. Une connexion qui n'accepte plus les donnees est fermee.
+void sseSend(const char* data, size_t len) {
+  for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+    if (!sseClients[i]) continue;
+    if (sseClients[i].write((const uint8_t*)data, len) != len) sseClients[i].stop();
+  }
+}
+
+// Pousse aux onglets ouverts le delta depuis le dernier envoi.
+// Renvoie false si rien n'avait change.
+bool ssePushState() {
+  char event[SSE_EVENT_MAX];
+  int rssi = WiFi.RSSI();
+  size_t len = buildEvent(event, sizeof(event), false, rssi);
+  if (len == 0) return false;
+  sseSend(event, len);
+  sseEvents++;
+  sseSent = state;
+  sseRssi = rssi;
+  return true;
+}
+
+// Toutes les SSE_KEEPALIVE_MS : RSSI mis a jour s'il a change, sinon un
+// commentaire SSE, pour garder les connexions et detecter les onglets fermes
+void sseKeepAlive() {
+  if (millis() - lastSseKeepAlive < SSE_KEEPALIVE_MS) return;
+  lastSseKeepAlive = millis();
+  if (!ssePushState()) sseSend(":\n\n", 3);
+}
+
+void handleEvents() {
+  int slot = -1;
+  for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+    if (!sseClients[i]) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0) {
+    slot = sseNext;
+    sseNext = (sseNext + 1) % SSE_MAX_CLIENTS;
+    sseClients[slot].stop();
+  }
+
+  // La connexion reste ouverte apres le retour du handler : on garde une
+  // copie du client et on ecrit l'en-tete directement
+  WiFiClient client = server.client();
+  client.setNoDelay(true);
+  client.print(F("HTTP/1.1 200 OK\r\n"
+                 "Content-Type: text/event-stream\r\n"
+                 "Cache-Control: no-cache\r\n"
+                 "Connection: keep-alive\r\n\r\n"
+                 "retry: 3000\n\n"));
+
+  // Etat complet pour ce seul onglet
+  char event[SSE_EVENT_MAX];
+  size_t len = buildEvent(event, sizeof(event), true, WiFi.RSSI());
+  client.write((const uint8_t*)event, len);
+  sseClients[slot] = client;
+}
+
+int sseClientCount() {
+  int n = 0;
+  for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+    if (sseClients[i]) n++;
+  }
+  return n;
 }
 
 void setupWiFi() {
@@ -418,12 +561,14 @@ void setup() {
 
   server.on("/", handleRoot);
   server.on("/api", handleApi);
+  server.on("/events", handleEvents);
   server.begin();
 
   Serial.print("Dashboard: http://");
   Serial.println(WiFi.localIP());
 
   displayNeedsUpdate = true;
+  sseSent = state;
 }
 
 void loop() {
@@ -431,8 +576,18 @@ void loop() {
 
   // Mise a jour affichage si necessaire ou toutes les secondes
   if (displayNeedsUpdate || millis() - lastDisplayUpdate >= 1000) {
+    if (displayNeedsUpdate) ssePushState();
     lastDisplayUpdate = millis();
     displayNeedsUpdate = false;
     updateDisplay();
   }
+  sseKeepAlive();
+
+  // Requetes /api, evenements pousses, onglets connectes, tas
+  if (millis() - lastWebLog >= WEB_LOG_INTERVAL) {
+    lastWebLog = millis();
+    Serial.printf("web,%lu,%lu,%d,%lu,%lu\n", (unsigned long)apiRequests,
+                  (unsigned long)sseEvents, sseClientCount(),
+                  (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMaxFreeBlockSize());
+  }
 }
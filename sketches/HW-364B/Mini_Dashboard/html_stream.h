@@ -0,0 +1,133 @@
+/*
+ * html_stream.h - Rendu de page HTML en flux, sans String
+ *
+ * Le modele reste en PROGMEM ; les champs {{nom}} sont remplis par un
+ * callback qui ecrit directement dans le flux (nombres, texte echappe).
+ * Tout passe par un tampon fixe de HTML_STREAM_BUF octets vide a chaque
+ * remplissage vers la fonction d'envoi (server.sendContent en chunked) :
+ * aucune allocation par requete, quelle que soit la taille de la page.
+ *
+ * Meme fichier dans Mini_Dashboard, Bus_Tracker et NTP_Clock.
+ * Aucune dependance Arduino hors pgmspace (testable sur PC).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(ARDUINO)
+#include <pgmspace.h>
+#else
+#define PGM_P const char *
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define memcpy_P memcpy
+#endif
+
+#ifndef HTML_STREAM_BUF
+#define HTML_STREAM_BUF 512
+#endif
+
+#define HTML_FIELD_MAX 16
+
+class HtmlStream {
+public:
+  typedef void (*Sink)(const char *data, size_t len);
+  typedef void (*Field)(HtmlStream &out, const char *name);
+
+  explicit HtmlStream(Sink sink) : sink(sink), len(0), total(0) {}
+
+  void write(const char *data, size_t n) {
+    while (n > 0) {
+      size_t room = HTML_STREAM_BUF - len;
+      size_t k = n < room ? n : room;
+      memcpy(buf + len, data, k);
+      len += k;
+      data += k;
+      n -= k;
+      if (len == HTML_STREAM_BUF) flush();
+    }
+  }
+
+  void write_P(PGM_P data, size_t n) {
+    while (n > 0) {
+      size_t room = HTML_STREAM_BUF - len;
+      size_t k = n < room ? n : room;
+      memcpy_P(buf + len, data, k);
+      len += k;
+      data += k;
+      n -= k;
+      if (len == HTML_STREAM_BUF) flush();
+    }
+  }
+
+  void text(const char *s) { write(s, strlen(s)); }
+
+  void number(long v) {
+    char tmp[12];
+    write(tmp, snprintf(tmp, sizeof(tmp), "%ld", v));
+  }
+
+  // Texte utilisateur dans du HTML ou un attribut value="..."
+  void escaped(const char *s) {
+    for (; *s; s++) {
+      switch (*s) {
+        case '&': text("&amp;"); break;
+        case '<': text("&lt;"); break;
+        case '>': text("&gt;"); break;
+        case '"': text("&quot;"); break;
+        case '\'': text("&#39;"); break;
+        default: write(s, 1);
+      }
+    }
+  }
+
+  // Modele PROGMEM : le texte entre deux champs part en un seul bloc
+  void render_P(PGM_P tpl, Field field) {
+    PGM_P run = tpl;
+    PGM_P p = tpl;
+    for (;;) {
+      char c = pgm_read_byte(p);
+      if (c == '\0') break;
+      if (c != '{' || pgm_read_byte(p + 1) != '{') {
+        p++;
+        continue;
+      }
+      char name[HTML_FIELD_MAX];
+      size_t n = 0;
+      PGM_P q = p + 2;
+      while (n < sizeof(name) - 1) {
+        char k = pgm_read_byte(q);
+        if (k == '\0' || k == '}') break;
+        name[n++] = k;
+        q++;
+      }
+      if (pgm_read_byte(q) != '}' || pgm_read_byte(q + 1) != '}') {
+        p++;                // pas un champ : "{{" laisse tel quel
+        continue;
+      }
+      name[n] = '\0';
+      write_P(run, p - run);
+      field(*this, name);
+      p = q + 2;
+      run = p;
+    }
+    write_P(run, p - run);
+  }
+
+  void flush() {
+    if (len == 0) return;
+    sink(buf, len);
+    total += len;
+    len = 0;
+  }
+
+  size_t sent() const { return total + len; }
+
+private:
+  Sink sink;
+  char buf[HTML_STREAM_BUF];
+  size_t len;
+  size_t total;
+};
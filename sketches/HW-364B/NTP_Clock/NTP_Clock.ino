@@ -21,6 +21,8 @@
 #include <time.h>
 #include <EEPROM.h>
 #include "credentials.h"
+#include "html_stream.h"
+#include "json_writer.h"
 
 // Configuration OLED
 U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2(
@@ -31,6 +33,7 @@ U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2(
 );
 
 #define YELLOW_ZONE_HEIGHT 16
+#define API_JSON_MAX 160
 
 // Serveur web
 ESP8266WebServer server(80);
@@ -107,25 +110,9 @@ void setupWiFi() {
   }
 }
 
-// === Pages Web ===
+// === Pages Web (stockee en PROGMEM, champs {{nom}} remplis par rootField) ===
 
-void handleRoot() {
-  time_t now = time(nullptr);
-  struct tm* ti = localtime(&now);
-
-  char timeStr[10];
-  char dateStr[20];
-
-  if (config.format24h) {
-    sprintf(timeStr, "%02d:%02d:%02d", ti->tm_hour, ti->tm_min, ti->tm_sec);
-  } else {
-    int h = ti->tm_hour % 12;
-    if (h == 0) h = 12;
-    sprintf(timeStr, "%d:%02d:%02d %s", h, ti->tm_min, ti->tm_sec, ti->tm_hour >= 12 ? "PM" : "AM");
-  }
-  sprintf(dateStr, "%02d/%02d/%04d", ti->tm_mday, ti->tm_mon + 1, ti->tm_year + 1900);
-
-  String html = R"(
+const char PAGE_ROOT[] PROGMEM = R"=====(
 <!DOCTYPE html>
 <html>
 <head>
@@ -197,8 +184,8 @@ void handleRoot() {
 </head>
 <body>
   <div class="clock">
-    <div class="time">)" + String(timeStr) + R"(</div>
-    <div class="date">)" + String(dateStr) + R"(</div>
+    <div class="time">{{time}}</div>
+    <div class="date">{{date}}</div>
   </div>
 
   <div class="config">
@@ -206,39 +193,86 @@ void handleRoot() {
     <form action="/config" method="POST">
       <label>Fuseau horaire (UTC)</label>
       <select name="tz">
-)";
-
-  // Options timezone
-  for (int tz = -12; tz <= 14; tz++) {
-    html += "<option value=\"" + String(tz) + "\"";
-    if (tz == config.timezone) html += " selected";
-    html += ">UTC" + String(tz >= 0 ? "+" : "") + String(tz) + "</option>\n";
-  }
-
-  html += R"(
-      </select>
+{{tzOptions}}      </select>
 
       <label>Format</label>
       <select name="format">
-        <option value="24")" + String(config.format24h ? " selected" : "") + R"(>24 heures</option>
-        <option value="12")" + String(!config.format24h ? " selected" : "") + R"(>12 heures (AM/PM)</option>
+        <option value="24"{{sel24}}>24 heures</option>
+        <option value="12"{{sel12}}>12 heures (AM/PM)</option>
       </select>
 
       <label>Serveur NTP</label>
-      <input type="text" name="ntp" value=")" + String(config.ntpServer) + R"(">
+      <input type="text" name="ntp" value="{{ntp}}">
 
       <button type="submit">Enregistrer</button>
     </form>
   </div>
 
   <div class="info">
-    IP: )" + WiFi.localIP().toString() + R"( | RSSI: )" + String(WiFi.RSSI()) + R"( dBm
+    IP: {{ip}} | RSSI: {{rssi}} dBm
   </div>
 </body>
 </html>
-)";
+)=====";
+
+struct tm pageTime;   // heure de la requete en cours, lue par rootField
+
+// Valeurs des champs {{nom}} de PAGE_ROOT
+void rootField(HtmlStream& out, const char* name) {
+  char buf[24];
+  const struct tm* ti = &pageTime;
+
+  if (!strcmp(name, "time")) {
+    if (config.format24h) {
+      sprintf(buf, "%02d:%02d:%02d", ti->tm_hour, ti->tm_min, ti->tm_sec);
+    } else {
+      int h = ti->tm_hour % 12;
+      if (h == 0) h = 12;
+      sprintf(buf, "%d:%02d:%02d %s", h, ti->tm_min, ti->tm_sec, ti->tm_hour >= 12 ? "PM" : "AM");
+    }
+    out.text(buf);
+  } else if (!strcmp(name, "date")) {
+    sprintf(buf, "%02d/%02d/%04d", ti->tm_mday, ti->tm_mon + 1, ti->tm_year + 1900);
+    out.text(buf);
+  } else if (!strcmp(name, "tzOptions")) {
+    for (int tz = -12; tz <= 14; tz++) {
+      sprintf(buf, "<option value=\"%d\"", tz);
+      out.text(buf);
+      if (tz == config.timezone) out.text(" selected");
+      sprintf(buf, ">UTC%+d</option>\n", tz);
+      out.text(buf);
+    }
+  } else if (!strcmp(name, "sel24")) {
+    if (config.format24h) out.text(" selected");
+  } else if (!strcmp(name, "sel12")) {
+    if (!config.format24h) out.text(" selected");
+  } else if (!strcmp(name, "ntp")) {
+    out.escaped(config.ntpServer);
+  } else if (!strcmp(name, "ip")) {
+    IPAddress ip = WiFi.localIP();
+    sprintf(buf, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    out.text(buf);
+  } else if (!strcmp(name, "rssi")) {
+    out.number(WiFi.RSSI());
+  }
+}
 
-  server.send(200, "text/html", html);
+void sendChunk(const char* data, size_t len) {
+  server.sendContent(data, len);
+}
+
+// Page envoyee en chunked par blocs de HTML_STREAM_BUF, sans String
+void handleRoot() {
+  time_t now = time(nullptr);
+  localtime_r(&now, &pageTime);
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/html", "");
+
+  HtmlStream out(sendChunk);
+  out.render_P(PAGE_ROOT, rootField);
+  out.flush();
+  server.sendContent("");
 }
 
 void handleConfig() {
@@ -259,22 +293,35 @@ void handleConfig() {
   server.send(303);
 }
 
+// Reponse depuis le tampon JSON ; 500 si le JSON n'y a pas tenu
+void sendJson(const JsonWriter& json) {
+  if (!json.ok()) {
+    server.send(500, "application/json", "{\"error\":\"json overflow\"}");
+    return;
+  }
+  server.setContentLength(json.length());
+  server.send(200, "application/json", "");
+  server.sendContent(json.c_str(), json.length());
+}
+
 void handleApi() {
   time_t now = time(nullptr);
   struct tm* ti = localtime(&now);
 
-  String json = "{";
-  json += "\"hour\":" + String(ti->tm_hour) + ",";
-  json += "\"minute\":" + String(ti->tm_min) + ",";
-  json += "\"second\":" + String(ti->tm_sec) + ",";
-  json += "\"day\":" + String(ti->tm_mday) + ",";
-  json += "\"month\":" + String(ti->tm_mon + 1) + ",";
-  json += "\"year\":" + String(ti->tm_year + 1900) + ",";
-  json += "\"timezone\":" + String(config.timezone) + ",";
-  json += "\"format24h\":" + String(config.format24h ? "true" : "false");
-  json += "}";
-
-  server.send(200, "application/json", json);
+  char buf[API_JSON_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.beginObject();
+  json.number("hour", ti->tm_hour);
+  json.number("minute", ti->tm_min);
+  json.number("second", ti->tm_sec);
+  json.number("day", ti->tm_mday);
+  json.number("month", ti->tm_mon + 1);
+  json.number("year", ti->tm_year + 1900);
+  json.number("timezone", config.timezone);
+  json.boolean("format24h", config.format24h);
+  json.endObject();
+
+  sendJson(json);
 }
 
 void setupServer() {
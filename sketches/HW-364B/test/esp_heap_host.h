@@ -0,0 +1,296 @@
+/*
+ * esp_heap_host.h - Tas ESP8266 simule pour les bancs PC (test/)
+ *
+ * HostHeap : tas first-fit a blocs de 8 octets et en-tete de 4 octets
+ * comme umm_malloc (core ESP8266), fusion des blocs libres voisins,
+ * realloc agrandi sur place si le bloc suivant est libre, sinon
+ * deplace. freeBytes() et maxFreeBlock() repondent comme
+ * ESP.getFreeHeap() et ESP.getMaxFreeBlockSize().
+ *
+ * HostString : ce que fait String du core 3.x sur ce tas (SSO jusqu'a
+ * 11 caracteres, capacite arrondie a 16 a chaque concat qui deborde),
+ * assez pour rejouer les pages construites a coups de "+=".
+ *
+ * HostTcpTx : envoi d'une connexion (ClientContext::write) ; chaque
+ * write() copie dans ses propres pbufs de TCP_MSS octets au plus et
+ * attend les ACK (libere les plus anciens) au-dela de TCP_SND_BUF
+ * octets en vol.
+ *
+ * HostBackground : ce que la pile reseau alloue en dehors des requetes
+ * (paquets UDP/ARP, autres connexions), 24 a 223 octets gardes 1 a 30
+ * pas ; meme graine, meme suite pour les deux versions comparees.
+ *
+ * Les chiffres sont ceux du modele, pas d'une carte : ils servent a
+ * comparer deux versions d'un meme traitement.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define HOST_HEAP_BLOCK 8
+#define HOST_HEAP_HDR   4
+#define TCP_MSS         1460
+#define TCP_SND_BUF     (2 * TCP_MSS)
+#define PBUF_HDR        54      // struct pbuf + en-tetes TCP/IP/Ethernet
+
+class HostHeap {
+public:
+  explicit HostHeap(size_t size)
+      : allocs(0), reallocs(0), mem(size / HOST_HEAP_BLOCK * HOST_HEAP_BLOCK) {
+    setHdr(0, mem.size() / HOST_HEAP_BLOCK, 0, false);
+    freeNow = lowWater = mem.size();
+  }
+
+  void* malloc(size_t n) {
+    size_t need = units(n);
+    for (size_t b = 0; b < nblocks(); b += size(b)) {
+      if (used(b) || size(b) < need) continue;
+      split(b, need);
+      setUsed(b, true);
+      allocs++;
+      taken(size(b));
+      return ptr(b);
+    }
+    return nullptr;
+  }
+
+  void free(void* p) {
+    if (!p) return;
+    size_t b = block(p);
+    setUsed(b, false);
+    freeNow += size(b) * HOST_HEAP_BLOCK;
+    size_t next = b + size(b);
+    if (next < nblocks() && !used(next)) merge(b);
+    if (b > 0 && !used(prev(b))) merge(prev(b));
+  }
+
+  void* realloc(void* p, size_t n) {
+    if (!p) return malloc(n);
+    size_t b = block(p), need = units(n), next = b + size(b);
+    reallocs++;
+    if (need <= size(b)) return p;
+    if (next < nblocks() && !used(next) && size(b) + size(next) >= need) {
+      size_t old = size(b);
+      merge(b);
+      split(b, need);
+      taken(size(b) - old);
+      return p;
+    }
+    void* q = malloc(n);
+    if (!q) return nullptr;
+    allocs--;   // compte comme un realloc, pas comme une allocation
+    memcpy(q, p, size(b) * HOST_HEAP_BLOCK - HOST_HEAP_HDR);
+    free(p);
+    return q;
+  }
+
+  size_t freeBytes() const {
+    size_t n = 0;
+    for (size_t b = 0; b < nblocks(); b += size(b))
+      if (!used(b)) n += size(b) * HOST_HEAP_BLOCK;
+    return n;
+  }
+
+  size_t maxFreeBlock() const {
+    size_t m = 0;
+    for (size_t b = 0; b < nblocks(); b += size(b))
+      if (!used(b) && size(b) > m) m = size(b);
+    return m ? m * HOST_HEAP_BLOCK - HOST_HEAP_HDR : 0;
+  }
+
+  size_t capacity() const { return mem.size(); }
+
+  // Tas libre le plus bas depuis resetLowWater(), comme ESP.getFreeHeap()
+  // releve a chaque allocation
+  size_t lowWaterBytes() const { return lowWater; }
+  void resetLowWater() { lowWater = freeNow; }
+
+  unsigned allocs;     // malloc() reussis, hors deplacements de realloc()
+  unsigned reallocs;   // realloc() sur un bloc existant
+
+private:
+  // En-tete : taille du bloc et du bloc precedent en blocs de 8 octets,
+  // bit de poids fort de la taille = occupe
+  size_t nblocks() const { return mem.size() / HOST_HEAP_BLOCK; }
+  uint16_t* hdr(size_t b) { return (uint16_t*)&mem[b * HOST_HEAP_BLOCK]; }
+  const uint16_t* hdr(size_t b) const { return (const uint16_t*)&mem[b * HOST_HEAP_BLOCK]; }
+  size_t size(size_t b) const { return hdr(b)[0] & 0x7fff; }
+  bool used(size_t b) const { return hdr(b)[0] & 0x8000; }
+  size_t prev(size_t b) const { return b - hdr(b)[1]; }
+  void setHdr(size_t b, size_t n, size_t prevN, bool u) {
+    hdr(b)[0] = (uint16_t)(n | (u ? 0x8000 : 0));
+    hdr(b)[1] = (uint16_t)prevN;
+  }
+  void setUsed(size_t b, bool u) { setHdr(b, size(b), hdr(b)[1], u); }
+  void fixNext(size_t b) {
+    size_t next = b + size(b);
+    if (next < nblocks()) hdr(next)[1] = (uint16_t)size(b);
+  }
+  void taken(size_t n) {
+    freeNow -= n * HOST_HEAP_BLOCK;
+    if (freeNow < lowWater) lowWater = freeNow;
+  }
+  static size_t units(size_t n) { return (n + HOST_HEAP_HDR + HOST_HEAP_BLOCK - 1) / HOST_HEAP_BLOCK; }
+  void* ptr(size_t b) { return &mem[b * HOST_HEAP_BLOCK + HOST_HEAP_HDR]; }
+  size_t block(void* p) const { return ((uint8_t*)p - mem.data() - HOST_HEAP_HDR) / HOST_HEAP_BLOCK; }
+
+  // Garde 'need' blocs en b, le reste devient un bloc libre
+  void split(size_t b, size_t need) {
+    size_t n = size(b);
+    if (n == need) return;
+    setHdr(b, need, hdr(b)[1], used(b));
+    setHdr(b + need, n - need, need, false);
+    fixNext(b + need);
+    size_t next = b + n;
+    if (next < nblocks() && !used(next)) merge(b + need);
+  }
+
+  // Absorbe le bloc libre qui suit b
+  void merge(size_t b) {
+    size_t next = b + size(b);
+    setHdr(b, size(b) + size(next), hdr(b)[1], used(b));
+    fixNext(b);
+  }
+
+  std::vector<uint8_t> mem;
+  size_t freeNow, lowWater;
+};
+
+class HostString {
+public:
+  explicit HostString(HostHeap& heap) : heap(heap), heapBuf(nullptr), len(0), cap(SSO_CAP) { sso[0] = '\0'; }
+  HostString(HostHeap& heap, const char* s) : HostString(heap) { concat(s, strlen(s)); }
+  ~HostString() { heap.free(heapBuf); }
+  HostString(const HostString&) = delete;
+  HostString& operator=(const HostString&) = delete;
+
+  HostString& operator+=(const char* s) { return concat(s, strlen(s)); }
+  HostString& operator+=(const HostString& s) { return concat(s.c_str(), s.length()); }
+
+  HostString& concat(const char* s, size_t n) {
+    if (len + n > cap) {
+      // String::changeBuffer() : (taille + 16) & ~15, realloc du tampon
+      size_t newCap = (len + n + 16) & ~(size_t)15;
+      char* p = (char*)heap.realloc(heapBuf, newCap);
+      if (!p) return *this;    // comme le core : concat refuse, chaine inchangee
+      if (!heapBuf) memcpy(p, sso, len + 1);
+      heapBuf = p;
+      cap = newCap - 1;
+    }
+    memcpy(buf() + len, s, n);
+    len += n;
+    buf()[len] = '\0';
+    return *this;
+  }
+
+  const char* c_str() const { return heapBuf ? heapBuf : sso; }
+  size_t length() const { return len; }
+
+private:
+  enum { SSO_CAP = 11 };
+  char* buf() { return heapBuf ? heapBuf : sso; }
+
+  HostHeap& heap;
+  char* heapBuf;
+  char sso[SSO_CAP + 1];
+  size_t len, cap;
+};
+
+class HostTcpTx {
+public:
+  explicit HostTcpTx(HostHeap& heap)
+      : pbufs(0), minBlock(heap.capacity()), oom(false), heap(heap), bytesInFlight(0) {}
+  ~HostTcpTx() { close(); }
+  HostTcpTx(const HostTcpTx&) = delete;
+  HostTcpTx& operator=(const HostTcpTx&) = delete;
+
+  void write(const char* data, size_t n) {
+    sent.append(data, n);
+    while (n > 0) {
+      size_t k = n < TCP_MSS ? n : TCP_MSS;
+      while (bytesInFlight + k > TCP_SND_BUF) ack();
+      void* p = heap.malloc(k + PBUF_HDR);
+      if (!p) {
+        oom = true;
+        return;
+      }
+      pbufs++;
+      inFlight.push_back(std::make_pair(p, k));
+      bytesInFlight += k;
+      size_t b = heap.maxFreeBlock();
+      if (b < minBlock) minBlock = b;
+      n -= k;
+    }
+  }
+
+  // ACK du plus ancien pbuf en vol
+  void ack() {
+    heap.free(inFlight.front().first);
+    bytesInFlight -= inFlight.front().second;
+    inFlight.erase(inFlight.begin());
+  }
+
+  void close() {
+    while (!inFlight.empty()) ack();
+  }
+
+  std::string sent;      // octets envoyes, pour verifier le contenu
+  unsigned pbufs;
+  size_t minBlock;       // plus grand bloc libre le plus bas vu a un envoi
+  bool oom;
+
+private:
+  HostHeap& heap;
+  std::vector<std::pair<void*, size_t> > inFlight;
+  size_t bytesInFlight;
+};
+
+class HostBackground {
+public:
+  HostBackground(HostHeap& heap, uint32_t seed) : allocs(0), heap(heap), rng(seed) {}
+  ~HostBackground() { clear(); }
+
+  // Libere ce qui expire a ce pas, alloue un bloc 4 fois sur 10
+  void step(int now) {
+    for (size_t i = 0; i < items.size();) {
+      if (items[i].until <= now) {
+        heap.free(items[i].p);
+        items.erase(items.begin() + i);
+      } else {
+        i++;
+      }
+    }
+    if (rnd(10) < 4) {
+      void* p = heap.malloc(24 + rnd(200));
+      if (p) items.push_back({p, now + 1 + (int)rnd(30)});
+      allocs += p != nullptr;
+    }
+  }
+
+  void clear() {
+    for (Item& it : items) heap.free(it.p);
+    items.clear();
+  }
+
+  unsigned allocs;   // a retirer des compteurs du tas pour isoler le code mesure
+
+private:
+  struct Item {
+    void* p;
+    int until;
+  };
+
+  uint32_t rnd(uint32_t n) {
+    rng = rng * 1103515245u + 12345u;
+    return (rng >> 8) % n;
+  }
+
+  HostHeap& heap;
+  uint32_t rng;
+  std::vector<Item> items;
+};
@@ -0,0 +1,287 @@
+/*
+ * html_stream_heap.cpp - Banc PC du tas pour la page de NTP_Clock
+ *
+ * Rejoue 1000 requetes GET / de NTP_Clock sur un tas ESP8266 simule
+ * (esp_heap_host.h, 40 Ko) avec, en fond, ce que la pile reseau alloue
+ * entre deux requetes (HostBackground, meme suite pour les deux
+ * versions) :
+ *   - avant : page construite dans une String (meme suite de "+=" et de
+ *     String() temporaires que l'ancien handleRoot), puis envoyee ;
+ *   - apres : HtmlStream (html_stream.h) en chunked, tampon fixe.
+ * L'envoi passe par le modele de ClientContext de esp_heap_host.h :
+ * pbufs de 1460 octets au plus, 2920 octets en vol au plus.
+ *
+ * Verifie que les deux versions envoient la meme page (modele PROGMEM lu
+ * dans NTP_Clock.ino), qu'HtmlStream n'alloue rien pour la page, et
+ * compare le tas libre minimal et le plus grand bloc libre minimal.
+ *
+ * A lancer depuis ce dossier (lit ../NTP_Clock/NTP_Clock.ino) :
+ *   g++ -std=c++11 -O2 -Wall -I../NTP_Clock -I../../common html_stream_heap.cpp -o /tmp/html_stream_heap && /tmp/html_stream_heap
+ */
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "host_test.h"
+#include "esp_heap_host.h"
+#include "html_stream.h"
+
+#define HEAP_SIZE   40960
+#define REQUESTS    1000
+
+static HostHeap heap(HEAP_SIZE);
+static std::string page;       // modele PAGE_ROOT de NTP_Clock.ino
+
+// --- Pile reseau ------------------------------------------------------------
+
+static HostTcpTx* tx;
+static unsigned headerAllocs;   // allocations de l'en-tete, communes aux deux versions
+
+// --- Page --------------------------------------------------------------------
+
+struct Config {
+  int8_t timezone;
+  bool format24h;
+  char ntpServer[40];
+} config = {1, true, "pool.ntp.org"};
+
+// Valeur d'un champ, comme rootField() de NTP_Clock.ino a 14:05:09
+static std::string fieldValue(const std::string& name, int tz = 0) {
+  char buf[24];
+  if (name == "time") return config.format24h ? "14:05:09" : "2:05:09 PM";
+  if (name == "date") return "19/10/2026";
+  if (name == "tzValue") {
+    sprintf(buf, "%d", tz);
+    return buf;
+  }
+  if (name == "sel24") return config.format24h ? " selected" : "";
+  if (name == "sel12") return config.format24h ? "" : " selected";
+  if (name == "ntp") return config.ntpServer;
+  if (name == "ip") return "192.168.1.42";
+  if (name == "rssi") return "-61";
+  return "";
+}
+
+static void rootField(HtmlStream& out, const char* name) {
+  if (!strcmp(name, "tzOptions")) {
+    char buf[24];
+    for (int tz = -12; tz <= 14; tz++) {
+      sprintf(buf, "<option value=\"%d\"", tz);
+      out.text(buf);
+      if (tz == config.timezone) out.text(" selected");
+      sprintf(buf, ">UTC%+d</option>\n", tz);
+      out.text(buf);
+    }
+  } else if (!strcmp(name, "ntp")) {
+    out.escaped(config.ntpServer);
+  } else {
+    out.text(fieldValue(name).c_str());
+  }
+}
+
+// Page attendue, hors de tout tas simule
+static std::string expectedPage() {
+  HtmlStream s([](const char* d, size_t n) { tx->sent.append(d, n); });
+  HostTcpTx t(heap);
+  tx = &t;
+  s.render_P(page.c_str(), rootField);
+  s.flush();
+  return t.sent;
+}
+
+// En-tete HTTP de ESP8266WebServer::_prepareHeader(), une String par requete
+static void sendHeader(bool chunked, size_t length) {
+  unsigned a0 = heap.allocs + heap.reallocs;
+  HostString h(heap, "HTTP/1.1 200 OK\r\n");
+  h += "Content-Type: text/html\r\n";
+  if (chunked) {
+    h += "Transfer-Encoding: chunked\r\n";
+  } else {
+    char buf[40];
+    sprintf(buf, "Content-Length: %u\r\n", (unsigned)length);
+    h += buf;
+  }
+  h += "Connection: close\r\n\r\n";
+  headerAllocs += heap.allocs + heap.reallocs - a0;
+  tx->write(h.c_str(), h.length());
+}
+
+// Ancien handleRoot() : une String qui grandit, des String() temporaires
+// pour chaque valeur, puis server.send(200, "text/html", html)
+static void handleRootString() {
+  HostString html(heap);
+  size_t pos = 0;
+  for (;;) {
+    size_t open = page.find("{{", pos);
+    html.concat(page.data() + pos, (open == std::string::npos ? page.size() : open) - pos);
+    if (open == std::string::npos) break;
+    size_t close = page.find("}}", open);
+    std::string name = page.substr(open + 2, close - open - 2);
+    pos = close + 2;
+
+    if (name == "tzOptions") {
+      for (int tz = -12; tz <= 14; tz++) {
+        // html += "<option value=\"" + String(tz) + "\"";
+        HostString a(heap, "<option value=\"");
+        {
+          HostString n(heap, fieldValue("tzValue", tz).c_str());
+          a += n;
+        }
+        a += "\"";
+        html += a;
+        if (tz == config.timezone) html += " selected";
+        // html += ">UTC" + String(tz >= 0 ? "+" : "") + String(tz) + "</option>\n";
+        HostString b(heap, ">UTC");
+        {
+          HostString sign(heap, tz >= 0 ? "+" : "");
+          b += sign;
+          HostString n(heap, fieldValue("tzValue", tz).c_str());
+          b += n;
+        }
+        b += "</option>\n";
+        html += b;
+      }
+    } else {
+      HostString v(heap, fieldValue(name).c_str());   // String(x), IPAddress::toString()
+      html += v;
+    }
+  }
+  sendHeader(false, html.length());
+  tx->write(html.c_str(), html.length());
+}
+
+static void sendChunk(const char* data, size_t len) {
+  char size[8];
+  tx->write(size, sprintf(size, "%X\r\n", (unsigned)len));
+  tx->write(data, len);
+  tx->write("\r\n", 2);
+}
+
+// handleRoot() actuel : HtmlStream en chunked
+static void handleRootStream() {
+  sendHeader(true, 0);
+  HtmlStream out(sendChunk);
+  out.render_P(page.c_str(), rootField);
+  out.flush();
+  tx->write("0\r\n\r\n", 5);
+}
+
+// Retire l'en-tete et le decoupage chunked pour comparer les pages
+static std::string body(const std::string& raw) {
+  size_t p = raw.find("\r\n\r\n") + 4;
+  if (raw.find("chunked") == std::string::npos) return raw.substr(p);
+  std::string out;
+  for (;;) {
+    size_t n = strtoul(raw.c_str() + p, nullptr, 16);
+    p = raw.find("\r\n", p) + 2;
+    if (n == 0) break;
+    out.append(raw, p, n);
+    p += n + 2;
+  }
+  return out;
+}
+
+// --- Banc --------------------------------------------------------------------
+
+struct Result {
+  size_t minFree, minBlockBetween, minBlock;
+  double pageAllocs, pbufs;
+  unsigned oom;
+};
+
+static Result run(const char* name, void (*handler)(), const std::string& expected) {
+  size_t free0 = heap.freeBytes();
+  HostBackground bg(heap, 7);
+  Result r = {HEAP_SIZE, HEAP_SIZE, HEAP_SIZE, 0, 0, 0};
+  unsigned long pageAllocs = 0, pbufs = 0;
+  bool sameBody = true;
+
+  for (int i = 0; i < REQUESTS; i++) {
+    bg.step(i);
+    size_t block = heap.maxFreeBlock();
+    if (block < r.minBlockBetween) r.minBlockBetween = block;
+
+    // Connexion acceptee, requete recue puis analysee
+    HostTcpTx t(heap);
+    tx = &t;
+    void* ctx = heap.malloc(120);
+    void* rx = heap.malloc(420 + PBUF_HDR);
+    heap.free(rx);
+
+    unsigned a0 = heap.allocs + heap.reallocs;
+    headerAllocs = 0;
+    heap.resetLowWater();
+    handler();
+    if (heap.lowWaterBytes() < r.minFree) r.minFree = heap.lowWaterBytes();
+    if (t.minBlock < r.minBlock) r.minBlock = t.minBlock;
+    pageAllocs += heap.allocs + heap.reallocs - a0 - t.pbufs - headerAllocs;
+    pbufs += t.pbufs;
+    r.oom += t.oom;
+    if (i == 0 || i == REQUESTS - 1) sameBody &= body(t.sent) == expected;
+
+    t.close();
+    heap.free(ctx);
+  }
+  bg.clear();
+
+  r.pageAllocs = (double)pageAllocs / REQUESTS;
+  r.pbufs = (double)pbufs / REQUESTS;
+  CHECK(sameBody, "%s : page envoyee differente de la page attendue", name);
+  CHECK(r.oom == 0, "%s : %u requetes sans memoire", name, r.oom);
+  CHECK(heap.freeBytes() == free0, "%s : fuite de %d octets", name, (int)(free0 - heap.freeBytes()));
+  heap.resetLowWater();
+  CHECK(heap.lowWaterBytes() == heap.freeBytes(), "%s : tas libre suivi %u, reel %u", name,
+        (unsigned)heap.lowWaterBytes(), (unsigned)heap.freeBytes());
+  printf("%-10s  libre min %5u o  plus grand bloc min %5u o (entre requetes %5u o)  "
+         "allocations page/requete %5.1f  pbufs/requete %4.1f\n",
+         name, (unsigned)r.minFree, (unsigned)r.minBlock, (unsigned)r.minBlockBetween, r.pageAllocs, r.pbufs);
+  return r;
+}
+
+static bool loadPage(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  std::string ino;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) ino.append(buf, n);
+  fclose(f);
+  const char* start = "PAGE_ROOT[] PROGMEM = R\"=====(";
+  size_t a = ino.find(start), b = ino.find(")=====\"", a);
+  if (a == std::string::npos || b == std::string::npos) return false;
+  a += strlen(start);
+  page = ino.substr(a, b - a);
+  return true;
+}
+
+int main() {
+  if (!loadPage("../NTP_Clock/NTP_Clock.ino")) {
+    CHECK(false, "PAGE_ROOT introuvable dans ../NTP_Clock/NTP_Clock.ino (lancer depuis test/)");
+    return hostTestEnd();
+  }
+  std::string expected = expectedPage();
+  CHECK(expected.find("{{") == std::string::npos, "champ non remplace");
+  CHECK(expected.find("<option value=\"1\" selected>UTC+1</option>") != std::string::npos,
+        "fuseau selectionne absent");
+
+  // Memoire prise au demarrage (WiFi, serveur, handlers), jamais rendue
+  void* boot[6];
+  for (int i = 0; i < 6; i++) boot[i] = heap.malloc(48 + 64 * i);
+
+  printf("page %u octets, %d requetes, tas %u o\n", (unsigned)expected.size(), REQUESTS, HEAP_SIZE);
+  Result s = run("String", handleRootString, expected);
+  Result h = run("HtmlStream", handleRootStream, expected);
+
+  CHECK(h.pageAllocs == 0, "HtmlStream : %.1f allocations par page", h.pageAllocs);
+  CHECK(s.pageAllocs > 10, "String : seulement %.1f allocations par page", s.pageAllocs);
+  // La String garde toute la page pendant l'envoi ; HtmlStream paie en
+  // echange un en-tete de pbuf par bout de chunk
+  CHECK(h.minFree > s.minFree + expected.size() / 2, "libre min %u contre %u", (unsigned)h.minFree,
+        (unsigned)s.minFree);
+  CHECK(h.minBlock > s.minBlock, "plus grand bloc min %u contre %u", (unsigned)h.minBlock, (unsigned)s.minBlock);
+
+  for (void* p : boot) heap.free(p);
+  CHECK(heap.freeBytes() == heap.capacity() && heap.maxFreeBlock() == heap.capacity() - HOST_HEAP_HDR,
+        "tas non refusionne a la fin");
+  return hostTestEnd();
+}
@@ -0,0 +1,151 @@
+/*
+ * json_writer_test.cpp - Test PC de json_writer.h
+ *
+ * Verifie l'echappement des chaines, les virgules et l'imbrication, puis
+ * ecrit un meme document dans un tampon de chaque taille de 0 jusqu'a la
+ * taille exacte : en dessous, ok() est faux, rien n'est ecrit au-dela du
+ * tampon et le contenu est une chaine terminee, prefixe du document
+ * complet ; a la taille exacte, le document est identique.
+ *
+ * json_writer.h est le meme fichier dans Mini_Dashboard, Bus_Tracker et
+ * NTP_Clock ; le test compile la copie de Mini_Dashboard.
+ *
+ *   g++ -std=c++11 -Wall -I../Mini_Dashboard -I../../common json_writer_test.cpp -o /tmp/json_writer_test && /tmp/json_writer_test
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "host_test.h"
+#include "json_writer.h"
+
+#define CHECK_JSON(j, buf, expected)                                        \
+  do {                                                                      \
+    CHECK((j).ok(), "ok() faux pour %s", expected);                         \
+    CHECK(strcmp(buf, expected) == 0, "obtenu %s, attendu %s", buf, expected); \
+    CHECK((j).length() == strlen(buf), "length() %u", (unsigned)(j).length()); \
+  } while (0)
+
+// Document de reference : imbrication, nombres extremes, echappements
+static void writeDoc(JsonWriter &j) {
+  j.beginObject();
+  j.string("msg", "a\"b\\c\n\r\t\x01\x1f</\xc3\xa9");
+  j.number("min", -2147483647L - 1);
+  j.number("max", 2147483647L);
+  j.boolean("on", true);
+  j.beginArray("list");
+  for (int i = 0; i < 3; i++) {
+    j.beginObject();
+    j.number("i", i);
+    j.endObject();
+  }
+  j.endArray();
+  j.beginObject("empty");
+  j.endObject();
+  j.endObject();
+}
+
+static void testFormat() {
+  char b[256];
+  {
+    JsonWriter j(b, sizeof(b));
+    j.beginObject();
+    j.number("a", 1);
+    j.boolean("b", false);
+    j.string("c", "x");
+    j.endObject();
+    CHECK_JSON(j, b, "{\"a\":1,\"b\":false,\"c\":\"x\"}");
+  }
+  {
+    JsonWriter j(b, sizeof(b));
+    j.beginArray();
+    j.number(nullptr, 0);
+    j.number(nullptr, -7);
+    j.boolean(nullptr, true);
+    j.string(nullptr, "");
+    j.beginArray();
+    j.endArray();
+    j.endArray();
+    CHECK_JSON(j, b, "[0,-7,true,\"\",[]]");
+  }
+  {
+    JsonWriter j(b, sizeof(b));
+    writeDoc(j);
+    CHECK_JSON(j, b,
+               "{\"msg\":\"a\\\"b\\\\c\\n\\r\\t\\u0001\\u001f</\xc3\xa9\","
+               "\"min\":-2147483648,\"max\":2147483647,\"on\":true,"
+               "\"list\":[{\"i\":0},{\"i\":1},{\"i\":2}],\"empty\":{}}");
+  }
+}
+
+// Les cles passent par le meme echappement que les valeurs
+static void testEscapedKey() {
+  char b[64];
+  JsonWriter j(b, sizeof(b));
+  j.beginObject();
+  j.string("k\"\\\n", "v");
+  j.endObject();
+  CHECK_JSON(j, b, "{\"k\\\"\\\\\\n\":\"v\"}");
+}
+
+static void testOverflow() {
+  char full[256];
+  JsonWriter ref(full, sizeof(full));
+  writeDoc(ref);
+  CHECK(ref.ok(), "document de reference trop grand");
+  size_t exact = ref.length() + 1;   // avec le '\0'
+
+  for (size_t size = 0; size <= exact; size++) {
+    char b[sizeof(full) + 8];
+    memset(b, '#', sizeof(b));
+    JsonWriter j(b, size);
+    writeDoc(j);
+    bool fits = size == exact;
+    CHECK(j.ok() == fits, "taille %u : ok() %d", (unsigned)size, j.ok());
+    CHECK(b[size] == '#', "taille %u : ecriture hors tampon", (unsigned)size);
+    if (size == 0) continue;
+    CHECK(memchr(b, '\0', size) != nullptr, "taille %u : pas de '\\0'", (unsigned)size);
+    CHECK(j.length() == strlen(b), "taille %u : length() %u", (unsigned)size, (unsigned)j.length());
+    CHECK(j.length() < size, "taille %u : length() %u", (unsigned)size, (unsigned)j.length());
+    CHECK(strncmp(b, full, j.length()) == 0, "taille %u : %s n'est pas un prefixe", (unsigned)size, b);
+    if (fits) CHECK(strcmp(b, full) == 0, "taille exacte : %s", b);
+  }
+}
+
+static void testDepth() {
+  char b[64];
+  {
+    JsonWriter j(b, sizeof(b));   // fermeture en trop
+    j.beginObject();
+    j.endObject();
+    j.endObject();
+    CHECK(!j.ok(), "fermeture en trop acceptee");
+  }
+  {
+    JsonWriter j(b, sizeof(b));   // conteneur non ferme
+    j.beginObject();
+    j.beginArray("a");
+    j.endArray();
+    CHECK(!j.ok(), "objet non ferme accepte");
+  }
+  {
+    JsonWriter j(b, sizeof(b));   // profondeur maximale
+    for (int i = 0; i < JSON_DEPTH_MAX; i++) j.beginArray();
+    for (int i = 0; i < JSON_DEPTH_MAX; i++) j.endArray();
+    CHECK(j.ok(), "profondeur %d refusee", JSON_DEPTH_MAX);
+  }
+  {
+    JsonWriter j(b, sizeof(b));   // un niveau de trop
+    for (int i = 0; i <= JSON_DEPTH_MAX; i++) j.beginArray();
+    for (int i = 0; i <= JSON_DEPTH_MAX; i++) j.endArray();
+    CHECK(!j.ok(), "profondeur %d acceptee", JSON_DEPTH_MAX + 1);
+  }
+}
+
+int main() {
+  testFormat();
+  testEscapedKey();
+  testOverflow();
+  testDepth();
+
+  return hostTestEnd();
+}
@@ -0,0 +1,474 @@
+/*
+ * mini_dashboard_sse_bench.cpp - Banc PC : interrogation de /api contre SSE
+ *
+ * Rejoue 10 minutes de Mini_Dashboard (boucle de 10 ms) avec 1 puis 4
+ * onglets ouverts, sur le tas ESP8266 simule de esp_heap_host.h (40 Ko,
+ * memes allocations de fond pour les deux versions). Meme scenario pour
+ * les deux : un changement d'etat par /api toutes les 10 s en moyenne
+ * depuis le premier onglet, RSSI qui varie toutes les 5 s.
+ *   - avant (c8927e5^) : chaque onglet interroge /api toutes les 2 s,
+ *     reponse construite dans une String ;
+ *   - apres : une connexion /events par onglet, delta pousse a chaque
+ *     changement (buildEvent), commentaire de maintien toutes les 15 s,
+ *     /api en JsonWriter pour les seules actions.
+ * Chaque requete coute une connexion TCP (ClientContext), le paquet
+ * recu, les arguments de ESP8266WebServer et l'en-tete de reponse.
+ *
+ * Chaque onglet applique ce qu'il recoit comme sync() dans la page :
+ * verifie que tous finissent a jour et mesure leur retard sur l'etat.
+ * Affiche requetes/min, octets/min, allocations/min, tas libre minimal
+ * et plus grand bloc libre minimal.
+ *
+ *   g++ -std=c++11 -O2 -Wall -I../Mini_Dashboard -I../../common mini_dashboard_sse_bench.cpp -o /tmp/mini_dashboard_sse_bench && /tmp/mini_dashboard_sse_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "host_test.h"
+#include "esp_heap_host.h"
+#include "json_writer.h"
+
+#define HEAP_SIZE        40960
+#define STEP_MS          10
+#define STEPS            (10 * 60 * 1000 / STEP_MS)
+#define POLL_STEPS       (2000 / STEP_MS)
+#define KEEPALIVE_STEPS  (15000 / STEP_MS)    // SSE_KEEPALIVE_MS
+#define RSSI_STEPS       (5000 / STEP_MS)
+#define MAX_TABS         4                    // SSE_MAX_CLIENTS
+#define CONTEXT_BYTES    280                  // ClientContext + tcp_pcb de lwIP
+#define REQUEST_BYTES    420                  // GET envoye par le navigateur
+#define SSE_EVENT_MAX    192
+#define API_JSON_MAX     256
+
+static HostHeap heap(HEAP_SIZE);
+
+// --- Scenario commun -----------------------------------------------------------
+
+struct Action {
+  int step;
+  const char* arg;      // parametre de /api
+  const char* value;
+};
+
+struct Scenario {
+  std::vector<Action> actions;
+  std::vector<int> rssi;          // RSSI a chaque pas
+  int pollPhase[MAX_TABS];
+};
+
+static Scenario makeScenario() {
+  static const char* args[][2] = {{"brightness", ""}, {"temperature", ""}, {"mode", ""}, {"led", "toggle"},
+                                  {"sound", "toggle"}, {"counter", "inc"}, {"message", "Bonjour%20le%20salon"}};
+  static char values[STEPS][4];
+  uint32_t rng = 11;
+  auto rnd = [&rng](uint32_t n) {
+    rng = rng * 1103515245u + 12345u;
+    return (rng >> 8) % n;
+  };
+  Scenario s;
+  int rssi = -62;
+  for (int i = 0; i < STEPS; i++) {
+    if (i % RSSI_STEPS == 0) {
+      rssi += (int)rnd(3) - 1;
+      if (rssi < -80) rssi = -80;
+      if (rssi > -50) rssi = -50;
+    }
+    s.rssi.push_back(rssi);
+    if (i > 0 && rnd(1000) == 0) {
+      int k = rnd(7);
+      const char* v = args[k][1];
+      if (k < 3) {
+        int ranges[3][2] = {{0, 100}, {16, 30}, {0, 2}};
+        sprintf(values[i], "%d", ranges[k][0] + (int)rnd(ranges[k][1] - ranges[k][0] + 1));
+        v = values[i];
+      }
+      s.actions.push_back({i, args[k][0], v});
+    }
+  }
+  for (int t = 0; t < MAX_TABS; t++) s.pollPhase[t] = rnd(POLL_STEPS);
+  return s;
+}
+
+// --- Etat du tableau de bord et vue des onglets ----------------------------------
+
+struct DashboardState {
+  uint8_t brightness, temperature, mode;
+  bool ledOn, soundOn;
+  uint16_t counter;
+  char message[32];
+};
+
+static const DashboardState initialState = {50, 22, 1, false, true, 0, "Bienvenue!"};
+
+// Champs affiches par sync() dans la page
+enum { F_BRIGHTNESS, F_TEMPERATURE, F_MODE, F_LED, F_SOUND, F_COUNTER, F_RSSI, FIELDS };
+static const char* fieldKeys[FIELDS] = {"brightness", "temperature", "mode", "ledOn", "soundOn", "counter", "rssi"};
+
+struct View {
+  long v[FIELDS];
+  bool operator==(const View& o) const { return !memcmp(v, o.v, sizeof(v)); }
+};
+
+static View viewOf(const DashboardState& s, int rssi) {
+  return {{s.brightness, s.temperature, s.mode, s.ledOn, s.soundOn, s.counter, rssi}};
+}
+
+// sync(JSON.parse(...)) : seules les cles presentes sont mises a jour
+static void applyJson(View& v, const char* json) {
+  for (int f = 0; f < FIELDS; f++) {
+    char key[24];
+    snprintf(key, sizeof(key), "\"%s\":", fieldKeys[f]);
+    const char* p = strstr(json, key);
+    if (!p) continue;
+    p += strlen(key);
+    v.v[f] = *p == 't' ? 1 : *p == 'f' ? 0 : strtol(p, nullptr, 10);
+  }
+}
+
+static bool sameControls(const View& a, const View& b) {
+  return !memcmp(a.v, b.v, F_RSSI * sizeof(long));
+}
+
+// --- Serveur ---------------------------------------------------------------------
+
+// Compteurs d'une execution
+struct Run {
+  DashboardState state, sseSent;
+  int rssi, sseRssi;
+  bool displayNeedsUpdate;
+  unsigned requests;
+  unsigned long bytes;
+  size_t minBlock;
+  bool oom;
+};
+
+static Run* run;
+
+static long toInt(const char* s) { return strtol(s, nullptr, 10); }
+static long constrain(long v, long lo, long hi) { return v < lo ? lo : v > hi ? hi : v; }
+
+// Une requete : connexion acceptee, GET recu puis analyse ; les arguments
+// (RequestArgument[], valeurs de plus de 11 caracteres) vivent jusqu'a la fin
+struct Request {
+  HostTcpTx tx;
+  void* ctx;
+  void* args;
+  void* value;
+
+  Request(const Action* a) : tx(heap), value(nullptr) {
+    run->requests++;
+    ctx = heap.malloc(CONTEXT_BYTES);
+    void* rx = heap.malloc(REQUEST_BYTES + PBUF_HDR);
+    args = heap.malloc(24 * (a ? 2 : 1) + 4);
+    if (a && strlen(a->value) > 11) value = heap.malloc((strlen(a->value) + 16) & ~15);
+    heap.free(rx);
+  }
+
+  ~Request() {
+    run->bytes += tx.sent.size();
+    if (tx.minBlock < run->minBlock) run->minBlock = tx.minBlock;
+    run->oom |= tx.oom;
+    tx.close();
+    heap.free(value);
+    heap.free(args);
+    heap.free(ctx);
+  }
+};
+
+// Parametres de /api, identiques avant et apres
+static void applyAction(const Action* a) {
+  if (!a) return;
+  DashboardState& s = run->state;
+  if (!strcmp(a->arg, "brightness")) s.brightness = constrain(toInt(a->value), 0, 100);
+  else if (!strcmp(a->arg, "temperature")) s.temperature = constrain(toInt(a->value), 16, 30);
+  else if (!strcmp(a->arg, "mode")) s.mode = constrain(toInt(a->value), 0, 2);
+  else if (!strcmp(a->arg, "led")) s.ledOn = !s.ledOn;
+  else if (!strcmp(a->arg, "sound")) s.soundOn = !s.soundOn;
+  else if (!strcmp(a->arg, "counter")) s.counter++;
+  else if (!strcmp(a->arg, "message")) {
+    strncpy(s.message, a->value, sizeof(s.message) - 1);
+    s.message[sizeof(s.message) - 1] = '\0';
+  }
+  run->displayNeedsUpdate = true;
+}
+
+// En-tete de ESP8266WebServer::_prepareHeader(), une String par reponse
+static void sendHeader(HostTcpTx& tx, size_t length) {
+  char buf[40];
+  HostString h(heap, "HTTP/1.1 200 OK\r\n");
+  h += "Content-Type: application/json\r\n";
+  sprintf(buf, "Content-Length: %u\r\n", (unsigned)length);
+  h += buf;
+  h += "Connection: close\r\n\r\n";
+  tx.write(h.c_str(), h.length());
+}
+
+static std::string body(const std::string& raw) { return raw.substr(raw.find("\r\n\r\n") + 4); }
+
+// json += "\"cle\":" + String(v) + "," : une String temporaire par champ
+static void oldField(HostString& json, const char* key, const char* value, const char* tail) {
+  HostString t(heap, key);
+  {
+    HostString v(heap, value);
+    t += v;
+  }
+  t += tail;
+  json += t;
+}
+
+// handleApi() avant c8927e5 : reponse construite dans une String
+static std::string handleApiString(const Action* a) {
+  Request r(a);
+  applyAction(a);
+  const DashboardState& s = run->state;
+  char n[8];
+  HostString json(heap, "{");
+  sprintf(n, "%d", s.brightness);
+  oldField(json, "\"brightness\":", n, ",");
+  sprintf(n, "%d", s.temperature);
+  oldField(json, "\"temperature\":", n, ",");
+  sprintf(n, "%d", s.mode);
+  oldField(json, "\"mode\":", n, ",");
+  oldField(json, "\"ledOn\":", s.ledOn ? "true" : "false", ",");
+  oldField(json, "\"soundOn\":", s.soundOn ? "true" : "false", ",");
+  sprintf(n, "%d", s.counter);
+  oldField(json, "\"counter\":", n, ",");
+  oldField(json, "\"message\":\"", s.message, "\",");
+  oldField(json, "\"ip\":\"", "192.168.1.42", "\",");   // IPAddress::toString()
+  sprintf(n, "%d", run->rssi);
+  oldField(json, "\"rssi\":", n, "");
+  json += "}";
+  sendHeader(r.tx, json.length());
+  r.tx.write(json.c_str(), json.length());
+  return body(r.tx.sent);
+}
+
+// handleApi() actuel : JsonWriter sur la pile
+static std::string handleApiJson(const Action* a) {
+  Request r(a);
+  applyAction(a);
+  const DashboardState& s = run->state;
+  char buf[API_JSON_MAX];
+  JsonWriter json(buf, sizeof(buf));
+  json.beginObject();
+  json.number("brightness", s.brightness);
+  json.number("temperature", s.temperature);
+  json.number("mode", s.mode);
+  json.boolean("ledOn", s.ledOn);
+  json.boolean("soundOn", s.soundOn);
+  json.number("counter", s.counter);
+  json.string("message", s.message);
+  json.string("ip", "192.168.1.42");
+  json.number("rssi", run->rssi);
+  json.endObject();
+  CHECK(json.ok(), "JSON de /api tronque");
+  sendHeader(r.tx, json.length());
+  r.tx.write(json.c_str(), json.length());
+  return body(r.tx.sent);
+}
+
+// buildEvent() de Mini_Dashboard.ino
+static size_t buildEvent(char* buf, size_t size, bool full, int rssi) {
+  const char prefix[] = "data: ";
+  const size_t head = sizeof(prefix) - 1;
+  JsonWriter json(buf + head, size - head - 2);
+  const DashboardState& s = run->state;
+  const DashboardState& sent = run->sseSent;
+
+  json.beginObject();
+  if (full || s.brightness != sent.brightness) json.number("brightness", s.brightness);
+  if (full || s.temperature != sent.temperature) json.number("temperature", s.temperature);
+  if (full || s.mode != sent.mode) json.number("mode", s.mode);
+  if (full || s.ledOn != sent.ledOn) json.boolean("ledOn", s.ledOn);
+  if (full || s.soundOn != sent.soundOn) json.boolean("soundOn", s.soundOn);
+  if (full || s.counter != sent.counter) json.number("counter", s.counter);
+  if (full || rssi != run->sseRssi) json.number("rssi", rssi);
+  if (full) json.string("ip", "192.168.1.42");
+  if (json.length() == 1) return 0;
+  json.endObject();
+  if (!json.ok()) return 0;
+
+  size_t len = head + json.length();
+  memcpy(buf, prefix, head);
+  memcpy(buf + len, "\n\n", 3);
+  return len + 2;
+}
+
+// Connexion /events d'un onglet : reste ouverte, ACK au pas suivant
+struct SseClient {
+  HostTcpTx* tx = nullptr;
+  void* ctx = nullptr;
+
+  void connect() {
+    {
+      Request r(nullptr);       // GET /events : connexion comptee comme une requete
+      ctx = heap.malloc(CONTEXT_BYTES);
+    }
+    tx = new HostTcpTx(heap);
+    const char header[] =
+        "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\n\r\nretry: 3000\n\n";
+    tx->write(header, sizeof(header) - 1);
+    char event[SSE_EVENT_MAX];
+    size_t len = buildEvent(event, sizeof(event), true, run->rssi);
+    tx->write(event, len);
+  }
+
+  // Evenements recus depuis le dernier appel, appliques a la vue
+  void receive(View& v) {
+    size_t p = 0;
+    const std::string& s = tx->sent;
+    while ((p = s.find("data: ", p)) != std::string::npos) {
+      size_t e = s.find("\n\n", p);
+      applyJson(v, s.substr(p + 6, e - p - 6).c_str());
+      p = e;
+    }
+    run->bytes += s.size();
+    if (tx->minBlock < run->minBlock) run->minBlock = tx->minBlock;
+    run->oom |= tx->oom;
+    tx->sent.clear();
+    tx->close();
+  }
+
+  void stop() {
+    delete tx;
+    heap.free(ctx);
+  }
+};
+
+// --- Banc ------------------------------------------------------------------------
+
+struct Result {
+  double requestsPerMin, kbPerMin, allocsPerMin;
+  size_t minFree, minBlock;
+  int staleMaxMs, rssiAgeMaxMs;
+};
+
+static Result simulate(const Scenario& sc, bool sse, int tabs) {
+  Run r = {initialState, initialState, sc.rssi[0], sc.rssi[0], false, 0, 0, HEAP_SIZE, false};
+  run = &r;
+  size_t free0 = heap.freeBytes();
+  unsigned a0 = heap.allocs + heap.reallocs;
+  HostBackground bg(heap, 7);
+  heap.resetLowWater();
+
+  View views[MAX_TABS];
+  SseClient clients[MAX_TABS];
+  int stale[MAX_TABS] = {0}, rssiAge[MAX_TABS] = {0};
+  Result res = {0, 0, 0, 0, 0, 0, 0};
+  size_t next = 0;
+  int lastKeepAlive = 0;
+
+  for (int t = 0; t < tabs; t++) views[t] = viewOf(r.state, r.rssi);   // page chargee
+  for (int i = 0; i < STEPS; i++) {
+    bg.step(i);
+    r.rssi = sc.rssi[i];
+
+    // server.handleClient()
+    if (next < sc.actions.size() && sc.actions[next].step == i) {
+      const Action* a = &sc.actions[next++];
+      applyJson(views[0], (sse ? handleApiJson(a) : handleApiString(a)).c_str());
+    }
+    for (int t = 0; t < tabs; t++) {
+      if (sse && i == sc.pollPhase[t]) clients[t].connect();
+      if (!sse && i % POLL_STEPS == sc.pollPhase[t]) applyJson(views[t], handleApiString(nullptr).c_str());
+    }
+
+    // loop() : delta pousse apres un changement, maintien toutes les 15 s
+    if (sse) {
+      char event[SSE_EVENT_MAX];
+      bool keepAlive = i - lastKeepAlive >= KEEPALIVE_STEPS;
+      if (keepAlive) lastKeepAlive = i;
+      if (r.displayNeedsUpdate || keepAlive) {
+        size_t len = buildEvent(event, sizeof(event), false, r.rssi);
+        if (len) {
+          r.sseSent = r.state;
+          r.sseRssi = r.rssi;
+        } else if (keepAlive) {
+          memcpy(event, ":\n\n", 4);
+          len = 3;
+        }
+        for (int t = 0; t < tabs; t++)
+          if (clients[t].tx && len) clients[t].tx->write(event, len);
+      }
+      for (int t = 0; t < tabs; t++)
+        if (clients[t].tx) clients[t].receive(views[t]);
+    }
+    r.displayNeedsUpdate = false;
+
+    View now = viewOf(r.state, r.rssi);
+    for (int t = 0; t < tabs; t++) {
+      stale[t] = sameControls(views[t], now) ? 0 : stale[t] + 1;
+      rssiAge[t] = views[t].v[F_RSSI] == r.rssi ? 0 : rssiAge[t] + 1;
+      if (stale[t] * STEP_MS > res.staleMaxMs) res.staleMaxMs = stale[t] * STEP_MS;
+      if (rssiAge[t] * STEP_MS > res.rssiAgeMaxMs) res.rssiAgeMaxMs = rssiAge[t] * STEP_MS;
+    }
+    size_t b = heap.maxFreeBlock();
+    if (b < r.minBlock) r.minBlock = b;
+  }
+
+  View now = viewOf(r.state, r.rssi);
+  for (int t = 0; t < tabs; t++) {
+    CHECK(sameControls(views[t], now), "%s, %d onglet(s) : onglet %d pas a jour a la fin", sse ? "SSE" : "/api", tabs,
+          t);
+    if (sse) clients[t].stop();
+  }
+  bg.clear();
+  CHECK(!r.oom, "%s, %d onglet(s) : plus de memoire", sse ? "SSE" : "/api", tabs);
+  CHECK(heap.freeBytes() == free0, "%s, %d onglet(s) : fuite de %d octets", sse ? "SSE" : "/api", tabs,
+        (int)(free0 - heap.freeBytes()));
+
+  double minutes = STEPS * STEP_MS / 60000.0;
+  res.requestsPerMin = r.requests / minutes;
+  res.kbPerMin = r.bytes / 1024.0 / minutes;
+  res.allocsPerMin = (heap.allocs + heap.reallocs - a0 - bg.allocs) / minutes;
+  res.minFree = heap.lowWaterBytes();
+  res.minBlock = r.minBlock;
+  printf("%-5s %d onglet(s)  %6.1f req/min  %6.1f Ko/min  %7.0f alloc/min  libre min %5u o  "
+         "bloc min %5u o  retard max %5d ms  age RSSI max %5d ms\n",
+         sse ? "SSE" : "/api", tabs, res.requestsPerMin, res.kbPerMin, res.allocsPerMin, (unsigned)res.minFree,
+         (unsigned)res.minBlock, res.staleMaxMs, res.rssiAgeMaxMs);
+  return res;
+}
+
+int main() {
+  Scenario sc = makeScenario();
+  double minutes = STEPS * STEP_MS / 60000.0;
+  printf("%d minutes, %u actions /api, tas %u o\n", (int)minutes, (unsigned)sc.actions.size(), HEAP_SIZE);
+
+  // Memoire prise au demarrage (WiFi, serveur, handlers), jamais rendue
+  void* boot[6];
+  for (int i = 0; i < 6; i++) boot[i] = heap.malloc(48 + 64 * i);
+
+  const int tabCounts[] = {1, MAX_TABS};
+  for (int tabs : tabCounts) {
+    Result poll = simulate(sc, false, tabs);
+    Result sse = simulate(sc, true, tabs);
+    double actionsPerMin = sc.actions.size() / minutes;
+
+    // Avant : 30 requetes par minute et par onglet, plus les actions
+    CHECK(poll.requestsPerMin > tabs * 30, "/api, %d onglet(s) : %.1f req/min", tabs, poll.requestsPerMin);
+    // Apres : les actions et une connexion /events par onglet, rien d'autre
+    CHECK(sse.requestsPerMin <= actionsPerMin + tabs / minutes + 0.01, "SSE, %d onglet(s) : %.1f req/min", tabs,
+          sse.requestsPerMin);
+    CHECK(sse.allocsPerMin * 5 < poll.allocsPerMin, "%d onglet(s) : %.0f alloc/min contre %.0f", tabs,
+          sse.allocsPerMin, poll.allocsPerMin);
+    CHECK(sse.kbPerMin < poll.kbPerMin, "%d onglet(s) : %.1f Ko/min contre %.1f", tabs, sse.kbPerMin,
+          poll.kbPerMin);
+    // Un changement arrive dans le meme tour de loop() ; /api attend le
+    // prochain passage de l'onglet (2 s au plus)
+    CHECK(sse.staleMaxMs <= STEP_MS, "SSE, %d onglet(s) : retard %d ms", tabs, sse.staleMaxMs);
+    CHECK(poll.staleMaxMs <= POLL_STEPS * STEP_MS, "/api, %d onglet(s) : retard %d ms", tabs, poll.staleMaxMs);
+    // Une connexion ouverte par onglet et son dernier evenement en vol
+    CHECK(sse.minFree + tabs * (CONTEXT_BYTES + SSE_EVENT_MAX + PBUF_HDR + 16) >= poll.minFree,
+          "%d onglet(s) : libre min %u contre %u", tabs, (unsigned)sse.minFree, (unsigned)poll.minFree);
+    // Le RSSI ne part qu'avec un changement ou le maintien de 15 s
+    CHECK(sse.rssiAgeMaxMs <= KEEPALIVE_STEPS * STEP_MS, "SSE : RSSI vieux de %d ms", sse.rssiAgeMaxMs);
+  }
+
+  for (void* p : boot) heap.free(p);
+  CHECK(heap.freeBytes() == heap.capacity(), "tas non refusionne a la fin");
+  return hostTestEnd();
+}
@@ -0,0 +1,163 @@
+/*
+ * dir_pager.h - Lazily indexed, paged directory listing
+ *
+ * Reads the directory through FatFs directly: f_readdir() returns name,
+ * size and attributes in one pass, where File::openNextFile() opens every
+ * entry and stat() rescans the whole directory.
+ *
+ * indexStep() counts visible entries a few at a time (called from an LVGL
+ * timer) and keeps a copy of the FF_DIR cursor every DIR_PAGE entries.
+ * FF_DIR is a plain position (cluster, sector, offset), so restoring a
+ * copy jumps straight to any page without re-reading the entries before
+ * it. Entries themselves only live in a small LRU page cache.
+ *
+ * Memory: DIR_CACHE_PAGES pages (~4.6 KB, inside the object, so internal
+ * RAM for the static pager) + one cursor (~50 bytes) per DIR_PAGE entries,
+ * in PSRAM.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "ff.h"
+
+#define DIR_PAGE         16
+#define DIR_CACHE_PAGES  4
+#define DIR_NAME_MAX     64
+#define SD_FATFS_DRIVE   "0:"     // FatFs drive of the SD_MMC mount
+
+struct DirEntry {
+    char name[DIR_NAME_MAX];
+    uint32_t size;
+    bool isDir;
+};
+
+class DirPager {
+public:
+    DirPager()
+    {
+        for (int i = 0; i < DIR_CACHE_PAGES; i++) cache[i].page = -1;
+    }
+
+    // path: VFS path relative to the mount point ("/", "/photos/")
+    bool open(const char *path)
+    {
+        close();
+        snprintf(ffPath, sizeof(ffPath), SD_FATFS_DRIVE "%s", path);
+        size_t len = strlen(ffPath);
+        if (len > strlen(SD_FATFS_DRIVE "/") && ffPath[len - 1] == '/') ffPath[len - 1] = '\0';
+        if (f_opendir(&scan, ffPath) != FR_OK) return false;
+        opened = true;
+        done = false;
+        return true;
+    }
+
+    void close()
+    {
+        if (opened) f_closedir(&scan);
+        opened = false;
+        done = true;
+        total = 0;
+        markCount = 0;
+        for (int i = 0; i < DIR_CACHE_PAGES; i++) cache[i].page = -1;
+    }
+
+    // Index up to 'budget' raw entries. Returns true while entries remain.
+    bool indexStep(int budget)
+    {
+        if (done) return false;
+        FILINFO fno;
+        while (budget-- > 0) {
+            FF_DIR before = scan;
+            if (f_readdir(&scan, &fno) != FR_OK || fno.fname[0] == '\0') {
+                f_closedir(&scan);
+                opened = false;
+                done = true;
+                return false;
+            }
+            if (hidden(fno)) continue;
+            if (total % DIR_PAGE == 0 && !addMark(before)) {
+                done = true;   // out of memory: list stays truncated
+                return false;
+            }
+            total++;
+        }
+        return true;
+    }
+
+    int count() const { return total; }
+    bool complete() const { return done; }
+
+    // Entry i (0-based among visible entries), nullptr if not indexed yet
+    const DirEntry *entry(int i)
+    {
+        if (i < 0 || i >= total) return nullptr;
+        Page *p = page(i / DIR_PAGE);
+        if (!p || i % DIR_PAGE >= p->n) return nullptr;
+        return &p->e[i % DIR_PAGE];
+    }
+
+private:
+    struct Page {
+        int page;
+        int n;
+        uint32_t lastUse;
+        DirEntry e[DIR_PAGE];
+    };
+
+    static bool hidden(const FILINFO &fno) { return fno.fname[0] == '.'; }
+
+    bool addMark(const FF_DIR &d)
+    {
+        if (markCount == markCap) {
+            int cap = markCap ? markCap * 2 : 64;
+            FF_DIR *m = (FF_DIR *)heap_caps_realloc(marks, cap * sizeof(FF_DIR), MALLOC_CAP_SPIRAM);
+            if (!m) return false;
+            marks = m;
+            markCap = cap;
+        }
+        marks[markCount++] = d;
+        return true;
+    }
+
+    Page *page(int pg)
+    {
+        Page *victim = &cache[0];
+        for (int i = 0; i < DIR_CACHE_PAGES; i++) {
+            if (cache[i].page == pg) {
+                cache[i].lastUse = ++useClock;
+                return &cache[i];
+            }
+            if (cache[i].page < 0 || cache[i].lastUse < victim->lastUse) victim = &cache[i];
+        }
+        if (pg >= markCount) return nullptr;
+
+        // Restart from the saved cursor: a copy, the indexing cursor is untouched
+        FF_DIR d = marks[pg];
+        FILINFO fno;
+        victim->page = -1;
+        victim->n = 0;
+        while (victim->n < DIR_PAGE) {
+            if (f_readdir(&d, &fno) != FR_OK || fno.fname[0] == '\0') break;
+            if (hidden(fno)) continue;
+            DirEntry &e = victim->e[victim->n++];
+            strlcpy(e.name, fno.fname, sizeof(e.name));
+            e.size = fno.fsize;
+            e.isDir = fno.fattrib & AM_DIR;
+        }
+        victim->page = pg;
+        victim->lastUse = ++useClock;
+        return victim;
+    }
+
+    char ffPath[160];
+    FF_DIR scan;
+    bool opened = false;
+    bool done = true;
+    int total = 0;
+    FF_DIR *marks = nullptr;
+    int markCount = 0;
+    int markCap = 0;
+    Page cache[DIR_CACHE_PAGES];
+    uint32_t useClock = 0;
+};
@@ -0,0 +1,38 @@
+/*
+ * jpeg_blit.h - 1:1 copy of a decoded JPEGDEC block onto the canvas
+ *
+ * JPEGDEC is set to emit the canvas byte order, so a block needs no pixel
+ * conversion: it is clipped once against the visible image rectangle, then
+ * copied row by row with memcpy. Clipping to the image rather than to the
+ * canvas also keeps the MCU padding of the last column/row of blocks off
+ * the border around a small image.
+ *
+ * Pure C++ (host testable, test/jpeg_blit_bench.cpp).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Block px (bw x bh, stride bw) with its top-left at (x, y) on the canvas;
+// only [clipX0, clipX1) x [clipY0, clipY1) is written. Returns the number
+// of pixels copied.
+inline int jpegBlitClipped(const uint16_t *px, int bw, int bh, int x, int y,
+                           uint16_t *canvas, int canvasStride,
+                           int clipX0, int clipY0, int clipX1, int clipY1)
+{
+    int cx0 = x > clipX0 ? x : clipX0, cx1 = x + bw < clipX1 ? x + bw : clipX1;
+    int cy0 = y > clipY0 ? y : clipY0, cy1 = y + bh < clipY1 ? y + bh : clipY1;
+    if (cx0 >= cx1 || cy0 >= cy1) return 0;
+
+    size_t rowBytes = (cx1 - cx0) * sizeof(uint16_t);
+    const uint16_t *src = px + (cy0 - y) * bw + (cx0 - x);
+    uint16_t *dst = canvas + cy0 * canvasStride + cx0;
+    for (int row = cy0; row < cy1; row++) {
+        memcpy(dst, src, rowBytes);
+        src += bw;
+        dst += canvasStride;
+    }
+    return (cx1 - cx0) * (cy1 - cy0);
+}
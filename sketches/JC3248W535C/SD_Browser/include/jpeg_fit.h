@@ -0,0 +1,195 @@
+/*
+ * jpeg_fit.h - Fit-to-screen for JPEGDEC: DCT scale choice + bilinear fit
+ *
+ * jpegPickScale() picks the strongest JPEGDEC scaling (1/2, 1/4, 1/8) that
+ * still decodes at least the fitted size, so the IDCT skips most of the
+ * work on camera photos. What remains (a factor in (0.5, 1]) is resampled
+ * by JpegFit directly from the decoded MCU blocks, with no full-size
+ * intermediate image.
+ *
+ * Blocks arrive left to right, top to bottom. Each destination pixel is
+ * produced by the block holding its bottom-right source neighbour; the
+ * top/left neighbours come from carries kept from the previous blocks (last
+ * row of the previous MCU row, last column of the block on the left), so
+ * block edges do not show seams.
+ *
+ * Pure C++ (host testable).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JPEG_FIT_MAX_BLOCK_H 16     // tallest MCU delivered by JPEGDEC
+
+struct JpegScale {
+    int div;            // 1, 2, 4 or 8
+    int decW, decH;     // decoded size at that scale
+    int dstW, dstH;     // fitted size on screen
+};
+
+inline JpegScale jpegPickScale(int w, int h, int maxW, int maxH)
+{
+    JpegScale s;
+    s.div = 1;
+    while (s.div < 8 && (w >= 2 * s.div * maxW || h >= 2 * s.div * maxH)) s.div *= 2;
+    s.decW = (w + s.div - 1) / s.div;
+    s.decH = (h + s.div - 1) / s.div;
+
+    if (s.decW <= maxW && s.decH <= maxH) {
+        s.dstW = s.decW;
+        s.dstH = s.decH;
+    } else if ((int64_t)s.decW * maxH >= (int64_t)s.decH * maxW) {
+        s.dstW = maxW;
+        s.dstH = (int)((int64_t)s.decH * maxW / s.decW);
+    } else {
+        s.dstH = maxH;
+        s.dstW = (int)((int64_t)s.decW * maxH / s.decH);
+    }
+    if (s.dstW < 1) s.dstW = 1;
+    if (s.dstH < 1) s.dstH = 1;
+    return s;
+}
+
+class JpegFit {
+public:
+    // swapIn/swapOut: pixels are byte-swapped RGB565 on input/output
+    bool begin(int srcW, int srcH, int dstW, int dstH, bool swapIn, bool swapOut)
+    {
+        end();
+        sw = srcW;
+        sh = srcH;
+        dw = dstW;
+        dh = dstH;
+        inSwap = swapIn;
+        outSwap = swapOut;
+        xs = (Axis *)malloc(dw * sizeof(Axis));
+        ys = (Axis *)malloc(dh * sizeof(Axis));
+        rowCarry = (uint16_t *)malloc(sw * sizeof(uint16_t));
+        if (!xs || !ys || !rowCarry) {
+            end();
+            return false;
+        }
+        buildAxis(xs, dw, sw);
+        buildAxis(ys, dh, sh);
+        return true;
+    }
+
+    void end()
+    {
+        free(xs);
+        free(ys);
+        free(rowCarry);
+        xs = ys = nullptr;
+        rowCarry = nullptr;
+    }
+
+    // One decoded block at (bx, by) in source coordinates; dst is the
+    // top-left of the fitted image in the output buffer
+    void block(const uint16_t *px, int stride, int bx, int by, int bw, int bh,
+               uint16_t *dst, int dstStride)
+    {
+        if (bx + bw > sw) bw = sw - bx;
+        if (by + bh > sh) bh = sh - by;
+        if (bw <= 0 || bh <= 0 || bh > JPEG_FIT_MAX_BLOCK_H) return;
+
+        int dx0 = lowerBound(xs, dw, bx), dx1 = lowerBound(xs, dw, bx + bw);
+        int dy0 = lowerBound(ys, dh, by), dy1 = lowerBound(ys, dh, by + bh);
+
+        for (int dy = dy0; dy < dy1; dy++) {
+            const Axis &ay = ys[dy];
+            int y1 = ay.p1, y0 = ay.w ? y1 - 1 : y1;
+            uint16_t *out = dst + dy * dstStride;
+            for (int dx = dx0; dx < dx1; dx++) {
+                const Axis &ax = xs[dx];
+                int x1 = ax.p1, x0 = ax.w ? x1 - 1 : x1;
+                uint16_t v;
+                if (!ax.w && !ay.w) {
+                    v = rd(at(px, stride, bx, by, x1, y1));
+                } else {
+                    v = blend(rd(at(px, stride, bx, by, x0, y0)), rd(at(px, stride, bx, by, x1, y0)),
+                              rd(at(px, stride, bx, by, x0, y1)), rd(at(px, stride, bx, by, x1, y1)),
+                              ax.w, ay.w);
+                }
+                out[dx] = outSwap ? swap16(v) : v;
+            }
+        }
+
+        // Carries for the next block on the right and the next MCU row
+        uint16_t nextCorner = rowCarry[bx + bw - 1];
+        memcpy(rowCarry + bx, px + (bh - 1) * stride, bw * sizeof(uint16_t));
+        for (int y = 0; y < bh; y++) leftCol[y] = px[y * stride + bw - 1];
+        corner = nextCorner;
+    }
+
+private:
+    struct Axis {
+        uint16_t p1;    // source index owning the sample (bottom/right tap)
+        uint8_t w;      // weight of p1 (0..32), p1 - 1 gets 32 - w
+    };
+
+    static void buildAxis(Axis *a, int dst, int src)
+    {
+        for (int d = 0; d < dst; d++) {
+            // Pixel centres aligned, 8 fractional bits
+            int32_t s = (int32_t)(((int64_t)(2 * d + 1) * src * 256) / (2 * dst)) - 128;
+            if (s < 0) s = 0;
+            int p0 = s >> 8;
+            int w = ((s & 255) + 4) >> 3;
+            if (p0 >= src - 1) {
+                p0 = src - 1;
+                w = 0;
+            }
+            if (w >= 32) {
+                p0++;
+                w = 0;
+            }
+            a[d].p1 = w ? p0 + 1 : p0;
+            a[d].w = w;
+        }
+    }
+
+    static int lowerBound(const Axis *a, int n, int v)
+    {
+        int lo = 0, hi = n;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (a[mid].p1 < v) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Source pixel (x, y): inside the block or just above/left of it
+    uint16_t at(const uint16_t *px, int stride, int bx, int by, int x, int y) const
+    {
+        if (x >= bx) return y >= by ? px[(y - by) * stride + (x - bx)] : rowCarry[x];
+        return y >= by ? leftCol[y - by] : corner;
+    }
+
+    uint16_t rd(uint16_t v) const { return inSwap ? swap16(v) : v; }
+
+    static uint16_t swap16(uint16_t v) { return (v >> 8) | (v << 8); }
+
+    // RGB565 spread over 32 bits (G high, R/B low) so that each field can
+    // be multiplied by a 5-bit weight without overflowing into the next
+    static uint32_t spread(uint16_t p) { return (p | ((uint32_t)p << 16)) & 0x07E0F81F; }
+    static uint16_t pack(uint32_t v) { return (uint16_t)((v & 0xF81F) | ((v >> 16) & 0x07E0)); }
+
+    static uint16_t blend(uint16_t a, uint16_t b, uint16_t c, uint16_t d, uint32_t wx, uint32_t wy)
+    {
+        uint32_t top = ((spread(a) * (32 - wx) + spread(b) * wx) >> 5) & 0x07E0F81F;
+        uint32_t bot = ((spread(c) * (32 - wx) + spread(d) * wx) >> 5) & 0x07E0F81F;
+        return pack(((top * (32 - wy) + bot * wy) >> 5) & 0x07E0F81F);
+    }
+
+    int sw = 0, sh = 0, dw = 0, dh = 0;
+    bool inSwap = false, outSwap = false;
+    Axis *xs = nullptr;
+    Axis *ys = nullptr;
+    uint16_t *rowCarry = nullptr;
+    uint16_t leftCol[JPEG_FIT_MAX_BLOCK_H] = {};
+    uint16_t corner = 0;
+};
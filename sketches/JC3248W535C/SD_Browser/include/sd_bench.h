@@ -0,0 +1,136 @@
+/*
+ * sd_bench.h - SD_MMC mount configuration and throughput measurements
+ *
+ * SdConfig is what can be tuned on a mount: bus width, host clock and the
+ * read size used by the application (SdReadAhead block). The measurements
+ * work on files kept in SD_BENCH_DIR, created once:
+ *   - sequential: the whole data file, read 'buf' bytes at a time
+ *   - random: SD_BENCH_RANDOM_READS reads of 'buf' bytes at aligned offsets
+ *   - directory: f_readdir() over SD_BENCH_DIR_FILES entries, the same
+ *     path DirPager uses, repeated for SD_BENCH_DIR_MS
+ * A fixed data set keeps the results comparable from card to card.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SD_MMC.h>
+#include "ff.h"
+#include "dir_pager.h"
+
+#define SD_BENCH_DIR          "/.sdbench"
+#define SD_BENCH_FILE         SD_BENCH_DIR "/data.bin"
+#define SD_BENCH_FILE_SIZE    (2 * 1024 * 1024)
+#define SD_BENCH_DIR_FILES    128
+#define SD_BENCH_RANDOM_READS 64
+#define SD_BENCH_DIR_MS       250
+#define SD_BENCH_MAX_BUF      (32 * 1024)
+
+struct SdConfig {
+    uint8_t width;        // 1 or 4
+    uint16_t freqKhz;     // host clock, SDMMC_FREQ_*
+    uint32_t buf;         // application read size
+};
+
+struct SdBenchResult {
+    uint32_t seqKBs;
+    uint32_t randKBs;
+    uint32_t randIops;
+    uint32_t dirEps;      // directory entries per second
+};
+
+// Mounts SD_MMC with 'cfg'; the pins must have been set by the caller
+inline bool sdMount(const SdConfig &cfg)
+{
+    if (!SD_MMC.begin("/sdcard", cfg.width == 1, false, cfg.freqKhz, 5)) return false;
+    if (SD_MMC.cardType() == CARD_NONE) {
+        SD_MMC.end();
+        return false;
+    }
+    return true;
+}
+
+// Creates the data file and the directory entries if missing
+inline bool sdBenchPrepare(fs::FS &fsys, uint8_t *buf, size_t bufLen)
+{
+    fsys.mkdir(SD_BENCH_DIR);
+
+    File f = fsys.open(SD_BENCH_FILE);
+    bool haveData = f && f.size() == SD_BENCH_FILE_SIZE;
+    if (f) f.close();
+    if (!haveData) {
+        f = fsys.open(SD_BENCH_FILE, FILE_WRITE);
+        if (!f) return false;
+        for (size_t i = 0; i < bufLen; i++) buf[i] = (uint8_t)(i * 7);
+        for (size_t done = 0; done < SD_BENCH_FILE_SIZE; done += bufLen) {
+            size_t n = min(bufLen, (size_t)SD_BENCH_FILE_SIZE - done);
+            if (f.write(buf, n) != n) {
+                f.close();
+                return false;
+            }
+        }
+        f.close();
+    }
+
+    char path[48];
+    snprintf(path, sizeof(path), SD_BENCH_DIR "/e%03d", SD_BENCH_DIR_FILES - 1);
+    if (!fsys.exists(path)) {
+        for (int i = 0; i < SD_BENCH_DIR_FILES; i++) {
+            snprintf(path, sizeof(path), SD_BENCH_DIR "/e%03d", i);
+            File e = fsys.open(path, FILE_WRITE);
+            if (!e) return false;
+            e.close();
+        }
+    }
+    return true;
+}
+
+inline uint32_t sdBenchRate(uint64_t units, uint32_t us)
+{
+    return us ? (uint32_t)(units * 1000000ULL / us) : 0;
+}
+
+inline bool sdBenchRead(fs::FS &fsys, uint8_t *buf, uint32_t len, SdBenchResult &r)
+{
+    File f = fsys.open(SD_BENCH_FILE);
+    if (!f) return false;
+
+    uint32_t t0 = micros();
+    uint32_t total = 0;
+    for (;;) {
+        size_t n = f.read(buf, len);
+        if (n == 0) break;
+        total += n;
+    }
+    uint32_t seqUs = micros() - t0;
+
+    uint32_t blocks = SD_BENCH_FILE_SIZE / len;
+    t0 = micros();
+    for (int i = 0; i < SD_BENCH_RANDOM_READS; i++) {
+        f.seek((esp_random() % blocks) * len);
+        f.read(buf, len);
+    }
+    uint32_t randUs = micros() - t0;
+    f.close();
+
+    r.seqKBs = sdBenchRate(total / 1024, seqUs);
+    r.randIops = sdBenchRate(SD_BENCH_RANDOM_READS, randUs);
+    r.randKBs = sdBenchRate((uint64_t)SD_BENCH_RANDOM_READS * len / 1024, randUs);
+    return total == SD_BENCH_FILE_SIZE;
+}
+
+inline uint32_t sdBenchDir()
+{
+    FF_DIR dir;
+    FILINFO fno;
+    uint32_t entries = 0;
+    uint32_t t0 = micros(), us = 0;
+    while (us < SD_BENCH_DIR_MS * 1000) {
+        if (f_opendir(&dir, SD_FATFS_DRIVE SD_BENCH_DIR) != FR_OK) return 0;
+        while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0]) entries++;
+        f_closedir(&dir);
+        us = micros() - t0;
+    }
+    return sdBenchRate(entries, us);
+}
@@ -0,0 +1,219 @@
+/*
+ * sd_readahead.h - Read-ahead file source for JPEGDEC callbacks
+ *
+ * A dedicated reader task fills a small ring of blocks from the SD card
+ * while the decoder consumes the previous ones, so SD transfers overlap
+ * with Huffman/IDCT work instead of preceding it. The reader is driven by
+ * requests (slot + file offset) and answers in FIFO order; a seek outside
+ * the block being consumed drains the outstanding requests and restarts
+ * the window at the new offset.
+ *
+ * Draining waits without a timeout: until the reader is idle it may still
+ * be writing a slot or using the File. Every request also carries the
+ * generation of the file/window it was made for, and answers from an older
+ * generation are dropped, so a late block can never be handed to the
+ * decoder as data of the next file.
+ *
+ * Only one file is streamed at a time (one decoder).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <JPEGDEC.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#define READAHEAD_BLOCKS      4
+#define READAHEAD_BLOCK_SIZE  (8 * 1024)
+#define READAHEAD_TIMEOUT_MS  2000
+
+class SdReadAhead {
+public:
+    // Allocates the ring (DMA-capable internal RAM when available) and
+    // starts the reader task once. A new block size reallocates the ring;
+    // call it only between two files.
+    bool init(uint32_t block = READAHEAD_BLOCK_SIZE)
+    {
+        if (block != blockSize) {
+            for (int i = 0; i < READAHEAD_BLOCKS; i++) {
+                heap_caps_free(buf[i]);
+                buf[i] = nullptr;
+            }
+            blockSize = block;
+        }
+        for (int i = 0; i < READAHEAD_BLOCKS; i++) {
+            if (buf[i]) continue;
+            buf[i] = (uint8_t *)heap_caps_malloc(blockSize, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            if (!buf[i]) buf[i] = (uint8_t *)heap_caps_malloc(blockSize, MALLOC_CAP_SPIRAM);
+            if (!buf[i]) return false;
+        }
+        if (reqQ) return true;
+        reqQ = xQueueCreate(READAHEAD_BLOCKS, sizeof(Request));
+        doneQ = xQueueCreate(READAHEAD_BLOCKS, sizeof(Done));
+        if (!reqQ || !doneQ) return false;
+        return xTaskCreate(readerTask, "sd_read", 4096, this, 5, NULL) == pdPASS;
+    }
+
+    bool open(const char *path)
+    {
+        drain();                // reader idle before the File is replaced
+        file = fs->open(path);
+        if (!file) return false;
+        size = file.size();
+        nextPos = 0;
+        haveHead = false;
+        readBytes = 0;
+        readUs = 0;
+        waitUs = 0;
+        fill();
+        return true;
+    }
+
+    void close()
+    {
+        drain();
+        file.close();
+    }
+
+    int32_t read(JPEGFILE *f, uint8_t *dst, int32_t len)
+    {
+        int32_t copied = 0;
+        while (copied < len) {
+            if (!haveHead && !takeHead()) break;
+            int32_t n = min(headLen - headOff, len - copied);
+            memcpy(dst + copied, buf[headSlot] + headOff, n);
+            headOff += n;
+            copied += n;
+            if (headOff >= headLen) {
+                haveHead = false;
+                request(headSlot);
+            }
+        }
+        f->iPos += copied;
+        return copied;
+    }
+
+    int32_t seek(JPEGFILE *f, int32_t pos)
+    {
+        if (pos < 0 || pos > (int32_t)size) return -1;
+        if (haveHead && pos >= headPos && pos < headPos + headLen) {
+            headOff = pos - headPos;
+        } else {
+            drain();
+            nextPos = pos;
+            fill();
+        }
+        f->iPos = pos;
+        return pos;
+    }
+
+    void attach(fs::FS &fsys) { fs = &fsys; }
+
+    uint32_t fileSize() const { return size; }
+
+    // Statistics of the last file: bytes read, time spent in SD reads by
+    // the reader task, time the decoder spent waiting for data
+    uint32_t readBytes;
+    uint32_t readUs;
+    uint32_t waitUs;
+
+private:
+    struct Request {
+        uint8_t slot;
+        uint32_t pos;
+        uint32_t gen;
+    };
+    struct Done {
+        uint8_t slot;
+        uint32_t pos;
+        int32_t len;
+        uint32_t gen;
+    };
+
+    static void readerTask(void *arg)
+    {
+        SdReadAhead *self = (SdReadAhead *)arg;
+        Request rq;
+        for (;;) {
+            if (xQueueReceive(self->reqQ, &rq, portMAX_DELAY) != pdTRUE) continue;
+            uint32_t t0 = micros();
+            Done d = {rq.slot, rq.pos, -1, rq.gen};
+            if (self->file.seek(rq.pos)) {
+                d.len = self->file.read(self->buf[rq.slot], self->blockSize);
+            }
+            self->readUs += micros() - t0;
+            if (d.len > 0) self->readBytes += d.len;
+            xQueueSend(self->doneQ, &d, portMAX_DELAY);
+        }
+    }
+
+    // Queue a block read into 'slot' at the next offset, if any remain
+    void request(uint8_t slot)
+    {
+        if (nextPos >= size) return;
+        Request rq = {slot, nextPos, gen};
+        nextPos += blockSize;
+        outstanding++;
+        xQueueSend(reqQ, &rq, portMAX_DELAY);
+    }
+
+    void fill()
+    {
+        for (int i = 0; i < READAHEAD_BLOCKS; i++) request(i);
+    }
+
+    // A timeout leaves the request in flight (still counted in
+    // 'outstanding'): its answer is consumed later, or by drain()
+    bool takeHead()
+    {
+        Done d;
+        do {
+            if (!outstanding) return false;   // end of file
+            uint32_t t0 = micros();
+            bool ok = xQueueReceive(doneQ, &d, pdMS_TO_TICKS(READAHEAD_TIMEOUT_MS)) == pdTRUE;
+            waitUs += micros() - t0;
+            if (!ok) return false;
+            outstanding--;
+        } while (d.gen != gen);               // stale block of an older window
+        if (d.len <= 0) return false;   // read error: short read for the decoder
+        headSlot = d.slot;
+        headPos = d.pos;
+        headLen = d.len;
+        headOff = 0;
+        haveHead = true;
+        return true;
+    }
+
+    // Wait for every in-flight read so that no slot is being written and
+    // the File is not in use, then start a new generation
+    void drain()
+    {
+        Done d;
+        while (outstanding) {
+            xQueueReceive(doneQ, &d, portMAX_DELAY);
+            outstanding--;
+        }
+        if (doneQ) xQueueReset(doneQ);
+        gen++;
+        haveHead = false;
+    }
+
+    fs::FS *fs = nullptr;
+    File file;
+    uint32_t blockSize = READAHEAD_BLOCK_SIZE;
+    uint32_t size = 0;
+    uint32_t nextPos = 0;
+    int outstanding = 0;
+    uint32_t gen = 0;
+    uint8_t *buf[READAHEAD_BLOCKS] = {};
+    QueueHandle_t reqQ = nullptr;
+    QueueHandle_t doneQ = nullptr;
+
+    bool haveHead = false;
+    uint8_t headSlot = 0;
+    int32_t headPos = 0;
+    int32_t headLen = 0;
+    int32_t headOff = 0;
+};
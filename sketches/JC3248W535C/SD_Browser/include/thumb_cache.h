@@ -0,0 +1,229 @@
+/*
+ * thumb_cache.h - Background JPEG thumbnail cache on the SD card
+ *
+ * A worker task turns requests (image path + size) into THUMB_W x THUMB_H
+ * RGB565 thumbnails, already in lv_color_t byte order. Each thumbnail is
+ * stored once in THUMB_DIR/<xx>/<hash>.565 (hash of path and size, 256
+ * sub-folders to keep FAT lookups short); later requests only read
+ * 4 + 3456 bytes. Generation uses the EXIF thumbnail when the file has
+ * one, otherwise a 1/8 DCT-scaled decode, then JpegFit.
+ *
+ * Visible rows are queued at the front, background prefetch at the back.
+ * Results go through the deliver callback, from the worker task; a
+ * request whose row has been recycled meanwhile is skipped via isCurrent.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <JPEGDEC.h>
+#include <lvgl.h>
+#include <new>
+#include "jpeg_fit.h"
+
+#define THUMB_W        48
+#define THUMB_H        36
+#define THUMB_DIR      "/.thumbs"
+#define THUMB_QUEUE    16
+#define THUMB_NO_SLOT  0xFF   // prefetch: store only, nothing to deliver
+
+class ThumbCache {
+public:
+    typedef bool (*IsCurrent)(uint8_t slot, uint32_t gen);
+    typedef void (*Deliver)(uint8_t slot, uint32_t gen, const uint16_t *px);
+
+    bool begin(fs::FS &fsys, IsCurrent current, Deliver deliver)
+    {
+        if (queue) return true;
+        fs = &fsys;
+        isCurrent = current;
+        onDone = deliver;
+        void *mem = heap_caps_malloc(sizeof(JPEGDEC), MALLOC_CAP_SPIRAM);
+        if (!mem) return false;
+        dec = new (mem) JPEGDEC();
+        queue = xQueueCreate(THUMB_QUEUE, sizeof(Request));
+        busy = xSemaphoreCreateMutex();
+        if (!queue || !busy) return false;
+        fs->mkdir(THUMB_DIR);
+        return xTaskCreate(worker, "thumbs", 6144, this, 2, NULL) == pdPASS;
+    }
+
+    // Non-blocking; returns false when the queue is full
+    bool request(const char *path, uint32_t size, uint8_t slot, uint32_t gen)
+    {
+        if (!queue) return false;
+        Request rq;
+        strlcpy(rq.path, path, sizeof(rq.path));
+        rq.size = size;
+        rq.slot = slot;
+        rq.gen = gen;
+        if (slot == THUMB_NO_SLOT) return xQueueSendToBack(queue, &rq, 0) == pdTRUE;
+        return xQueueSendToFront(queue, &rq, 0) == pdTRUE;
+    }
+
+    bool idle() const { return queue && uxQueueMessagesWaiting(queue) == 0; }
+
+    // Holds the worker between two thumbnails, no file left open (e.g.
+    // while the card is remounted). Not from a task holding the display
+    // lock: the worker may be waiting for it in deliver.
+    void pause()
+    {
+        if (busy) xSemaphoreTake(busy, portMAX_DELAY);
+    }
+    void resume()
+    {
+        if (busy) xSemaphoreGive(busy);
+    }
+
+    uint32_t hits = 0;
+    uint32_t built = 0;
+    uint32_t failed = 0;
+
+private:
+    struct Request {
+        char path[192];
+        uint32_t size;
+        uint8_t slot;
+        uint32_t gen;
+    };
+
+    struct Header {
+        char magic[2];      // "T1"
+        uint8_t w, h;
+    };
+
+    static void worker(void *arg)
+    {
+        ThumbCache *self = (ThumbCache *)arg;
+        Request rq;
+        for (;;) {
+            if (xQueueReceive(self->queue, &rq, portMAX_DELAY) != pdTRUE) continue;
+            bool visible = rq.slot != THUMB_NO_SLOT;
+            if (visible && !self->isCurrent(rq.slot, rq.gen)) continue;
+            xSemaphoreTake(self->busy, portMAX_DELAY);
+            bool ok = self->get(rq);
+            if (ok && visible) self->onDone(rq.slot, rq.gen, self->px);
+            xSemaphoreGive(self->busy);
+        }
+    }
+
+    static uint32_t fnv1a(const char *s, uint32_t h = 2166136261u)
+    {
+        while (*s) {
+            h ^= (uint8_t)*s++;
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    bool get(const Request &rq)
+    {
+        uint32_t key = fnv1a(rq.path) ^ (rq.size * 2654435761u);
+        char dir[24], file[40];
+        snprintf(dir, sizeof(dir), THUMB_DIR "/%02x", (unsigned)(key >> 24));
+        snprintf(file, sizeof(file), "%s/%06x.565", dir, (unsigned)(key & 0xFFFFFF));
+
+        if (load(file)) {
+            hits++;
+            return true;
+        }
+        if (!build(rq.path)) {
+            failed++;
+            return false;
+        }
+        built++;
+        fs->mkdir(dir);
+        File f = fs->open(file, FILE_WRITE);
+        if (f) {
+            Header h = {{'T', '1'}, THUMB_W, THUMB_H};
+            f.write((const uint8_t *)&h, sizeof(h));
+            f.write((const uint8_t *)px, sizeof(px));
+            f.close();
+        }
+        return true;
+    }
+
+    bool load(const char *file)
+    {
+        File f = fs->open(file);
+        if (!f) return false;
+        Header h;
+        bool ok = f.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+                  h.magic[0] == 'T' && h.magic[1] == '1' && h.w == THUMB_W && h.h == THUMB_H &&
+                  f.read((uint8_t *)px, sizeof(px)) == sizeof(px);
+        f.close();
+        return ok;
+    }
+
+    bool build(const char *path)
+    {
+        File f = fs->open(path);
+        if (!f) return false;
+        src = &f;
+        active = this;
+        bool ok = false;
+        if (dec->open(path, openCb, closeCb, readCb, seekCb, drawCb)) {
+            dec->setPixelType(LV_COLOR_16_SWAP ? RGB565_BIG_ENDIAN : RGB565_LITTLE_ENDIAN);
+            int options = 0;
+            int w = dec->getWidth(), h = dec->getHeight();
+            if (dec->hasThumb()) {
+                options = JPEG_EXIF_THUMBNAIL;
+                w = dec->getThumbWidth();
+                h = dec->getThumbHeight();
+            }
+            JpegScale sc = jpegPickScale(w, h, THUMB_W, THUMB_H);
+            options |= sc.div == 8 ? JPEG_SCALE_EIGHTH : sc.div == 4 ? JPEG_SCALE_QUARTER :
+                       sc.div == 2 ? JPEG_SCALE_HALF : 0;
+            offX = (THUMB_W - sc.dstW) / 2;
+            offY = (THUMB_H - sc.dstH) / 2;
+            memset(px, 0, sizeof(px));
+            if (fit.begin(sc.decW, sc.decH, sc.dstW, sc.dstH, LV_COLOR_16_SWAP, LV_COLOR_16_SWAP)) {
+                ok = dec->decode(0, 0, options) == 1;
+                fit.end();
+            }
+        }
+        dec->close();
+        src = nullptr;
+        return ok;
+    }
+
+    // JPEGDEC callbacks (one worker, one file at a time)
+    static void *openCb(const char *, int32_t *size)
+    {
+        *size = active->src->size();
+        return active->src;
+    }
+    static void closeCb(void *handle) { ((File *)handle)->close(); }
+    static int32_t readCb(JPEGFILE *f, uint8_t *buf, int32_t len)
+    {
+        int32_t n = ((File *)f->fHandle)->read(buf, len);
+        if (n > 0) f->iPos += n;
+        return n;
+    }
+    static int32_t seekCb(JPEGFILE *f, int32_t pos)
+    {
+        f->iPos = pos;
+        return ((File *)f->fHandle)->seek(pos) ? pos : -1;
+    }
+    static int drawCb(JPEGDRAW *d)
+    {
+        ThumbCache *self = active;
+        self->fit.block(d->pPixels, d->iWidth, d->x, d->y, d->iWidth, d->iHeight,
+                        self->px + self->offY * THUMB_W + self->offX, THUMB_W);
+        return 1;
+    }
+
+    static inline ThumbCache *active = nullptr;
+
+    fs::FS *fs = nullptr;
+    IsCurrent isCurrent = nullptr;
+    Deliver onDone = nullptr;
+    QueueHandle_t queue = nullptr;
+    SemaphoreHandle_t busy = nullptr;
+    JPEGDEC *dec = nullptr;
+    JpegFit fit;
+    File *src = nullptr;
+    int offX = 0, offY = 0;
+    uint16_t px[THUMB_W * THUMB_H];
+};
@@ -20,9 +20,16 @@
 #include <SD_MMC.h>
 #include <lvgl.h>
 #include <JPEGDEC.h>
+#include <Preferences.h>
 #include "display.h"
 #include "esp_bsp.h"
 #include "lv_port.h"
+#include "sd_readahead.h"
+#include "jpeg_fit.h"
+#include "jpeg_blit.h"
+#include "dir_pager.h"
+#include "thumb_cache.h"
+#include "sd_bench.h"
 
 #define LVGL_PORT_ROTATION_DEGREE (270)
 
@@ -30,6 +37,8 @@
 #define SD_MMC_CLK  12
 #define SD_MMC_CMD  11
 #define SD_MMC_D0   13
+// 4-bit bus: define SD_MMC_D1..D3 if the slot wires them. The JC3248W535C
+// slot only has D0, so the benchmark only tries 1-bit mode.
 
 // Colors
 #define COLOR_BG        0x1a1a2e
@@ -47,7 +56,9 @@ static lv_obj_t *label_path;
 static lv_obj_t *btn_back;
 static lv_obj_t *btn_info;
 static lv_obj_t *btn_refresh;
-static lv_obj_t *list_files;
+static lv_obj_t *list_files;      // messages and SD info
+static lv_obj_t *file_view;       // virtualized directory listing
+static lv_obj_t *file_spacer;
 static lv_obj_t *img_overlay = nullptr;
 static lv_obj_t *img_view = nullptr;
 
@@ -56,6 +67,30 @@ static String currentPath = "/";
 static bool sdCardOk = false;
 static bool showingInfo = false;
 static bool showingImage = false;
+static volatile bool benchRunning = false;
+
+// Mount configuration, saved by the benchmark
+static SdConfig sdConfig = {1, SDMMC_FREQ_DEFAULT, READAHEAD_BLOCK_SIZE};
+static const SdConfig sdDefaultConfig = {1, SDMMC_FREQ_DEFAULT, READAHEAD_BLOCK_SIZE};
+static Preferences prefs;
+
+static void loadSdConfig()
+{
+    prefs.begin("sdbrowser", true);  // read-only
+    sdConfig.width   = prefs.getUChar ("width", sdConfig.width);
+    sdConfig.freqKhz = prefs.getUShort("freq",  sdConfig.freqKhz);
+    sdConfig.buf     = prefs.getULong ("buf",   sdConfig.buf);
+    prefs.end();
+}
+
+static void saveSdConfig()
+{
+    prefs.begin("sdbrowser", false);  // read-write
+    prefs.putUChar ("width", sdConfig.width);
+    prefs.putUShort("freq",  sdConfig.freqKhz);
+    prefs.putULong ("buf",   sdConfig.buf);
+    prefs.end();
+}
 
 // Format size to human readable
 static String formatSize(uint64_t bytes)
@@ -90,195 +125,178 @@ static bool isImageFile(const char* name)
     return filename.endsWith(".jpg") || filename.endsWith(".jpeg");
 }
 
-// JPEG decoder instance and canvas buffer
+// JPEG decoder instance (decoder task only) and its target canvas
+#define CANVAS_W  480
+#define CANVAS_H  320
 static JPEGDEC jpeg;
 static lv_obj_t *img_canvas = nullptr;
 static lv_color_t *canvas_buf = nullptr;
-static int canvas_width = 0;
-static int canvas_height = 0;
+static const int canvas_width = CANVAS_W;
+static const int canvas_height = CANVAS_H;
 static int img_offset_x = 0;
 static int img_offset_y = 0;
+static int img_clip_x = 0;     // right/bottom edge of the image on the canvas
+static int img_clip_y = 0;
+
+// JPEG source: streamed from SD_MMC through the read-ahead ring
+static SdReadAhead sdStream;
+static uint32_t decodeStartUs = 0;
+static uint32_t firstPixelUs = 0;
 
-// Close image overlay callback
-static void close_image_cb(lv_event_t *e)
+// Fit-to-screen: DCT scaling chosen per image, bilinear rest on the blocks
+static JpegFit jpegFit;
+static bool fitActive = false;
+
+// Cancellation: a decode stops at its next MCU block once decodeGen no
+// longer matches the generation it was started with
+static volatile uint32_t decodeGen = 0;
+static uint32_t decodeJobGen = 0;
+
+static void *jpegOpenCb(const char *filename, int32_t *size)
 {
-    if (img_overlay) {
-        lv_obj_del(img_overlay);
-        img_overlay = nullptr;
-        img_view = nullptr;
-        img_canvas = nullptr;
-        showingImage = false;
+    if (!sdStream.open(filename)) return nullptr;
+    *size = sdStream.fileSize();
+    return &sdStream;
+}
 
-        // Free canvas buffer
-        if (canvas_buf) {
-            heap_caps_free(canvas_buf);
-            canvas_buf = nullptr;
-        }
-    }
+static void jpegCloseCb(void *handle)
+{
+    sdStream.close();
+}
+
+static int32_t jpegReadCb(JPEGFILE *file, uint8_t *buf, int32_t len)
+{
+    return sdStream.read(file, buf, len);
+}
+
+static int32_t jpegSeekCb(JPEGFILE *file, int32_t pos)
+{
+    return sdStream.seek(file, pos);
 }
 
 // JPEG draw callback - called for each decoded MCU block
 static int jpegDrawCallback(JPEGDRAW *pDraw)
 {
-    if (!canvas_buf) return 0;
-
-    // Draw pixels to canvas buffer
-    uint16_t *src = pDraw->pPixels;
-    for (int y = 0; y < pDraw->iHeight; y++) {
-        int destY = pDraw->y + y + img_offset_y;
-        if (destY < 0 || destY >= canvas_height) continue;
-
-        for (int x = 0; x < pDraw->iWidth; x++) {
-            int destX = pDraw->x + x + img_offset_x;
-            if (destX < 0 || destX >= canvas_width) continue;
-
-            uint16_t pixel = src[y * pDraw->iWidth + x];
-            // Convert RGB565 to lv_color
-            canvas_buf[destY * canvas_width + destX] = lv_color_make(
-                (pixel >> 8) & 0xF8,  // R
-                (pixel >> 3) & 0xFC,  // G
-                (pixel << 3) & 0xF8   // B
-            );
-        }
+    if (!canvas_buf || decodeJobGen != decodeGen) return 0;   // cancelled
+    if (!firstPixelUs) firstPixelUs = micros() - decodeStartUs;
+
+    if (fitActive) {
+        jpegFit.block(pDraw->pPixels, pDraw->iWidth, pDraw->x, pDraw->y, pDraw->iWidth, pDraw->iHeight,
+                      (uint16_t *)canvas_buf + img_offset_y * canvas_width + img_offset_x, canvas_width);
+        return 1;
     }
+
+    // JPEGDEC already emits the canvas byte order (see decodeImage)
+    jpegBlitClipped(pDraw->pPixels, pDraw->iWidth, pDraw->iHeight, pDraw->x + img_offset_x,
+                    pDraw->y + img_offset_y, (uint16_t *)canvas_buf, canvas_width,
+                    img_offset_x, img_offset_y, img_clip_x, img_clip_y);
     return 1;
 }
 
-// Show image in fullscreen overlay
-static void showImage(const char* filepath)
+// Decode an image into a CANVAS_W x CANVAS_H buffer (decoder task).
+// Returns false on error or when cancelled through decodeGen.
+static bool decodeImage(const char* filepath, lv_color_t *buf, uint32_t gen)
 {
     Serial.printf("Opening image: %s\n", filepath);
 
-    // Open and read file to PSRAM
-    File f = SD_MMC.open(filepath);
-    if (!f) {
-        Serial.printf("File not found: %s\n", filepath);
-        return;
-    }
-    size_t fileSize = f.size();
-    Serial.printf("File size: %u bytes\n", fileSize);
-
-    // Limit file size (2MB max)
-    if (fileSize > 2 * 1024 * 1024) {
-        Serial.println("File too large");
-        f.close();
-        return;
-    }
-
-    // Allocate buffer for JPEG data in PSRAM
-    uint8_t *jpegBuf = (uint8_t *)heap_caps_malloc(fileSize, MALLOC_CAP_SPIRAM);
-    if (!jpegBuf) {
-        Serial.println("Failed to allocate JPEG buffer");
-        f.close();
-        return;
+    // Stream the file: no whole-file copy, no size limit
+    if (!sdStream.init(sdConfig.buf)) {
+        Serial.println("Failed to start SD read-ahead");
+        return false;
     }
-
-    // Read file
-    size_t bytesRead = f.read(jpegBuf, fileSize);
-    f.close();
-    if (bytesRead != fileSize) {
-        Serial.println("Failed to read file");
-        heap_caps_free(jpegBuf);
-        return;
+    decodeStartUs = micros();
+    firstPixelUs = 0;
+    if (!jpeg.open(filepath, jpegOpenCb, jpegCloseCb, jpegReadCb, jpegSeekCb, jpegDrawCallback)) {
+        Serial.printf("Failed to open JPEG (error %d)\n", jpeg.getLastError());
+        jpeg.close();
+        return false;
     }
+    Serial.printf("File size: %u bytes\n", sdStream.fileSize());
 
-    // Open JPEG decoder with RAM buffer
-    if (!jpeg.openRAM(jpegBuf, fileSize, jpegDrawCallback)) {
-        Serial.println("Failed to open JPEG");
-        heap_caps_free(jpegBuf);
-        return;
-    }
+    // Emit pixels in lv_color_t layout: with LV_COLOR_16_SWAP the canvas
+    // holds big-endian RGB565, the same order the panel receives
+    static_assert(sizeof(lv_color_t) == sizeof(uint16_t), "canvas must be RGB565");
+    jpeg.setPixelType(LV_COLOR_16_SWAP ? RGB565_BIG_ENDIAN : RGB565_LITTLE_ENDIAN);
 
     int imgW = jpeg.getWidth();
     int imgH = jpeg.getHeight();
     Serial.printf("JPEG: %dx%d\n", imgW, imgH);
 
-    // Calculate display size (fit to screen 480x320)
-    canvas_width = 480;
-    canvas_height = 320;
+    // Strongest DCT scaling that still covers the fitted size
+    JpegScale scale = jpegPickScale(imgW, imgH, canvas_width, canvas_height);
+    int scaleOpt = scale.div == 8 ? JPEG_SCALE_EIGHTH :
+                   scale.div == 4 ? JPEG_SCALE_QUARTER :
+                   scale.div == 2 ? JPEG_SCALE_HALF : 0;
+    fitActive = scale.dstW != scale.decW || scale.dstH != scale.decH;
+    if (fitActive && !jpegFit.begin(scale.decW, scale.decH, scale.dstW, scale.dstH, LV_COLOR_16_SWAP, LV_COLOR_16_SWAP)) {
+        Serial.println("Fit tables allocation failed, cropping");
+        fitActive = false;
+    }
+    Serial.printf("Scale 1/%d: decoded %dx%d, shown %dx%d%s\n", scale.div, scale.decW, scale.decH,
+                  scale.dstW, scale.dstH, fitActive ? " (bilinear)" : "");
 
     // Center image
-    img_offset_x = (canvas_width - imgW) / 2;
-    img_offset_y = (canvas_height - imgH) / 2;
+    int shownW = fitActive ? scale.dstW : scale.decW;
+    int shownH = fitActive ? scale.dstH : scale.decH;
+    img_offset_x = (canvas_width - shownW) / 2;
+    img_offset_y = (canvas_height - shownH) / 2;
     if (img_offset_x < 0) img_offset_x = 0;
     if (img_offset_y < 0) img_offset_y = 0;
+    img_clip_x = min(img_offset_x + shownW, canvas_width);
+    img_clip_y = min(img_offset_y + shownH, canvas_height);
 
-    // Allocate canvas buffer in PSRAM
-    canvas_buf = (lv_color_t *)heap_caps_malloc(canvas_width * canvas_height * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
-    if (!canvas_buf) {
-        Serial.println("Failed to allocate canvas buffer");
-        jpeg.close();
-        heap_caps_free(jpegBuf);
-        return;
-    }
-
-    // Fill with black
-    for (int i = 0; i < canvas_width * canvas_height; i++) {
-        canvas_buf[i] = lv_color_black();
-    }
+    // Fill with black (0x0000 in either byte order)
+    canvas_buf = buf;
+    decodeJobGen = gen;
+    memset(canvas_buf, 0, canvas_width * canvas_height * sizeof(lv_color_t));
 
     // Decode JPEG
     Serial.println("Decoding JPEG...");
-    jpeg.decode(0, 0, 0);  // No scaling
+    bool ok = jpeg.decode(0, 0, scaleOpt) == 1 && gen == decodeGen;
     jpeg.close();
-    heap_caps_free(jpegBuf);
-    Serial.println("Decode done");
-
-    bsp_display_lock(0);
-
-    // Create fullscreen overlay
-    img_overlay = lv_obj_create(lv_scr_act());
-    lv_obj_remove_style_all(img_overlay);
-    lv_obj_set_size(img_overlay, 480, 320);
-    lv_obj_align(img_overlay, LV_ALIGN_CENTER, 0, 0);
-    lv_obj_set_style_bg_color(img_overlay, lv_color_hex(0x000000), 0);
-    lv_obj_set_style_bg_opa(img_overlay, LV_OPA_COVER, 0);
-    lv_obj_add_event_cb(img_overlay, close_image_cb, LV_EVENT_CLICKED, NULL);
-
-    // Create canvas with decoded image
-    img_canvas = lv_canvas_create(img_overlay);
-    lv_canvas_set_buffer(img_canvas, canvas_buf, canvas_width, canvas_height, LV_IMG_CF_TRUE_COLOR);
-    lv_obj_center(img_canvas);
-
-    // Add close hint label
-    lv_obj_t *hint = lv_label_create(img_overlay);
-    lv_label_set_text(hint, "Tap pour fermer");
-    lv_obj_set_style_text_color(hint, lv_color_hex(0x888888), 0);
-    lv_obj_align(hint, LV_ALIGN_BOTTOM_MID, 0, -10);
-
-    showingImage = true;
-
-    bsp_display_unlock();
+    jpegFit.end();
+    fitActive = false;
+    canvas_buf = nullptr;
+    uint32_t totalUs = micros() - decodeStartUs;
+    Serial.printf("Decode %s: first pixel %lu ms, total %lu ms, SD %lu KB in %lu ms, decoder waited %lu ms\n",
+                  ok ? "done" : "stopped", (unsigned long)(firstPixelUs / 1000), (unsigned long)(totalUs / 1000),
+                  (unsigned long)(sdStream.readBytes / 1024), (unsigned long)(sdStream.readUs / 1000),
+                  (unsigned long)(sdStream.waitUs / 1000));
+    return ok;
 }
 
-// Image click callback
-static void image_click_cb(lv_event_t *e)
+// Set the SD_MMC pins for a bus width (before begin)
+static bool setSdPins(uint8_t width)
 {
-    const char *filepath = (const char *)lv_event_get_user_data(e);
-    if (filepath) {
-        showImage(filepath);
-    }
+#ifdef SD_MMC_D3
+    if (width == 4) return SD_MMC.setPins(SD_MMC_CLK, SD_MMC_CMD, SD_MMC_D0, SD_MMC_D1, SD_MMC_D2, SD_MMC_D3);
+#endif
+    return width == 1 && SD_MMC.setPins(SD_MMC_CLK, SD_MMC_CMD, SD_MMC_D0);
 }
 
-// Initialize SD card
+// Initialize SD card with the saved configuration, defaults as fallback
 static bool initSDCard()
 {
-    Serial.println("Setting SD_MMC pins...");
-    SD_MMC.setPins(SD_MMC_CLK, SD_MMC_CMD, SD_MMC_D0);
+    loadSdConfig();
+    Serial.printf("SD config: %u-bit, %u kHz, %lu B reads\n", sdConfig.width, sdConfig.freqKhz,
+                  (unsigned long)sdConfig.buf);
 
     Serial.println("Calling SD_MMC.begin()...");
-    if (!SD_MMC.begin("/sdcard", true, false, SDMMC_FREQ_DEFAULT, 5)) {
-        Serial.println("SD Card mount failed!");
-        return false;
+    if (!setSdPins(sdConfig.width) || !sdMount(sdConfig)) {
+        if (sdConfig.width == sdDefaultConfig.width && sdConfig.freqKhz == sdDefaultConfig.freqKhz) {
+            Serial.println("SD Card mount failed!");
+            return false;
+        }
+        // Saved settings may not suit another card
+        Serial.println("Mount failed, retrying with defaults");
+        sdConfig = sdDefaultConfig;
+        if (!setSdPins(sdConfig.width) || !sdMount(sdConfig)) {
+            Serial.println("SD Card mount failed!");
+            return false;
+        }
     }
 
     sdcard_type_t cardType = SD_MMC.cardType();
-    if (cardType == CARD_NONE) {
-        Serial.println("No SD card attached!");
-        SD_MMC.end();
-        return false;
-    }
-
     Serial.printf("SD Card Type: %s\n", getCardTypeString(cardType));
     Serial.printf("SD Card Size: %llu MB\n", SD_MMC.cardSize() / (1024 * 1024));
     return true;
@@ -307,23 +325,15 @@ static void navigateTo(const char* folder)
     updateFileList();
 }
 
-// File item click callback
-static void file_click_cb(lv_event_t *e)
-{
-    lv_obj_t *btn = lv_event_get_target(e);
-    const char *name = (const char *)lv_event_get_user_data(e);
-    if (name) {
-        navigateTo(name);
-    }
-}
-
 // Forward declarations
 static void showSDInfo();
 static void updateFileList();
+static void viewerOpen(int index);
 
 // Back button callback
 static void btn_back_cb(lv_event_t *e)
 {
+    if (benchRunning) return;
     if (showingInfo) {
         showingInfo = false;
         updateFileList();
@@ -335,6 +345,7 @@ static void btn_back_cb(lv_event_t *e)
 // Info button callback
 static void btn_info_cb(lv_event_t *e)
 {
+    if (benchRunning) return;
     showingInfo = !showingInfo;
     if (showingInfo) {
         showSDInfo();
@@ -346,6 +357,7 @@ static void btn_info_cb(lv_event_t *e)
 // Refresh button callback
 static void btn_refresh_cb(lv_event_t *e)
 {
+    if (benchRunning) return;
     if (showingInfo) {
         showSDInfo();
     } else {
@@ -353,7 +365,220 @@ static void btn_refresh_cb(lv_event_t *e)
     }
 }
 
-// Update file list
+// Virtualized file list: ROW_POOL row widgets recycled over the entries.
+// Entry i always lives in row i % ROW_POOL at y = i * ROW_H; the spacer
+// gives the view its full scroll height. y and the spacer height are
+// lv_coord_t: with 16-bit coordinates (LV_COORD_MAX 8191) they would wrap
+// past ~186 entries, hence LV_USE_LARGE_COORD in lv_conf.h.
+#if !LV_USE_LARGE_COORD
+#error "the file list needs LV_USE_LARGE_COORD 1 (row y = index * ROW_H)"
+#endif
+#define ROW_H         44
+#define ROW_POOL      8       // > visible rows + 1 (230 px / ROW_H)
+#define INDEX_BUDGET  64      // directory entries indexed per timer tick
+#define PREFETCH_SCAN 16      // entries examined per tick for prefetch
+
+struct FileRow {
+    lv_obj_t *obj;
+    lv_obj_t *icon;
+    lv_obj_t *thumb;
+    lv_obj_t *name;
+    lv_obj_t *info;
+    int index;                // entry shown, -1 when unused
+    volatile uint32_t gen;    // bumped on every rebind: drops late thumbnails
+    lv_color_t *px;           // THUMB_W x THUMB_H, PSRAM
+    lv_img_dsc_t dsc;
+};
+
+static FileRow rows[ROW_POOL];
+static DirPager pager;
+static ThumbCache thumbs;
+static bool dirOpen = false;
+static int prefetchNext = 0;
+
+static void buildPath(char *out, size_t len, const char *name)
+{
+    snprintf(out, len, "%s%s%s", currentPath.c_str(), currentPath.endsWith("/") ? "" : "/", name);
+}
+
+// Row click: the pager still holds the entry, look it up by index
+static void row_click_cb(lv_event_t *e)
+{
+    FileRow &r = rows[(intptr_t)lv_event_get_user_data(e)];
+    const DirEntry *d = pager.entry(r.index);
+    if (!d) return;
+
+    if (d->isDir) {
+        char name[DIR_NAME_MAX];
+        strlcpy(name, d->name, sizeof(name));   // the pager is reopened below
+        navigateTo(name);
+    } else if (isImageFile(d->name)) {
+        viewerOpen(r.index);
+    }
+}
+
+// Called from the thumbnail task
+static bool thumbIsCurrent(uint8_t slot, uint32_t gen)
+{
+    return rows[slot].gen == gen;
+}
+
+static void thumbDeliver(uint8_t slot, uint32_t gen, const uint16_t *px)
+{
+    bsp_display_lock(0);
+    FileRow &r = rows[slot];
+    if (r.gen == gen && r.px) {
+        memcpy(r.px, px, THUMB_W * THUMB_H * sizeof(uint16_t));
+        lv_img_cache_invalidate_src(&r.dsc);
+        lv_obj_invalidate(r.thumb);
+    }
+    bsp_display_unlock();
+}
+
+static void createRows()
+{
+    for (int i = 0; i < ROW_POOL; i++) {
+        FileRow &r = rows[i];
+        r.index = -1;
+        r.gen = 0;
+
+        r.obj = lv_obj_create(file_view);
+        lv_obj_set_size(r.obj, 440, ROW_H - 4);
+        lv_obj_set_x(r.obj, 10);
+        lv_obj_set_style_bg_color(r.obj, lv_color_hex(COLOR_CARD), 0);
+        lv_obj_set_style_border_width(r.obj, 0, 0);
+        lv_obj_set_style_radius(r.obj, 6, 0);
+        lv_obj_set_style_pad_all(r.obj, 0, 0);
+        lv_obj_clear_flag(r.obj, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_add_flag(r.obj, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_add_event_cb(r.obj, row_click_cb, LV_EVENT_CLICKED, (void *)(intptr_t)i);
+
+        r.icon = lv_label_create(r.obj);
+        lv_obj_align(r.icon, LV_ALIGN_LEFT_MID, 16, 0);
+
+        r.px = (lv_color_t *)heap_caps_calloc(THUMB_W * THUMB_H, sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+        r.dsc.header.always_zero = 0;
+        r.dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+        r.dsc.header.w = THUMB_W;
+        r.dsc.header.h = THUMB_H;
+        r.dsc.data_size = THUMB_W * THUMB_H * sizeof(lv_color_t);
+        r.dsc.data = (const uint8_t *)r.px;
+        r.thumb = lv_img_create(r.obj);
+        if (r.px) lv_img_set_src(r.thumb, &r.dsc);
+        lv_obj_align(r.thumb, LV_ALIGN_LEFT_MID, 2, 0);
+
+        r.name = lv_label_create(r.obj);
+        lv_label_set_long_mode(r.name, LV_LABEL_LONG_DOT);
+        lv_obj_set_width(r.name, 280);
+        lv_obj_set_style_text_color(r.name, lv_color_hex(COLOR_TEXT), 0);
+        lv_obj_align(r.name, LV_ALIGN_LEFT_MID, 60, 0);
+
+        r.info = lv_label_create(r.obj);
+        lv_obj_set_style_text_color(r.info, lv_color_hex(COLOR_DIMMED), 0);
+        lv_obj_align(r.info, LV_ALIGN_RIGHT_MID, -10, 0);
+    }
+}
+
+static void bindRow(int slot, int index)
+{
+    FileRow &r = rows[slot];
+    const DirEntry *d = pager.entry(index);
+    r.gen++;
+    r.index = d ? index : -1;
+    if (!d) {
+        lv_obj_add_flag(r.obj, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+    lv_obj_clear_flag(r.obj, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_set_y(r.obj, index * ROW_H);
+    lv_label_set_text(r.name, d->name);
+
+    bool image = !d->isDir && isImageFile(d->name) && r.px;
+    if (image) {
+        // Black until the thumbnail task delivers
+        memset(r.px, 0, THUMB_W * THUMB_H * sizeof(lv_color_t));
+        lv_img_cache_invalidate_src(&r.dsc);
+        lv_obj_clear_flag(r.thumb, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_add_flag(r.icon, LV_OBJ_FLAG_HIDDEN);
+        char path[192];
+        buildPath(path, sizeof(path), d->name);
+        thumbs.request(path, d->size, slot, r.gen);
+    } else {
+        lv_obj_add_flag(r.thumb, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_clear_flag(r.icon, LV_OBJ_FLAG_HIDDEN);
+        lv_label_set_text(r.icon, d->isDir ? LV_SYMBOL_DIRECTORY : LV_SYMBOL_FILE);
+        lv_obj_set_style_text_color(r.icon, lv_color_hex(d->isDir ? COLOR_FOLDER : COLOR_FILE), 0);
+    }
+    lv_label_set_text(r.info, d->isDir ? "" : formatSize(d->size).c_str());
+}
+
+// Bind the rows covering the visible window; only rows whose entry
+// changed are touched
+static void refreshRows()
+{
+    int first = lv_obj_get_scroll_y(file_view) / ROW_H;
+    if (first < 0) first = 0;
+    for (int i = first; i < first + ROW_POOL; i++) {
+        int slot = i % ROW_POOL;
+        int want = i < pager.count() ? i : -1;
+        if (rows[slot].index != want) bindRow(slot, want);
+    }
+}
+
+static void file_view_scroll_cb(lv_event_t *e)
+{
+    refreshRows();
+}
+
+static void updateTitle()
+{
+    char titleBuf[32];
+    int count = pager.count();
+    snprintf(titleBuf, sizeof(titleBuf), "%d element%s%s", count, count > 1 ? "s" : "",
+             pager.complete() ? "" : "...");
+    lv_label_set_text(label_title, titleBuf);
+}
+
+// LVGL timer: index the directory a slice at a time, then feed the
+// thumbnail task with the images not yet on screen
+static void dir_timer_cb(lv_timer_t *t)
+{
+    if (!dirOpen || showingInfo || showingImage) return;
+
+    if (!pager.complete()) {
+        int before = pager.count();
+        pager.indexStep(INDEX_BUDGET);
+        if (pager.count() != before) {
+            lv_obj_set_height(file_spacer, pager.count() * ROW_H);
+            refreshRows();
+        }
+        updateTitle();
+        return;
+    }
+
+    if (!thumbs.idle()) return;
+    for (int n = 0; n < PREFETCH_SCAN && prefetchNext < pager.count(); n++) {
+        const DirEntry *d = pager.entry(prefetchNext++);
+        if (d && !d->isDir && isImageFile(d->name)) {
+            char path[192];
+            buildPath(path, sizeof(path), d->name);
+            thumbs.request(path, d->size, THUMB_NO_SLOT, 0);
+            break;
+        }
+    }
+}
+
+// Show a message in place of the listing
+static void showListMessage(const char *text)
+{
+    lv_obj_add_flag(file_view, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_clear_flag(list_files, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_clean(list_files);
+    lv_obj_t *btn = lv_list_add_btn(list_files, LV_SYMBOL_WARNING, text);
+    lv_obj_set_style_text_color(lv_obj_get_child(btn, 0), lv_color_hex(COLOR_ERROR), 0);
+}
+
+// Update file list: only opens the directory, dir_timer_cb does the rest
 static void updateFileList()
 {
     bsp_display_lock(0);
@@ -361,92 +586,430 @@ static void updateFileList()
     // Update path label
     lv_label_set_text(label_path, currentPath.c_str());
 
-    // Clear list
-    lv_obj_clean(list_files);
+    dirOpen = false;
+    pager.close();
+    for (int i = 0; i < ROW_POOL; i++) bindRow(i, -1);
 
     if (!sdCardOk) {
-        lv_obj_t *btn = lv_list_add_btn(list_files, LV_SYMBOL_WARNING, "Carte SD non detectee");
-        lv_obj_set_style_text_color(lv_obj_get_child(btn, 0), lv_color_hex(COLOR_ERROR), 0);
+        showListMessage("Carte SD non detectee");
         bsp_display_unlock();
         return;
     }
 
-    File root = SD_MMC.open(currentPath);
-    if (!root || !root.isDirectory()) {
-        lv_obj_t *btn = lv_list_add_btn(list_files, LV_SYMBOL_WARNING, "Erreur ouverture dossier");
+    if (!pager.open(currentPath.c_str())) {
+        showListMessage("Erreur ouverture dossier");
         bsp_display_unlock();
         return;
     }
+    dirOpen = true;
+    prefetchNext = 0;
 
-    int count = 0;
-    File entry = root.openNextFile();
+    lv_obj_add_flag(list_files, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_clear_flag(file_view, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_set_height(file_spacer, 0);
+    lv_obj_scroll_to_y(file_view, 0, LV_ANIM_OFF);
 
-    while (entry && count < 50) {
-        const char* name = entry.name();
-        bool isDir = entry.isDirectory();
-        size_t size = entry.size();
+    // First screenful right away
+    pager.indexStep(INDEX_BUDGET);
+    lv_obj_set_height(file_spacer, pager.count() * ROW_H);
+    refreshRows();
+    updateTitle();
 
-        // Skip hidden files
-        if (name[0] != '.') {
-            // Build display text
-            char displayText[80];
-            if (isDir) {
-                snprintf(displayText, sizeof(displayText), "%s/", name);
-            } else {
-                snprintf(displayText, sizeof(displayText), "%s  (%s)", name, formatSize(size).c_str());
-            }
+    bsp_display_unlock();
+}
 
-            // Add to list
-            const char* icon = isDir ? LV_SYMBOL_DIRECTORY : LV_SYMBOL_FILE;
-            lv_obj_t *btn = lv_list_add_btn(list_files, icon, displayText);
-            lv_obj_set_style_bg_color(btn, lv_color_hex(COLOR_CARD), 0);
+// Image viewer: two PSRAM canvases (allocated once, 2 x 300 KB). The
+// shown one is never written; the other receives the image asked for, or
+// the next one in the folder ahead of time, so moving forward is a buffer
+// swap. Decoding runs on its own task; the LVGL task only swaps buffers.
+#define VIEW_SLOTS    2
+#define SLIDESHOW_MS  4000
+
+enum SlotState : uint8_t { SLOT_EMPTY, SLOT_DECODING, SLOT_READY, SLOT_FAILED };
+
+struct ViewSlot {
+    lv_color_t *buf;
+    int index;                  // directory entry held, -1 if none
+    volatile SlotState state;
+};
+
+struct DecodeRequest {
+    char path[192];
+    uint8_t slot;
+    int index;
+    uint32_t gen;
+};
+
+static ViewSlot viewSlots[VIEW_SLOTS];
+static int shownSlot = -1;
+static int wantedIndex = -1;    // entry to show as soon as it is decoded
+static QueueHandle_t decodeQueue = nullptr;
+static SemaphoreHandle_t decodeBusy = nullptr;   // held while a file is open
+static lv_obj_t *img_caption = nullptr;
+static lv_obj_t *img_status = nullptr;
+static lv_obj_t *img_play = nullptr;
+static lv_timer_t *slideshowTimer = nullptr;
+
+// Next image entry from 'from' in direction 'dir', -1 if none
+static int nextImage(int from, int dir)
+{
+    for (int i = from + dir; i >= 0 && i < pager.count(); i += dir) {
+        const DirEntry *d = pager.entry(i);
+        if (d && !d->isDir && isImageFile(d->name)) return i;
+    }
+    return -1;
+}
 
-            // Color icon (child 0) and text (child 1)
-            lv_obj_t *img = lv_obj_get_child(btn, 0);
-            lv_obj_t *lbl = lv_obj_get_child(btn, 1);
-            if (img) {
-                lv_obj_set_style_text_color(img, lv_color_hex(isDir ? COLOR_FOLDER : COLOR_FILE), 0);
-            }
-            if (lbl) {
-                lv_obj_set_style_text_color(lbl, lv_color_hex(COLOR_TEXT), 0);
-            }
+// Queue a decode of 'index' into 'slot'. The queue holds one request:
+// a newer one replaces a pending one, and the running decode is cancelled.
+static void viewerRequest(int slot, int index)
+{
+    const DirEntry *d = pager.entry(index);
+    if (!d) return;
+    DecodeRequest rq;
+    buildPath(rq.path, sizeof(rq.path), d->name);
+    rq.slot = slot;
+    rq.index = index;
+    rq.gen = ++decodeGen;
+    viewSlots[slot].index = index;
+    viewSlots[slot].state = SLOT_DECODING;
+    xQueueOverwrite(decodeQueue, &rq);
+}
 
-            // Add click handler for directories and images
-            if (isDir) {
-                // Store name in button's user data
-                static char storedNames[50][64];
-                strncpy(storedNames[count], name, 63);
-                storedNames[count][63] = '\0';
-                lv_obj_add_event_cb(btn, file_click_cb, LV_EVENT_CLICKED, storedNames[count]);
-            } else if (isImageFile(name)) {
-                // Store full path for images
-                static char storedPaths[50][128];
-                String fullPath = currentPath;
-                if (!fullPath.endsWith("/")) fullPath += "/";
-                fullPath += name;
-                strncpy(storedPaths[count], fullPath.c_str(), 127);
-                storedPaths[count][127] = '\0';
-                lv_obj_add_event_cb(btn, image_click_cb, LV_EVENT_CLICKED, storedPaths[count]);
-                // Highlight images
-                lv_obj_set_style_text_color(img, lv_color_hex(COLOR_ACCENT), 0);
-            }
+// Display lock held
+static void viewerShow(int slot)
+{
+    ViewSlot &v = viewSlots[slot];
+    shownSlot = slot;
+    lv_canvas_set_buffer(img_canvas, v.buf, canvas_width, canvas_height, LV_IMG_CF_TRUE_COLOR);
+    lv_obj_invalidate(img_canvas);
+
+    const DirEntry *d = pager.entry(v.index);
+    lv_label_set_text(img_caption, d ? d->name : "");
+    lv_obj_add_flag(img_status, LV_OBJ_FLAG_HIDDEN);
+
+    // Decode ahead into the other slot
+    int other = 1 - slot;
+    int next = nextImage(v.index, 1);
+    if (next >= 0 && viewSlots[other].index != next) viewerRequest(other, next);
+}
 
-            count++;
+// Display lock held
+static void viewerGo(int dir)
+{
+    int index = nextImage(wantedIndex, dir);
+    if (index < 0) return;
+    wantedIndex = index;
+
+    for (int i = 0; i < VIEW_SLOTS; i++) {
+        if (viewSlots[i].index != index) continue;
+        if (viewSlots[i].state == SLOT_READY) {
+            viewerShow(i);
+            return;
+        }
+        if (viewSlots[i].state == SLOT_DECODING) {
+            lv_label_set_text(img_status, "Chargement...");
+            lv_obj_clear_flag(img_status, LV_OBJ_FLAG_HIDDEN);
+            return;
         }
+    }
+
+    // Not cached: decode into the slot not on screen, dropping its content
+    viewerRequest(shownSlot < 0 ? 0 : 1 - shownSlot, index);
+    lv_label_set_text(img_status, "Chargement...");
+    lv_obj_clear_flag(img_status, LV_OBJ_FLAG_HIDDEN);
+}
 
-        entry.close();
-        entry = root.openNextFile();
+static void decodeTask(void *arg)
+{
+    DecodeRequest rq;
+    for (;;) {
+        if (xQueueReceive(decodeQueue, &rq, portMAX_DELAY) != pdTRUE) continue;
+        if (rq.gen != decodeGen) continue;   // superseded while queued
+
+        xSemaphoreTake(decodeBusy, portMAX_DELAY);
+        bool ok = decodeImage(rq.path, viewSlots[rq.slot].buf, rq.gen);
+        xSemaphoreGive(decodeBusy);
+
+        bsp_display_lock(0);
+        ViewSlot &v = viewSlots[rq.slot];
+        if (rq.gen == decodeGen && v.index == rq.index) {
+            v.state = ok ? SLOT_READY : SLOT_FAILED;
+            if (showingImage && rq.index == wantedIndex) {
+                if (ok) {
+                    viewerShow(rq.slot);
+                } else {
+                    lv_label_set_text(img_status, "Image illisible");
+                    lv_obj_clear_flag(img_status, LV_OBJ_FLAG_HIDDEN);
+                }
+            }
+        }
+        bsp_display_unlock();
     }
-    root.close();
+}
 
-    // Update title
-    char titleBuf[32];
-    snprintf(titleBuf, sizeof(titleBuf), "%d element%s", count, count > 1 ? "s" : "");
-    lv_label_set_text(label_title, titleBuf);
+static bool viewerInit()
+{
+    if (decodeQueue) return true;
+    for (int i = 0; i < VIEW_SLOTS; i++) {
+        viewSlots[i].buf = (lv_color_t *)heap_caps_malloc(CANVAS_W * CANVAS_H * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+        viewSlots[i].index = -1;
+        viewSlots[i].state = SLOT_EMPTY;
+        if (!viewSlots[i].buf) return false;
+    }
+    decodeQueue = xQueueCreate(1, sizeof(DecodeRequest));
+    decodeBusy = xSemaphoreCreateMutex();
+    if (!decodeQueue || !decodeBusy) return false;
+    return xTaskCreate(decodeTask, "decode", 6144, NULL, 3, NULL) == pdPASS;
+}
+
+// Close the image overlay
+static void viewerClose()
+{
+    if (img_overlay) {
+        lv_obj_del(img_overlay);
+        img_overlay = nullptr;
+        img_view = nullptr;
+        img_canvas = nullptr;
+        showingImage = false;
+        lv_timer_pause(slideshowTimer);
+
+        // Stop decoding; the canvases stay allocated for the next opening
+        decodeGen++;
+        for (int i = 0; i < VIEW_SLOTS; i++) viewSlots[i].index = -1;
+        shownSlot = -1;
+        wantedIndex = -1;
+    }
+}
+
+// Overlay: swipe left/right for next/previous, tap to close. A swipe
+// still ends with CLICKED, hence the flag.
+static void viewer_event_cb(lv_event_t *e)
+{
+    static bool swiped = false;
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_PRESSED) {
+        swiped = false;
+    } else if (code == LV_EVENT_GESTURE) {
+        lv_dir_t dir = lv_indev_get_gesture_dir(lv_indev_get_act());
+        if (dir == LV_DIR_LEFT) viewerGo(1);
+        else if (dir == LV_DIR_RIGHT) viewerGo(-1);
+        swiped = true;
+    } else if (code == LV_EVENT_CLICKED && !swiped) {
+        viewerClose();
+    }
+}
+
+static void slideshow_timer_cb(lv_timer_t *t)
+{
+    if (showingImage) viewerGo(1);
+}
+
+static void play_click_cb(lv_event_t *e)
+{
+    bool playing = lv_obj_has_state(img_play, LV_STATE_CHECKED);
+    lv_label_set_text(lv_obj_get_child(img_play, 0), playing ? LV_SYMBOL_PAUSE : LV_SYMBOL_PLAY);
+    if (playing) {
+        lv_timer_reset(slideshowTimer);
+        lv_timer_resume(slideshowTimer);
+    } else {
+        lv_timer_pause(slideshowTimer);
+    }
+}
+
+// Fullscreen viewer on directory entry 'index'
+static void viewerOpen(int index)
+{
+    if (!viewerInit()) {
+        Serial.println("Failed to start image viewer");
+        return;
+    }
+    if (!slideshowTimer) {
+        slideshowTimer = lv_timer_create(slideshow_timer_cb, SLIDESHOW_MS, NULL);
+        lv_timer_pause(slideshowTimer);
+    }
 
+    // Create fullscreen overlay
+    img_overlay = lv_obj_create(lv_scr_act());
+    lv_obj_remove_style_all(img_overlay);
+    lv_obj_set_size(img_overlay, 480, 320);
+    lv_obj_align(img_overlay, LV_ALIGN_CENTER, 0, 0);
+    lv_obj_set_style_bg_color(img_overlay, lv_color_hex(0x000000), 0);
+    lv_obj_set_style_bg_opa(img_overlay, LV_OPA_COVER, 0);
+    lv_obj_clear_flag(img_overlay, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_event_cb(img_overlay, viewer_event_cb, LV_EVENT_ALL, NULL);
+
+    // Canvas, its buffer is set when an image is ready
+    img_canvas = lv_canvas_create(img_overlay);
+    lv_obj_center(img_canvas);
+
+    img_caption = lv_label_create(img_overlay);
+    lv_label_set_long_mode(img_caption, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(img_caption, 400);
+    lv_label_set_text(img_caption, "");
+    lv_obj_set_style_text_color(img_caption, lv_color_hex(0x888888), 0);
+    lv_obj_align(img_caption, LV_ALIGN_TOP_MID, 0, 6);
+
+    img_status = lv_label_create(img_overlay);
+    lv_label_set_text(img_status, "Chargement...");
+    lv_obj_set_style_text_color(img_status, lv_color_hex(COLOR_TEXT), 0);
+    lv_obj_center(img_status);
+
+    // Add hint label
+    lv_obj_t *hint = lv_label_create(img_overlay);
+    lv_label_set_text(hint, "Glisser: image suivante - Tap pour fermer");
+    lv_obj_set_style_text_color(hint, lv_color_hex(0x888888), 0);
+    lv_obj_align(hint, LV_ALIGN_BOTTOM_MID, 0, -10);
+
+    // Slideshow toggle
+    img_play = lv_btn_create(img_overlay);
+    lv_obj_set_size(img_play, 45, 35);
+    lv_obj_align(img_play, LV_ALIGN_BOTTOM_RIGHT, -5, -5);
+    lv_obj_add_flag(img_play, LV_OBJ_FLAG_CHECKABLE);
+    lv_obj_set_style_bg_color(img_play, lv_color_hex(0x444444), 0);
+    lv_obj_add_event_cb(img_play, play_click_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    lv_obj_t *pl = lv_label_create(img_play);
+    lv_label_set_text(pl, LV_SYMBOL_PLAY);
+    lv_obj_center(pl);
+
+    showingImage = true;
+    wantedIndex = index;
+    viewerRequest(0, index);
+}
+
+// SD benchmark: every bus width / clock / read size combination, one CSV
+// line each on Serial (header "sdbench,..."), then the chosen configuration
+// is mounted and saved for the next boots
+static const uint8_t benchWidths[] = {
+    1,
+#ifdef SD_MMC_D3
+    4,
+#endif
+};
+static const uint16_t benchFreqs[] = {SDMMC_FREQ_DEFAULT, SDMMC_FREQ_26M, SDMMC_FREQ_HIGHSPEED};
+static const uint32_t benchBufs[] = {4096, 8192, 16384, 32768};
+#define BENCH_RUNS (sizeof(benchWidths) * (sizeof(benchFreqs) / sizeof(benchFreqs[0])) * \
+                    (sizeof(benchBufs) / sizeof(benchBufs[0])))
+
+static void benchAddRow(const char *icon, const char *text, uint32_t color)
+{
+    bsp_display_lock(0);
+    lv_obj_t *btn = lv_list_add_btn(list_files, icon, text);
+    lv_obj_set_style_text_color(btn, lv_color_hex(color), 0);
+    lv_obj_scroll_to_view(btn, LV_ANIM_OFF);
     bsp_display_unlock();
 }
 
+static void benchTask(void *arg)
+{
+    static SdConfig cfgs[BENCH_RUNS];
+    static SdBenchResult results[BENCH_RUNS];
+    int runs = 0;
+    char line[96];
+    const char *card = getCardTypeString(SD_MMC.cardType());
+    uint32_t sizeMb = SD_MMC.cardSize() / (1024 * 1024);
+    SdConfig previous = sdConfig;
+
+    uint8_t *buf = (uint8_t *)heap_caps_malloc(SD_BENCH_MAX_BUF, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!buf) buf = (uint8_t *)heap_caps_malloc(SD_BENCH_MAX_BUF, MALLOC_CAP_SPIRAM);
+
+    thumbs.pause();
+    if (decodeBusy) xSemaphoreTake(decodeBusy, portMAX_DELAY);
+    bool prepared = buf && sdBenchPrepare(SD_MMC, buf, SD_BENCH_MAX_BUF);
+    if (!prepared) benchAddRow(LV_SYMBOL_WARNING, "Fichiers de test impossibles", COLOR_ERROR);
+
+    Serial.println("sdbench,card,size_mb,width,freq_khz,buf,seq_kbs,rand_kbs,rand_iops,dir_eps,status");
+    for (size_t w = 0; prepared && w < sizeof(benchWidths); w++) {
+        for (uint16_t freq : benchFreqs) {
+            SdConfig cfg = {benchWidths[w], freq, 0};
+            SD_MMC.end();
+            if (!setSdPins(cfg.width) || !sdMount(cfg)) {
+                Serial.printf("sdbench,%s,%lu,%u,%u,0,0,0,0,0,mount_failed\n", card, (unsigned long)sizeMb,
+                              cfg.width, cfg.freqKhz);
+                snprintf(line, sizeof(line), "%u bit %u MHz: montage impossible", cfg.width, cfg.freqKhz / 1000);
+                benchAddRow(LV_SYMBOL_CLOSE, line, COLOR_ERROR);
+                continue;
+            }
+            uint32_t dirEps = sdBenchDir();
+            for (uint32_t len : benchBufs) {
+                SdBenchResult r = {};
+                r.dirEps = dirEps;
+                cfg.buf = len;
+                bool ok = sdBenchRead(SD_MMC, buf, len, r);
+                Serial.printf("sdbench,%s,%lu,%u,%u,%lu,%lu,%lu,%lu,%lu,%s\n", card, (unsigned long)sizeMb,
+                              cfg.width, cfg.freqKhz, (unsigned long)len, (unsigned long)r.seqKBs,
+                              (unsigned long)r.randKBs, (unsigned long)r.randIops, (unsigned long)r.dirEps,
+                              ok ? "ok" : "read_failed");
+                snprintf(line, sizeof(line), "%u bit %u MHz %2lu KB: %lu KB/s, %lu IOPS, %lu ent/s",
+                         cfg.width, cfg.freqKhz / 1000, (unsigned long)(len / 1024), (unsigned long)r.seqKBs,
+                         (unsigned long)r.randIops, (unsigned long)r.dirEps);
+                benchAddRow(ok ? LV_SYMBOL_RIGHT : LV_SYMBOL_WARNING, line, ok ? COLOR_TEXT : COLOR_ERROR);
+                if (ok) {
+                    cfgs[runs] = cfg;
+                    results[runs++] = r;
+                }
+            }
+        }
+    }
+
+    // Runs are ordered narrowest bus, lowest clock, smallest read first: keep
+    // the first one within 5% of the fastest sequential rate, cheaper on
+    // RAM and margins for no visible difference
+    uint32_t fastest = 0;
+    for (int i = 0; i < runs; i++) fastest = max(fastest, results[i].seqKBs);
+    int best = -1;
+    for (int i = 0; i < runs && best < 0; i++) {
+        if (results[i].seqKBs * 100 >= fastest * 95) best = i;
+    }
+
+    SD_MMC.end();
+    sdConfig = best >= 0 ? cfgs[best] : previous;
+    bool mounted = setSdPins(sdConfig.width) && sdMount(sdConfig);
+    if (!mounted && best >= 0) {
+        sdConfig = previous;
+        mounted = setSdPins(sdConfig.width) && sdMount(sdConfig);
+    }
+    if (mounted && best >= 0) {
+        saveSdConfig();
+        Serial.printf("sdbench_best,%s,%lu,%u,%u,%lu,%lu\n", card, (unsigned long)sizeMb, sdConfig.width,
+                      sdConfig.freqKhz, (unsigned long)sdConfig.buf, (unsigned long)results[best].seqKBs);
+        snprintf(line, sizeof(line), "Retenu: %u bit %u MHz, lectures %lu KB (enregistre)",
+                 sdConfig.width, sdConfig.freqKhz / 1000, (unsigned long)(sdConfig.buf / 1024));
+        benchAddRow(LV_SYMBOL_OK, line, COLOR_ACCENT);
+    } else if (!mounted) {
+        sdCardOk = false;
+        benchAddRow(LV_SYMBOL_WARNING, "Carte SD non remontee", COLOR_ERROR);
+    }
+    if (decodeBusy) xSemaphoreGive(decodeBusy);
+    thumbs.resume();
+
+    heap_caps_free(buf);
+    benchRunning = false;
+    vTaskDelete(NULL);
+}
+
+static void bench_start_cb(lv_event_t *e)
+{
+    if (benchRunning || !sdCardOk) return;
+
+    // Nothing may hold the card while it is remounted: directory closed
+    // here, thumbnails paused by the task
+    dirOpen = false;
+    pager.close();
+    for (int i = 0; i < ROW_POOL; i++) bindRow(i, -1);
+
+    lv_label_set_text(label_title, LV_SYMBOL_SD_CARD " Benchmark SD");
+    lv_label_set_text(label_path, "Resultats aussi sur le port serie (CSV)");
+    lv_obj_clean(list_files);
+    benchRunning = true;
+    if (xTaskCreate(benchTask, "sd_bench", 6144, NULL, 3, NULL) != pdPASS) {
+        benchRunning = false;
+        lv_list_add_btn(list_files, LV_SYMBOL_WARNING, "Tache benchmark impossible");
+        return;
+    }
+    lv_list_add_btn(list_files, LV_SYMBOL_REFRESH, "Mesures en cours...");
+}
+
 // Show SD info
 static void showSDInfo()
 {
@@ -454,6 +1017,8 @@ static void showSDInfo()
 
     lv_label_set_text(label_title, LV_SYMBOL_SD_CARD " Infos SD");
     lv_label_set_text(label_path, "Informations techniques");
+    lv_obj_add_flag(file_view, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_clear_flag(list_files, LV_OBJ_FLAG_HIDDEN);
     lv_obj_clean(list_files);
 
     if (!sdCardOk) {
@@ -482,6 +1047,14 @@ static void showSDInfo()
 
         snprintf(buf, sizeof(buf), "Libre: %s", formatSize(totalBytes - usedBytes).c_str());
         lv_list_add_btn(list_files, LV_SYMBOL_OK, buf);
+
+        snprintf(buf, sizeof(buf), "Bus: %u bit, %u MHz, lectures %lu KB", sdConfig.width,
+                 sdConfig.freqKhz / 1000, (unsigned long)(sdConfig.buf / 1024));
+        lv_list_add_btn(list_files, LV_SYMBOL_SETTINGS, buf);
+
+        lv_obj_t *bench = lv_list_add_btn(list_files, LV_SYMBOL_PLAY, "Lancer le benchmark");
+        lv_obj_set_style_text_color(bench, lv_color_hex(COLOR_ACCENT), 0);
+        lv_obj_add_event_cb(bench, bench_start_cb, LV_EVENT_CLICKED, NULL);
     }
 
     bsp_display_unlock();
@@ -578,6 +1151,26 @@ void setup()
     lv_obj_set_style_border_width(list_files, 0, 0);
     lv_obj_set_style_text_color(list_files, lv_color_hex(COLOR_TEXT), 0);
 
+    // Virtualized file view, same area as the list
+    file_view = lv_obj_create(lv_scr_act());
+    lv_obj_set_size(file_view, 460, 230);
+    lv_obj_align(file_view, LV_ALIGN_BOTTOM_MID, 0, -5);
+    lv_obj_set_style_bg_color(file_view, lv_color_hex(COLOR_BG), 0);
+    lv_obj_set_style_border_width(file_view, 0, 0);
+    lv_obj_set_style_pad_all(file_view, 0, 0);
+    lv_obj_set_style_text_color(file_view, lv_color_hex(COLOR_TEXT), 0);
+    lv_obj_set_scroll_dir(file_view, LV_DIR_VER);
+    lv_obj_add_event_cb(file_view, file_view_scroll_cb, LV_EVENT_SCROLL, NULL);
+    lv_obj_add_flag(file_view, LV_OBJ_FLAG_HIDDEN);
+
+    file_spacer = lv_obj_create(file_view);
+    lv_obj_remove_style_all(file_spacer);
+    lv_obj_set_size(file_spacer, 1, 0);
+    lv_obj_clear_flag(file_spacer, LV_OBJ_FLAG_CLICKABLE);
+
+    createRows();
+    lv_timer_create(dir_timer_cb, 20, NULL);
+
     bsp_display_unlock();
     Serial.println("UI created");
 
@@ -585,6 +1178,10 @@ void setup()
     delay(100);
     sdCardOk = initSDCard();
     Serial.printf("SD init: %s\n", sdCardOk ? "OK" : "FAILED");
+    sdStream.attach(SD_MMC);
+    if (sdCardOk && !thumbs.begin(SD_MMC, thumbIsCurrent, thumbDeliver)) {
+        Serial.println("Thumbnail task not started");
+    }
 
     // Show content
     if (sdCardOk) {
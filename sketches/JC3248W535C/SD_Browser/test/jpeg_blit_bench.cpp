@@ -0,0 +1,210 @@
+/*
+ * jpeg_blit_bench.cpp - Banc PC du rappel de dessin 1:1 (jpeg_blit.h)
+ *
+ * Compare jpegBlitClipped() (recadrage une fois par bloc, memcpy par
+ * ligne, pixels deja dans l'ordre du canevas) a l'ancien rappel de
+ * main.cpp (test de bornes et lv_color_make() par pixel, JPEGDEC en
+ * RGB565 petit-boutiste) :
+ *   - justesse : blocs a cheval sur chaque bord et chaque coin du
+ *     rectangle de l'image, hors du rectangle, coordonnees negatives,
+ *     rectangle colle au bord du canevas, compares pixel a pixel a une
+ *     copie par pixel de reference, avec zones de garde ;
+ *   - canevas identique a l'ancien rappel quand l'image couvre l'ecran ;
+ *   - temps par image 480x320 pour des blocs JPEGDEC de 256x16 (4:2:0),
+ *     image plein ecran et image 300x200 centree avec bourrage de MCU.
+ *
+ *   g++ -std=c++11 -O2 -Wall -I../include -I../../../common jpeg_blit_bench.cpp -o /tmp/jpeg_blit_bench && /tmp/jpeg_blit_bench
+ */
+
+#include <chrono>
+#include <vector>
+#include "host_test.h"
+#include "jpeg_blit.h"
+
+#define CANVAS_W 480               // comme dans main.cpp
+#define CANVAS_H 320
+#define GUARD    2048
+#define FRAMES   2000
+
+static uint32_t rngState = 99;
+static uint32_t rnd() {
+  rngState = rngState * 1103515245u + 12345u;
+  return rngState >> 8;
+}
+
+static uint16_t swap16(uint16_t v) { return (v >> 8) | (v << 8); }
+
+// lv_color_make() avec LV_COLOR_16_SWAP = 1 (lv_conf.h) : RGB565 gros-boutiste
+static uint16_t lvColorMake(uint8_t r, uint8_t g, uint8_t b) {
+  uint16_t v = (uint16_t)((r >> 3) << 11 | (g >> 2) << 5 | (b >> 3));
+  return swap16(v);
+}
+
+// Ancien rappel (avant le passage en RGB565_BIG_ENDIAN), a l'identique :
+// bornes du canevas testees et couleur convertie a chaque pixel
+static void blitPerPixelOld(const uint16_t* px, int bw, int bh, int bx, int by, uint16_t* canvas,
+                            int offX, int offY) {
+  for (int y = 0; y < bh; y++) {
+    int destY = by + y + offY;
+    if (destY < 0 || destY >= CANVAS_H) continue;
+    for (int x = 0; x < bw; x++) {
+      int destX = bx + x + offX;
+      if (destX < 0 || destX >= CANVAS_W) continue;
+      uint16_t pixel = px[y * bw + x];
+      canvas[destY * CANVAS_W + destX] = lvColorMake((pixel >> 8) & 0xF8, (pixel >> 3) & 0xFC, (pixel << 3) & 0xF8);
+    }
+  }
+}
+
+// Reference de justesse : un test par pixel contre le rectangle de l'image
+static int blitReference(const uint16_t* px, int bw, int bh, int x, int y, uint16_t* canvas,
+                         int cx0, int cy0, int cx1, int cy1) {
+  int n = 0;
+  for (int r = 0; r < bh; r++) {
+    for (int c = 0; c < bw; c++) {
+      int dx = x + c, dy = y + r;
+      if (dx < cx0 || dx >= cx1 || dy < cy0 || dy >= cy1) continue;
+      canvas[dy * CANVAS_W + dx] = px[r * bw + c];
+      n++;
+    }
+  }
+  return n;
+}
+
+static void testClippedEdges() {
+  std::vector<uint16_t> a(CANVAS_W * CANVAS_H + 2 * GUARD), b(a.size());
+  std::vector<uint16_t> block(256 * 16);
+  for (uint16_t& v : block) v = (uint16_t)rnd();
+
+  // Rectangles : centre, colle a gauche/en haut, colle a droite/en bas,
+  // tout le canevas, une seule colonne
+  const int rects[][4] = {{90, 60, 390, 260}, {0, 0, 300, 200}, {180, 120, 480, 320},
+                          {0, 0, 480, 320}, {240, 0, 241, 320}};
+  const int sizes[][2] = {{256, 16}, {16, 16}, {8, 8}, {1, 1}, {2, 2}, {33, 7}};
+  int cases = 0, partial = 0;
+  for (const int* r : rects) {
+    for (const int* s : sizes) {
+      int bw = s[0], bh = s[1];
+      // Positions autour de chaque bord et coin, dedans, dehors, negatives
+      const int xs[] = {r[0] - bw - 1, r[0] - bw, r[0] - bw + 1, r[0] - 1, r[0], r[0] + 1,
+                        (r[0] + r[2]) / 2, r[2] - bw - 1, r[2] - bw, r[2] - bw + 1, r[2] - 1, r[2], -bw / 2 - 3};
+      const int ys[] = {r[1] - bh - 1, r[1] - bh, r[1] - bh + 1, r[1] - 1, r[1], r[1] + 1,
+                        (r[1] + r[3]) / 2, r[3] - bh - 1, r[3] - bh, r[3] - bh + 1, r[3] - 1, r[3], -bh / 2 - 3};
+      for (int x : xs) {
+        for (int y : ys) {
+          uint16_t fill = (uint16_t)rnd();
+          a.assign(a.size(), fill);
+          b.assign(b.size(), fill);
+          int got = jpegBlitClipped(block.data(), bw, bh, x, y, a.data() + GUARD, CANVAS_W, r[0], r[1], r[2], r[3]);
+          int exp = blitReference(block.data(), bw, bh, x, y, b.data() + GUARD, r[0], r[1], r[2], r[3]);
+          CHECK(got == exp, "bloc %dx%d en (%d, %d), rect %d,%d-%d,%d : %d pixels au lieu de %d",
+                bw, bh, x, y, r[0], r[1], r[2], r[3], got, exp);
+          CHECK(a == b, "bloc %dx%d en (%d, %d), rect %d,%d-%d,%d : canevas different", bw, bh, x, y,
+                r[0], r[1], r[2], r[3]);
+          cases++;
+          partial += exp > 0 && exp < bw * bh;
+        }
+      }
+    }
+  }
+  CHECK(partial > 200, "seulement %d blocs partiellement recadres", partial);
+  printf("bords : %d positions de blocs, dont %d recadrees\n", cases, partial);
+}
+
+// Blocs JPEGDEC d'une image w x h decodee (4:2:0 : 16 lignes, 256 px max),
+// bourrage compris, dans l'ordre petit- (ancien) et gros-boutiste (actuel)
+struct Frame {
+  int w, h, padW, padH;
+  std::vector<uint16_t> le, be;
+};
+
+static Frame makeFrame(int w, int h) {
+  Frame f;
+  f.w = w;
+  f.h = h;
+  f.padW = (w + 15) / 16 * 16;
+  f.padH = (h + 15) / 16 * 16;
+  f.le.resize(f.padW * f.padH);
+  f.be.resize(f.le.size());
+  for (size_t i = 0; i < f.le.size(); i++) {
+    f.le[i] = (uint16_t)rnd();
+    f.be[i] = swap16(f.le[i]);
+  }
+  return f;
+}
+
+// Rappelle 'draw' pour chaque bloc de 256x16 (dernier bloc plus etroit)
+template <class Draw>
+static void forEachBlock(const Frame& f, const std::vector<uint16_t>& img, Draw draw) {
+  static uint16_t blk[256 * 16];
+  for (int by = 0; by < f.padH; by += 16) {
+    for (int bx = 0; bx < f.padW; bx += 256) {
+      int bw = f.padW - bx < 256 ? f.padW - bx : 256;
+      for (int r = 0; r < 16; r++) memcpy(blk + r * bw, &img[(by + r) * f.padW + bx], bw * sizeof(uint16_t));
+      draw(blk, bw, 16, bx, by);
+    }
+  }
+}
+
+static double nowUs() {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void bench(const char* name, int w, int h) {
+  Frame f = makeFrame(w, h);
+  int offX = (CANVAS_W - w) / 2, offY = (CANVAS_H - h) / 2;
+  if (offX < 0) offX = 0;
+  if (offY < 0) offY = 0;
+  int clipX = offX + w < CANVAS_W ? offX + w : CANVAS_W, clipY = offY + h < CANVAS_H ? offY + h : CANVAS_H;
+  std::vector<uint16_t> oldC(CANVAS_W * CANVAS_H), newC(oldC.size());
+
+  // Blocs copies d'avance : seul le rappel est chronometre
+  double tOld = 1e18, tNew = 1e18;
+  for (int rep = 0; rep < 5; rep++) {
+    double t0 = nowUs();
+    for (int i = 0; i < FRAMES / 5; i++)
+      forEachBlock(f, f.le, [&](const uint16_t* px, int bw, int bh, int bx, int by) {
+        blitPerPixelOld(px, bw, bh, bx, by, oldC.data(), offX, offY);
+      });
+    double t1 = nowUs();
+    for (int i = 0; i < FRAMES / 5; i++)
+      forEachBlock(f, f.be, [&](const uint16_t* px, int bw, int bh, int bx, int by) {
+        jpegBlitClipped(px, bw, bh, bx + offX, by + offY, newC.data(), CANVAS_W, offX, offY, clipX, clipY);
+      });
+    double t2 = nowUs();
+    if (t1 - t0 < tOld) tOld = t1 - t0;
+    if (t2 - t1 < tNew) tNew = t2 - t1;
+  }
+  double copy = 1e18;   // decoupage des blocs seul, a retrancher
+  for (int rep = 0; rep < 5; rep++) {
+    double t0 = nowUs();
+    for (int i = 0; i < FRAMES / 5; i++) forEachBlock(f, f.be, [](const uint16_t*, int, int, int, int) {});
+    if (nowUs() - t0 < copy) copy = nowUs() - t0;
+  }
+  tOld = (tOld - copy) / (FRAMES / 5);
+  tNew = (tNew - copy) / (FRAMES / 5);
+
+  // Meme canevas dans le rectangle de l'image ; l'ancien rappel deborde
+  // du rectangle (bourrage) quand l'image ne couvre pas l'ecran
+  int diffIn = 0, padOut = 0;
+  for (int y = 0; y < CANVAS_H; y++) {
+    for (int x = 0; x < CANVAS_W; x++) {
+      bool in = x >= offX && x < clipX && y >= offY && y < clipY;
+      if (in) diffIn += oldC[y * CANVAS_W + x] != newC[y * CANVAS_W + x];
+      else padOut += oldC[y * CANVAS_W + x] != 0;
+      if (!in) CHECK(newC[y * CANVAS_W + x] == 0, "%s : (%d, %d) ecrit hors de l'image", name, x, y);
+    }
+  }
+  CHECK(diffIn == 0, "%s : %d pixels differents de l'ancien rappel", name, diffIn);
+  CHECK(tNew < tOld, "%s : memcpy pas plus rapide (%.1f / %.1f us)", name, tNew, tOld);
+  printf("%-22s par pixel %7.1f us/image  memcpy %6.1f us/image  (x%.0f)  bourrage affiche avant : %d px\n",
+         name, tOld, tNew, tOld / tNew, padOut);
+}
+
+int main() {
+  testClippedEdges();
+  bench("plein ecran 480x320", 480, 320);
+  bench("recadre 504x378", 504, 378);
+  bench("centre 300x200", 300, 200);
+  return hostTestEnd();
+}
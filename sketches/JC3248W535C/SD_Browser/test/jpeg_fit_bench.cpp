@@ -0,0 +1,290 @@
+/*
+ * jpeg_fit_bench.cpp - Banc PC du decodage reduit + ajustement (jpeg_fit.h)
+ *
+ * Decode chaque JPEG comme decodeImage() : echelle DCT de jpegPickScale(),
+ * JpegFit alimente bloc par bloc par le rappel, image centree sur le
+ * canevas 480x320. Pour chaque image :
+ *   - echelle et taille affichee comparees aux valeurs attendues ;
+ *   - temps de decodage plein (1/1 puis recadrage, l'ancien chemin) et
+ *     reduit (1/2..1/8 + ajustement), meilleur de 5, et la part du seul
+ *     decodeur (pixels jetes) : a 1/8 le decodage Huffman, que l'echelle
+ *     n'evite pas, reste le plancher ;
+ *   - bornes : rien d'ecrit hors du rectangle de l'image ni hors du
+ *     canevas, tout le rectangle ecrit, bourrage des MCU jamais affiche
+ *     (deux passes, canevas et bourrage differents, memes pixels) ;
+ *   - ajustement par blocs identique au bilineaire sur l'image entiere.
+ * jpegPickScale() est aussi verifie sur une grille de tailles.
+ *
+ * JPEGDEC est remplace par jpegdec_host.h (libjpeg-turbo, meme interface,
+ * memes blocs). samples/ : photos du boitier (3d/) reduites et recadrees,
+ * plus une photo 4032x3024 d'origine pour l'echelle 1/8. D'autres JPEG
+ * se passent en arguments (echelle et bornes verifiees, pas la table).
+ *
+ *   g++ -std=c++11 -O2 -Wall -I. -I../include -I../../../common jpeg_fit_bench.cpp -ljpeg -o /tmp/jpeg_fit_bench && /tmp/jpeg_fit_bench [photo.jpg ...]
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "host_test.h"
+#include "jpeg_blit.h"
+#include "jpeg_fit.h"
+#include "jpegdec_host.h"
+
+#define CANVAS_W 480               // comme dans main.cpp
+#define CANVAS_H 320
+#define GUARD    1024              // pixels de garde avant/apres le canevas
+#define RUNS     5
+
+#define CAMERA_PHOTO "../../../../3d/Standalone Case JC3248W535C - 7127557/images/PXL_20250825_152719231.jpg"
+
+struct Expected {
+  const char* path;
+  int w, h, div, dstW, dstH;
+};
+
+// Calcule a la main : echelle la plus forte qui couvre encore 480x320
+static const Expected samples[] = {
+  {"samples/small_300x200.jpg",     300,  200,  1, 300, 200},   // deja a l'ecran : 1:1
+  {"samples/landscape_504x378.jpg", 504,  378,  1, 426, 320},   // ajustement seul
+  {"samples/portrait_756x1008.jpg", 756,  1008, 2, 240, 320},
+  {"samples/odd_1001x667.jpg",      1001, 667,  2, 480, 320},   // bords hors MCU
+  {"samples/wide_2000x1125.jpg",    2000, 1125, 4, 480, 270},
+  {CAMERA_PHOTO,                    4032, 3024, 8, 426, 320},
+};
+
+// Etat du rappel, comme les globales de main.cpp
+static JpegFit fit;
+static bool fitActive;
+static uint16_t* canvas;
+static int offX, offY, clipX, clipY;
+static std::vector<uint16_t>* whole;   // capture de l'image decodee entiere
+static int wholeW, wholeH;
+static bool nullDraw;                  // decodage seul, pixels jetes
+
+static int drawCb(JPEGDRAW* d) {
+  if (nullDraw) return 1;
+  if (whole) {
+    for (int y = 0; y < d->iHeight && d->y + y < wholeH; y++)
+      for (int x = 0; x < d->iWidth && d->x + x < wholeW; x++)
+        (*whole)[(d->y + y) * wholeW + d->x + x] = d->pPixels[y * d->iWidth + x];
+    return 1;
+  }
+  if (fitActive) {
+    fit.block(d->pPixels, d->iWidth, d->x, d->y, d->iWidth, d->iHeight,
+              canvas + offY * CANVAS_W + offX, CANVAS_W);
+    return 1;
+  }
+  jpegBlitClipped(d->pPixels, d->iWidth, d->iHeight, d->x + offX, d->y + offY, canvas, CANVAS_W,
+                  offX, offY, clipX, clipY);
+  return 1;
+}
+
+static double nowMs() {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Result {
+  JpegScale scale;
+  int shownW, shownH;
+  double ms;
+};
+
+// decodeImage() sans la carte SD ; full : ancien chemin 1/1 + recadrage
+static Result decodeTo(JPEGDEC& jpeg, const std::vector<uint8_t>& file, uint16_t* buf, bool full) {
+  Result r;
+  jpeg.openRAM(file.data(), (int)file.size(), drawCb);
+  jpeg.setPixelType(RGB565_BIG_ENDIAN);   // LV_COLOR_16_SWAP = 1
+  int w = jpeg.getWidth(), h = jpeg.getHeight();
+  r.scale = full ? JpegScale{1, w, h, w, h} : jpegPickScale(w, h, CANVAS_W, CANVAS_H);
+  int opt = r.scale.div == 8 ? JPEG_SCALE_EIGHTH : r.scale.div == 4 ? JPEG_SCALE_QUARTER :
+            r.scale.div == 2 ? JPEG_SCALE_HALF : 0;
+  double t0 = nowMs();
+  fitActive = r.scale.dstW != r.scale.decW || r.scale.dstH != r.scale.decH;
+  if (fitActive && !fit.begin(r.scale.decW, r.scale.decH, r.scale.dstW, r.scale.dstH, true, true)) fitActive = false;
+  r.shownW = fitActive ? r.scale.dstW : r.scale.decW;
+  r.shownH = fitActive ? r.scale.dstH : r.scale.decH;
+  offX = (CANVAS_W - r.shownW) / 2;
+  offY = (CANVAS_H - r.shownH) / 2;
+  if (offX < 0) offX = 0;
+  if (offY < 0) offY = 0;
+  clipX = offX + r.shownW < CANVAS_W ? offX + r.shownW : CANVAS_W;
+  clipY = offY + r.shownH < CANVAS_H ? offY + r.shownH : CANVAS_H;
+  canvas = buf;
+  jpeg.decode(0, 0, opt);
+  jpeg.close();
+  fit.end();
+  fitActive = false;
+  r.ms = nowMs() - t0;
+  return r;
+}
+
+static double bestOf(JPEGDEC& jpeg, const std::vector<uint8_t>& file, bool full) {
+  std::vector<uint16_t> buf(CANVAS_W * CANVAS_H);
+  double best = 1e9;
+  for (int i = 0; i < RUNS; i++) {
+    double ms = decodeTo(jpeg, file, buf.data(), full).ms;
+    if (ms < best) best = ms;
+  }
+  return best;
+}
+
+// Bilineaire de reference sur l'image decodee entiere : centres de pixels
+// alignes, poids sur 5 bits, comme JpegFit mais sans bloc ni retenue
+static uint16_t swap16(uint16_t v) { return (v >> 8) | (v << 8); }
+
+static void refAxis(int d, int dst, int src, int& p0, int& p1, int& w) {
+  int32_t s = (int32_t)(((int64_t)(2 * d + 1) * src * 256) / (2 * dst)) - 128;
+  if (s < 0) s = 0;
+  p0 = s >> 8;
+  w = ((s & 255) + 4) >> 3;
+  if (p0 >= src - 1) { p0 = src - 1; w = 0; }
+  if (w >= 32) { p0++; w = 0; }
+  p1 = w ? p0 + 1 : p0;
+}
+
+static uint16_t lerp565(uint16_t a, uint16_t b, int w) {
+  int r = (((a >> 11) * (32 - w) + (b >> 11) * w) >> 5);
+  int g = ((((a >> 5) & 63) * (32 - w) + ((b >> 5) & 63) * w) >> 5);
+  int bl = (((a & 31) * (32 - w) + (b & 31) * w) >> 5);
+  return (uint16_t)(r << 11 | g << 5 | bl);
+}
+
+static void checkAgainstWhole(JPEGDEC& jpeg, const std::vector<uint8_t>& file, const Result& r,
+                              const uint16_t* out, const char* name) {
+  std::vector<uint16_t> img(r.scale.decW * r.scale.decH);
+  whole = &img;
+  wholeW = r.scale.decW;
+  wholeH = r.scale.decH;
+  jpeg.openRAM(file.data(), (int)file.size(), drawCb);
+  jpeg.setPixelType(RGB565_BIG_ENDIAN);
+  int opt = r.scale.div == 8 ? JPEG_SCALE_EIGHTH : r.scale.div == 4 ? JPEG_SCALE_QUARTER :
+            r.scale.div == 2 ? JPEG_SCALE_HALF : 0;
+  jpeg.decode(0, 0, opt);
+  whole = nullptr;
+
+  int diffs = 0;
+  for (int dy = 0; dy < r.shownH; dy++) {
+    int y0, y1, wy;
+    refAxis(dy, r.shownH, wholeH, y0, y1, wy);
+    if (wy) y0 = y1 - 1;
+    for (int dx = 0; dx < r.shownW; dx++) {
+      int x0, x1, wx;
+      refAxis(dx, r.shownW, wholeW, x0, x1, wx);
+      if (wx) x0 = x1 - 1;
+      uint16_t v;
+      if (r.shownW == wholeW && r.shownH == wholeH) {
+        v = swap16(img[dy * wholeW + dx]);
+      } else {
+        uint16_t top = lerp565(swap16(img[y0 * wholeW + x0]), swap16(img[y0 * wholeW + x1]), wx);
+        uint16_t bot = lerp565(swap16(img[y1 * wholeW + x0]), swap16(img[y1 * wholeW + x1]), wx);
+        v = lerp565(top, bot, wy);
+      }
+      uint16_t got = swap16(out[(offY + dy) * CANVAS_W + offX + dx]);
+      if (got != v && diffs++ < 3) {
+        CHECK(got == v, "%s : pixel (%d, %d) %04x au lieu de %04x", name, dx, dy, got, v);
+      }
+    }
+  }
+  CHECK(diffs == 0, "%s : %d pixels differents du bilineaire sur l'image entiere", name, diffs);
+}
+
+// Deux passes (canevas et bourrage differents) : hors du rectangle, le
+// canevas est intact ; dedans, tout est ecrit et le bourrage n'y est pas
+static Result checkBounds(JPEGDEC& jpeg, const std::vector<uint8_t>& file, std::vector<uint16_t>& keep,
+                          const char* name) {
+  const uint16_t canary[2] = {0x1234, 0x4321}, pad[2] = {0x0000, 0xFFFF};
+  std::vector<uint16_t> buf[2];
+  Result r;
+  for (int pass = 0; pass < 2; pass++) {
+    buf[pass].assign(CANVAS_W * CANVAS_H + 2 * GUARD, canary[pass]);
+    jpeg.padValue = pad[pass];
+    r = decodeTo(jpeg, file, buf[pass].data() + GUARD, false);
+  }
+  jpeg.padValue = 0;
+
+  int outside = 0, unwritten = 0;
+  for (int i = 0; i < CANVAS_W * CANVAS_H + 2 * GUARD; i++) {
+    int p = i - GUARD, x = p % CANVAS_W, y = p / CANVAS_W;
+    bool in = p >= 0 && p < CANVAS_W * CANVAS_H && x >= offX && x < clipX && y >= offY && y < clipY;
+    if (in) unwritten += buf[0][i] != buf[1][i];
+    else outside += buf[0][i] != canary[0] || buf[1][i] != canary[1];
+  }
+  CHECK(outside == 0, "%s : %d pixels ecrits hors de l'image", name, outside);
+  CHECK(unwritten == 0, "%s : %d pixels non ecrits ou bourrage visible", name, unwritten);
+  CHECK(clipX - offX == r.shownW && clipY - offY == r.shownH, "%s : image coupee (%dx%d au lieu de %dx%d)",
+        name, clipX - offX, clipY - offY, r.shownW, r.shownH);
+  CHECK(r.shownW <= CANVAS_W && r.shownH <= CANVAS_H, "%s : %dx%d depasse l'ecran", name, r.shownW, r.shownH);
+  keep.assign(buf[0].begin() + GUARD, buf[0].end() - GUARD);
+  return r;
+}
+
+static bool readFile(const char* path, std::vector<uint8_t>& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+static void runImage(const char* path, const Expected* exp) {
+  std::vector<uint8_t> file;
+  if (!readFile(path, file)) {
+    CHECK(false, "lecture de %s", path);
+    return;
+  }
+  const char* name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+  JPEGDEC jpeg;
+  std::vector<uint16_t> out;
+  Result r = checkBounds(jpeg, file, out, name);
+  if (exp) {
+    CHECK(jpeg.getWidth() == exp->w && jpeg.getHeight() == exp->h, "%s : %dx%d", name, jpeg.getWidth(),
+          jpeg.getHeight());
+    CHECK(r.scale.div == exp->div && r.shownW == exp->dstW && r.shownH == exp->dstH,
+          "%s : 1/%d, %dx%d au lieu de 1/%d, %dx%d", name, r.scale.div, r.shownW, r.shownH, exp->div,
+          exp->dstW, exp->dstH);
+  }
+  checkAgainstWhole(jpeg, file, r, out.data(), name);
+
+  double full = bestOf(jpeg, file, true), scaled = bestOf(jpeg, file, false);
+  nullDraw = true;
+  double decodeOnly = bestOf(jpeg, file, false);
+  nullDraw = false;
+  printf("%-27s %4dx%-4d %4.0f Ko  1/%d -> %3dx%-3d  plein %6.2f ms  reduit %6.2f ms (x%.1f, dont decodage %.2f)\n",
+         name, jpeg.getWidth(), jpeg.getHeight(), file.size() / 1024.0, r.scale.div, r.shownW, r.shownH,
+         full, scaled, full / scaled, decodeOnly);
+  // A partir de 1/4, la reduction DCT l'emporte nettement sur l'ajustement
+  if (r.scale.div >= 4) CHECK(full / scaled >= 1.5, "%s : reduit a peine plus rapide (x%.2f)", name, full / scaled);
+}
+
+// Echelle la plus forte qui couvre la taille ajustee ; reduction restante
+// dans [0,5, 1] (a l'arrondi pres) pour que le bilineaire 2 points
+// suffise, sauf au-dela de 1/8 (images de plus de 8:1, sous-echantillonnees)
+static void testPickScale() {
+  int bad = 0;
+  for (int w = 1; w <= 6000; w += 37) {
+    for (int h = 1; h <= 6000; h += 41) {
+      JpegScale s = jpegPickScale(w, h, CANVAS_W, CANVAS_H);
+      bool ok = s.dstW >= 1 && s.dstH >= 1 && s.dstW <= CANVAS_W && s.dstH <= CANVAS_H &&
+                s.dstW <= s.decW && s.dstH <= s.decH &&
+                (s.div == 8 || (2 * s.div * CANVAS_W > w && 2 * s.div * CANVAS_H > h &&
+                                2 * s.dstW + 2 >= s.decW && 2 * s.dstH + 2 >= s.decH));
+      if (!ok && bad++ < 3) {
+        CHECK(ok, "%dx%d : 1/%d, decode %dx%d, affiche %dx%d", w, h, s.div, s.decW, s.decH, s.dstW, s.dstH);
+      }
+    }
+  }
+  CHECK(bad == 0, "jpegPickScale : %d tailles incorrectes", bad);
+}
+
+int main(int argc, char** argv) {
+  testPickScale();
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) runImage(argv[i], nullptr);
+  } else {
+    for (const Expected& e : samples) runImage(e.path, &e);
+  }
+  return hostTestEnd();
+}
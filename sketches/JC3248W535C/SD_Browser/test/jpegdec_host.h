@@ -0,0 +1,134 @@
+/*
+ * jpegdec_host.h - Remplacant PC de JPEGDEC pour les tests (libjpeg-turbo)
+ *
+ * Meme interface que la partie de JPEGDEC utilisee par main.cpp
+ * (openRAM, getWidth/getHeight, setPixelType, decode avec
+ * JPEG_SCALE_HALF/QUARTER/EIGHTH, JPEGDRAW) et meme decoupage des blocs :
+ * une ligne de MCU (16 lignes en 4:2:0, divisees par l'echelle) par appel,
+ * au plus 4096 pixels par bloc, largeur et hauteur arrondies au MCU.
+ * Les pixels de bourrage au-dela de l'image valent padValue : un test
+ * peut verifier qu'ils n'atteignent jamais l'ecran.
+ *
+ * La reduction se fait dans l'IDCT comme sur JPEGDEC (scale_denom de
+ * libjpeg) ; les temps mesures sont ceux du PC, seul leur rapport
+ * plein/reduit se compare a l'ESP32-S3.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <jpeglib.h>
+
+#define RGB565_LITTLE_ENDIAN 0
+#define RGB565_BIG_ENDIAN    1
+#define JPEG_SCALE_HALF      2
+#define JPEG_SCALE_QUARTER   4
+#define JPEG_SCALE_EIGHTH    8
+#define JPEG_MAX_BLOCK_PIXELS 4096
+
+struct JPEGDRAW {
+  int x, y;
+  int iWidth, iHeight;
+  int iBpp;
+  uint16_t* pPixels;
+  void* pUser;
+};
+
+typedef int (JPEG_DRAW_CALLBACK)(JPEGDRAW* pDraw);
+
+class JPEGDEC {
+public:
+  uint16_t padValue = 0;
+
+  int openRAM(const uint8_t* data, int size, JPEG_DRAW_CALLBACK* draw) {
+    src = data;
+    srcSize = size;
+    drawCb = draw;
+    jpeg_decompress_struct d;
+    jpeg_error_mgr e;
+    if (!header(d, e)) return 0;
+    w = d.image_width;
+    h = d.image_height;
+    mcuH = 8 * d.max_v_samp_factor;
+    mcuW = 8 * d.max_h_samp_factor;
+    jpeg_destroy_decompress(&d);
+    return 1;
+  }
+
+  void close() {}
+  int getWidth() const { return w; }
+  int getHeight() const { return h; }
+  int getLastError() const { return err; }
+  void setPixelType(int t) { bigEndian = t == RGB565_BIG_ENDIAN; }
+
+  // Renvoie 1 si toute l'image a ete decodee, 0 si le rappel a arrete
+  int decode(int x, int y, int options) {
+    int div = options & 0xE ? options & 0xE : 1;
+    jpeg_decompress_struct d;
+    jpeg_error_mgr e;
+    if (!header(d, e)) return 0;
+    d.scale_num = 1;
+    d.scale_denom = div;
+    d.out_color_space = JCS_RGB;
+    d.dct_method = JDCT_ISLOW;
+    jpeg_start_decompress(&d);
+
+    int ow = d.output_width, oh = d.output_height;
+    int bh = mcuH / div, bwMcu = mcuW / div;
+    if (bh < 1) bh = 1;
+    if (bwMcu < 1) bwMcu = 1;
+    int padW = (ow + bwMcu - 1) / bwMcu * bwMcu;
+    int blockW = JPEG_MAX_BLOCK_PIXELS / bh / bwMcu * bwMcu;
+    if (blockW > padW) blockW = padW;
+
+    std::vector<uint8_t> rgb(ow * 3);
+    std::vector<uint16_t> band(padW * bh);
+    std::vector<uint16_t> blk(blockW * bh);
+    int ok = 1;
+    for (int by = 0; by < oh && ok; by += bh) {
+      for (int r = 0; r < bh; r++) {
+        uint16_t* row = &band[r * padW];
+        for (int i = 0; i < padW; i++) row[i] = padValue;
+        if (by + r >= oh) continue;
+        uint8_t* p = rgb.data();
+        jpeg_read_scanlines(&d, &p, 1);
+        for (int i = 0; i < ow; i++) {
+          uint16_t v = ((p[3 * i] & 0xF8) << 8) | ((p[3 * i + 1] & 0xFC) << 3) | (p[3 * i + 2] >> 3);
+          row[i] = bigEndian ? (uint16_t)((v >> 8) | (v << 8)) : v;
+        }
+      }
+      for (int bx = 0; bx < padW && ok; bx += blockW) {
+        int bw = padW - bx < blockW ? padW - bx : blockW;
+        for (int r = 0; r < bh; r++) memcpy(&blk[r * bw], &band[r * padW + bx], bw * sizeof(uint16_t));
+        JPEGDRAW dr = {x + bx, y + by, bw, bh, 16, blk.data(), nullptr};
+        ok = drawCb(&dr);
+      }
+    }
+    if (ok) jpeg_finish_decompress(&d);
+    else jpeg_abort_decompress(&d);
+    jpeg_destroy_decompress(&d);
+    return ok;
+  }
+
+private:
+  bool header(jpeg_decompress_struct& d, jpeg_error_mgr& e) {
+    d.err = jpeg_std_error(&e);
+    jpeg_create_decompress(&d);
+    jpeg_mem_src(&d, const_cast<uint8_t*>(src), srcSize);
+    if (jpeg_read_header(&d, TRUE) != JPEG_HEADER_OK) {
+      jpeg_destroy_decompress(&d);
+      err = 1;
+      return false;
+    }
+    return true;
+  }
+
+  const uint8_t* src = nullptr;
+  unsigned long srcSize = 0;
+  JPEG_DRAW_CALLBACK* drawCb = nullptr;
+  int w = 0, h = 0, mcuW = 8, mcuH = 8, err = 0;
+  bool bigEndian = false;
+};
@@ -2,6 +2,10 @@
  * System_Monitor - JC3248W535C
  *
  * Dashboard systeme avec jauges : RAM, PSRAM, uptime, CPU.
+ * Profil memoire (fragmentation, piles, CPU par tache) : bouton en bas
+ * ou appui long n'importe ou.
+ * Les widgets ne sont touches que si leur valeur change (ui_bind.h) :
+ * avec full_refresh chaque ecriture redessine tout l'ecran.
  *
  * Board: JC3248W535C (ESP32-S3 + LCD tactile 3.5")
  * FQBN: PlatformIO esp32-s3-devkitc-1
@@ -17,6 +21,8 @@
 #include "esp_heap_caps.h"
 #include "esp_system.h"
 #include "esp_chip_info.h"
+#include "mem_profiler.h"
+#include "ui_bind.h"
 
 #define LVGL_PORT_ROTATION_DEGREE (270)
 
@@ -44,6 +50,14 @@ static lv_obj_t *label_chip;
 static size_t total_ram = 0;
 static size_t total_psram = 0;
 
+// Heap / task profiler overlay (sketches/common/mem_profiler.h)
+static MemProfilerOverlay profiler;
+
+static void btn_profiler_cb(lv_event_t *e)
+{
+    profiler.toggle();
+}
+
 static lv_obj_t* create_gauge_card(lv_obj_t *parent, const char *title, lv_color_t color,
                                     lv_obj_t **arc_out, lv_obj_t **pct_out, lv_obj_t **val_out)
 {
@@ -161,30 +175,23 @@ void update_display()
     int psram_used_pct = 100 - (free_psram * 100 / total_psram);
 
     // Update RAM gauge
-    lv_arc_set_value(arc_ram, ram_used_pct);
-    char buf[32];
-    snprintf(buf, sizeof(buf), "%d%%", ram_used_pct);
-    lv_label_set_text(label_ram_pct, buf);
-    snprintf(buf, sizeof(buf), "%d / %d KB", (total_ram - free_ram) / 1024, total_ram / 1024);
-    lv_label_set_text(label_ram_val, buf);
+    uiSetArc(arc_ram, ram_used_pct);
+    uiSetTextFmt(label_ram_pct, "%d%%", ram_used_pct);
+    uiSetTextFmt(label_ram_val, "%d / %d KB", (total_ram - free_ram) / 1024, total_ram / 1024);
 
     // Update PSRAM gauge
-    lv_arc_set_value(arc_psram, psram_used_pct);
-    snprintf(buf, sizeof(buf), "%d%%", psram_used_pct);
-    lv_label_set_text(label_psram_pct, buf);
-    snprintf(buf, sizeof(buf), "%.1f / %.1f MB", (total_psram - free_psram) / 1048576.0, total_psram / 1048576.0);
-    lv_label_set_text(label_psram_val, buf);
+    uiSetArc(arc_psram, psram_used_pct);
+    uiSetTextFmt(label_psram_pct, "%d%%", psram_used_pct);
+    uiSetTextFmt(label_psram_val, "%.1f / %.1f MB", (total_psram - free_psram) / 1048576.0, total_psram / 1048576.0);
 
     // Update uptime
     unsigned long secs = millis() / 1000;
     unsigned long mins = secs / 60;
     unsigned long hours = mins / 60;
-    snprintf(buf, sizeof(buf), "%02lu:%02lu:%02lu", hours, mins % 60, secs % 60);
-    lv_label_set_text(label_uptime, buf);
+    uiSetTextFmt(label_uptime, "%02lu:%02lu:%02lu", hours, mins % 60, secs % 60);
 
     // Update CPU frequency
-    snprintf(buf, sizeof(buf), "%d MHz", getCpuFrequencyMhz());
-    lv_label_set_text(label_cpu, buf);
+    uiSetTextFmt(label_cpu, "%d MHz", getCpuFrequencyMhz());
 }
 
 void setup()
@@ -254,7 +261,22 @@ void setup()
     snprintf(chip_buf, sizeof(chip_buf), "ESP32-S3 %d cores", chip_info.cores);
     lv_label_set_text(label_chip, chip_buf);
 
+    // Profiler: overlay above the screen, bottom button or long press
+    profiler.begin();
+    lv_obj_add_event_cb(lv_scr_act(), MemProfilerOverlay::toggleCb, LV_EVENT_LONG_PRESSED, &profiler);
+
+    lv_obj_t *btn_prof = lv_btn_create(lv_scr_act());
+    lv_obj_set_size(btn_prof, 200, 30);
+    lv_obj_align(btn_prof, LV_ALIGN_BOTTOM_MID, 0, -5);
+    lv_obj_set_style_bg_color(btn_prof, lv_color_hex(COLOR_CARD), 0);
+    lv_obj_add_event_cb(btn_prof, btn_profiler_cb, LV_EVENT_CLICKED, NULL);
+    lv_obj_t *lbl_prof = lv_label_create(btn_prof);
+    lv_label_set_text(lbl_prof, LV_SYMBOL_LIST " Profil memoire");
+    lv_obj_set_style_text_font(lbl_prof, &lv_font_montserrat_14, 0);
+    lv_obj_center(lbl_prof);
+
     // Initial update
+    uiRedrawCounterBegin();
     update_display();
 
     bsp_display_unlock();
@@ -265,6 +287,7 @@ void setup()
 void loop()
 {
     static unsigned long last_update = 0;
+    static unsigned long last_log = 0;
 
     if (millis() - last_update > 1000) {
         bsp_display_lock(0);
@@ -273,5 +296,14 @@ void loop()
         last_update = millis();
     }
 
+    // Heap trend on Serial for long runs (last profiler sample)
+    if (millis() - last_log > 10000) {
+        bsp_display_lock(0);
+        profiler.prof.print(Serial);
+        uiBindPrint(Serial);
+        bsp_display_unlock();
+        last_log = millis();
+    }
+
     delay(50);
 }
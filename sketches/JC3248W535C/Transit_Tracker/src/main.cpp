@@ -24,6 +24,8 @@
 #include "lv_port.h"
 #include "credentials.h"
 #include "prim_config.h"
+#include "perf_overlay.h"
+#include "ui_bind.h"
 
 #define LVGL_PORT_ROTATION_DEGREE (270)
 
@@ -239,11 +241,13 @@ static void fetchDepartures()
     https.setTimeout(10000);
     esp_task_wdt_reset();
 
+    perfFetchBegin();
     if (https.begin(client, url)) {
         https.addHeader("Accept", "application/json");
         https.addHeader("apikey", PRIM_API_KEY);
 
         int httpCode = https.GET();
+        perfFetchEnd(httpCode);
         esp_task_wdt_reset();
         Serial.printf("HTTP code: %d\n", httpCode);
 
@@ -419,40 +423,40 @@ static void updateUI()
 {
     bsp_display_lock(0);
 
-    lv_obj_add_flag(spinner, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_clear_flag(btn_refresh, LV_OBJ_FLAG_HIDDEN);
+    uiSetHidden(spinner, true);
+    uiSetHidden(btn_refresh, false);
 
     StopConfig& stop = stops[currentStop];
 
     // Header
     char buf[64];
     snprintf(buf, sizeof(buf), LV_SYMBOL_GPS " %s", stop.name);
-    lv_label_set_text(label_stop, buf);
+    uiSetText(label_stop, buf);
 
     // Night mode overlay : seulement pour les bus
     bool showNight = (stop.type == TYPE_BUS) && busNightMode;
     if (showNight) {
-        lv_obj_clear_flag(night_overlay, LV_OBJ_FLAG_HIDDEN);
-        lv_label_set_text(label_status, "Mode veille bus (06h-20h)");
+        uiSetHidden(night_overlay, false);
+        uiSetText(label_status, "Mode veille bus (06h-20h)");
         bsp_display_unlock();
         return;
     }
-    lv_obj_add_flag(night_overlay, LV_OBJ_FLAG_HIDDEN);
+    uiSetHidden(night_overlay, true);
 
     // Status
     if (!dataValid) {
-        if (strlen(errorMsg) > 0) lv_label_set_text(label_status, errorMsg);
+        if (strlen(errorMsg) > 0) uiSetText(label_status, errorMsg);
     } else if (departureCount == 0) {
-        lv_label_set_text(label_status, stop.type == TYPE_TRAIN ? "Aucun train prevu" : "Aucun bus prevu");
+        uiSetText(label_status, stop.type == TYPE_TRAIN ? "Aucun train prevu" : "Aucun bus prevu");
     } else {
         snprintf(buf, sizeof(buf), "%d %s%s", departureCount,
             stop.type == TYPE_TRAIN ? "train" : "passage",
             departureCount > 1 ? "s" : "");
-        lv_label_set_text(label_status, buf);
+        uiSetText(label_status, buf);
     }
 
     snprintf(buf, sizeof(buf), "MAJ: %s", lastUpdateTime);
-    lv_label_set_text(label_update_time, buf);
+    uiSetText(label_update_time, buf);
 
     // Rows
     for (int i = 0; i < MAX_DEPARTURES; i++) {
@@ -460,27 +464,27 @@ static void updateUI()
             Departure& d = departures[i];
 
             // Badge ligne
-            lv_obj_set_style_bg_color(line_badges[i], lv_color_hex(d.lineColor), 0);
-            lv_label_set_text(labels_line[i], d.lineName);
-            lv_obj_set_style_text_color(labels_line[i], lv_color_hex(d.lineTextColor), 0);
+            uiSetBgColor(line_badges[i], lv_color_hex(d.lineColor));
+            uiSetText(labels_line[i], d.lineName);
+            uiSetTextColor(labels_line[i], lv_color_hex(d.lineTextColor));
 
             // Temps restant (commun bus + train)
             char timeBuf[16];
             lv_color_t timeColor;
             formatTimeLeft(d.minutesLeft, d.atStop, timeBuf, sizeof(timeBuf), &timeColor);
-            lv_label_set_text(labels_time[i], timeBuf);
-            lv_obj_set_style_text_color(labels_time[i], timeColor, 0);
+            uiSetText(labels_time[i], timeBuf);
+            uiSetTextColor(labels_time[i], timeColor);
 
             // Mission (train only)
             if (stop.type == TYPE_TRAIN && d.mission[0]) {
-                lv_label_set_text(labels_mission[i], d.mission);
-                lv_obj_clear_flag(labels_mission[i], LV_OBJ_FLAG_HIDDEN);
+                uiSetText(labels_mission[i], d.mission);
+                uiSetHidden(labels_mission[i], false);
             } else {
-                lv_obj_add_flag(labels_mission[i], LV_OBJ_FLAG_HIDDEN);
+                uiSetHidden(labels_mission[i], true);
             }
 
             // Destination
-            lv_label_set_text(labels_dest[i], d.destination);
+            uiSetText(labels_dest[i], d.destination);
 
             // Slot droite : voie + retard pour train, vide pour bus
             if (stop.type == TYPE_TRAIN) {
@@ -493,18 +497,19 @@ static void updateUI()
                     strncpy(rightBuf, d.platform, sizeof(rightBuf));
                     rightBuf[sizeof(rightBuf) - 1] = '\0';
                 }
-                lv_label_set_text(labels_right[i], rightBuf);
-                lv_obj_clear_flag(labels_right[i], LV_OBJ_FLAG_HIDDEN);
+                uiSetText(labels_right[i], rightBuf);
+                uiSetHidden(labels_right[i], false);
             } else {
-                lv_obj_add_flag(labels_right[i], LV_OBJ_FLAG_HIDDEN);
+                uiSetHidden(labels_right[i], true);
             }
 
-            lv_obj_clear_flag(rows[i], LV_OBJ_FLAG_HIDDEN);
+            uiSetHidden(rows[i], false);
         } else {
-            lv_obj_add_flag(rows[i], LV_OBJ_FLAG_HIDDEN);
+            uiSetHidden(rows[i], true);
         }
     }
 
+    uiBindPrint(Serial);
     bsp_display_unlock();
 }
 
@@ -513,9 +518,9 @@ static void updateStopButtons()
     bsp_display_lock(0);
     for (int i = 0; i < MAX_STOPS; i++) {
         if (i == currentStop) {
-            lv_obj_set_style_bg_color(btn_stops[i], lv_color_hex(COLOR_ACCENT), 0);
+            uiSetBgColor(btn_stops[i], lv_color_hex(COLOR_ACCENT));
         } else {
-            lv_obj_set_style_bg_color(btn_stops[i], lv_color_hex(COLOR_CARD), 0);
+            uiSetBgColor(btn_stops[i], lv_color_hex(COLOR_CARD));
         }
     }
     bsp_display_unlock();
@@ -731,6 +736,8 @@ void setup()
     createUI();
 
     bsp_display_lock(0);
+    perfOverlayBegin();
+    uiRedrawCounterBegin();
     lv_label_set_text(label_status, "Connexion WiFi...");
     bsp_display_unlock();
 
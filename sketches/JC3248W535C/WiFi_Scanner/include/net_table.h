@@ -0,0 +1,119 @@
+/*
+ * net_table.h - Networks seen by successive WiFi scans, keyed by BSSID
+ *
+ * merge() folds the results of a finished scan into the table instead of
+ * replacing it: an access point keeps its entry from scan to scan, and
+ * its 'rev' only changes when something shown about it changes (SSID,
+ * RSSI, channel, security, stale state). The UI compares rev with what a
+ * row last displayed and leaves untouched rows alone.
+ *
+ * An entry missing from a scan is kept as stale, then dropped after
+ * NET_KEEP_SCANS scans in a row without it. Entries stay sorted by RSSI;
+ * an entry only overtakes its neighbour when stronger by NET_SORT_HYST dB,
+ * so normal RSSI jitter does not reshuffle the list on every scan.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define NET_MAX         48
+#define NET_KEEP_SCANS  3
+#define NET_SORT_HYST   4
+
+struct NetEntry {
+    uint8_t bssid[6];
+    char ssid[33];
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t auth;         // wifi_auth_mode_t
+    uint8_t missed;       // consecutive scans without this BSSID
+    uint32_t rev;
+};
+
+class NetTable {
+public:
+    // n: WiFi.scanComplete() result, scan results still allocated.
+    // Returns the number of entries added, changed or dropped.
+    int merge(int n)
+    {
+        bool seen[NET_MAX] = {};
+        int changes = 0;
+
+        for (int i = 0; i < n; i++) {
+            const uint8_t *bssid = WiFi.BSSID(i);
+            if (!bssid) continue;
+            int k = find(bssid);
+            if (k < 0) {
+                if (count == NET_MAX) continue;
+                k = count++;
+                memset(&e[k], 0, sizeof(NetEntry));
+                memcpy(e[k].bssid, bssid, 6);
+            } else if (seen[k]) {
+                continue;
+            }
+            seen[k] = true;
+            if (update(e[k], WiFi.SSID(i).c_str(), WiFi.RSSI(i), WiFi.channel(i), WiFi.encryptionType(i))) changes++;
+        }
+
+        for (int k = count - 1; k >= 0; k--) {
+            if (seen[k]) continue;
+            if (++e[k].missed >= NET_KEEP_SCANS) {
+                memmove(&e[k], &e[k + 1], (count - k - 1) * sizeof(NetEntry));
+                count--;
+                changes++;
+            } else if (e[k].missed == 1) {
+                e[k].rev = ++revClock;    // now shown as stale
+                changes++;
+            }
+        }
+
+        sort();
+        return changes;
+    }
+
+    int size() const { return count; }
+    const NetEntry &at(int i) const { return e[i]; }
+
+private:
+    int find(const uint8_t *bssid) const
+    {
+        for (int k = 0; k < count; k++) {
+            if (memcmp(e[k].bssid, bssid, 6) == 0) return k;
+        }
+        return -1;
+    }
+
+    bool update(NetEntry &net, const char *ssid, int rssi, int channel, int auth)
+    {
+        bool changed = net.rev == 0 || net.missed != 0 || net.rssi != rssi || net.channel != channel ||
+                       net.auth != auth || strncmp(net.ssid, ssid, sizeof(net.ssid) - 1) != 0;
+        net.missed = 0;
+        if (!changed) return false;
+        strlcpy(net.ssid, ssid, sizeof(net.ssid));
+        net.rssi = rssi;
+        net.channel = channel;
+        net.auth = auth;
+        net.rev = ++revClock;
+        return true;
+    }
+
+    // Insertion sort with hysteresis: already nearly sorted after a merge
+    void sort()
+    {
+        for (int i = 1; i < count; i++) {
+            NetEntry cur = e[i];
+            int j = i;
+            while (j > 0 && cur.rssi > e[j - 1].rssi + NET_SORT_HYST) {
+                e[j] = e[j - 1];
+                j--;
+            }
+            e[j] = cur;
+        }
+    }
+
+    NetEntry e[NET_MAX];
+    int count = 0;
+    uint32_t revClock = 0;
+};
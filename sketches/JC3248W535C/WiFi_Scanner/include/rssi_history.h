@@ -0,0 +1,146 @@
+/*
+ * rssi_history.h - Per-BSSID RSSI time series in a fixed ring buffer
+ *
+ * Every finished scan is one sample: beginSample() opens a new column,
+ * add() stores the RSSI of each BSSID heard, endSample() closes it. A
+ * BSSID not heard in a sample gets HIST_NONE there, so gaps in a series
+ * are the drops seen from this spot. Memory is fixed: HIST_SLOTS series of
+ * HIST_LEN samples; when all slots are taken, the BSSID unheard for the
+ * longest time gives its slot up.
+ *
+ * endSample() writes one CSV line per BSSID that was heard in the previous
+ * sample and not in this one:
+ *   wifi_drop,<ms>,<bssid>,<channel>,<last rssi>,<ssid>
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define HIST_LEN       64
+#define HIST_SLOTS     48
+#define HIST_NONE      -128
+#define HIST_CHANNELS  13      // 2.4 GHz, channels 1..13
+
+struct RssiSeries {
+    bool used;
+    uint8_t bssid[6];
+    char ssid[33];
+    uint8_t channel;
+    uint32_t lastSample;       // sample number the BSSID was last heard in
+    int8_t rssi[HIST_LEN];
+};
+
+class RssiHistory {
+public:
+    void beginSample(uint32_t ms)
+    {
+        head = (head + 1) % HIST_LEN;
+        samples++;
+        times[head] = ms;
+        for (int i = 0; i < HIST_SLOTS; i++) s[i].rssi[head] = HIST_NONE;
+    }
+
+    void add(const uint8_t *bssid, const char *ssid, int channel, int rssi)
+    {
+        RssiSeries &r = s[slot(bssid)];
+        strlcpy(r.ssid, ssid, sizeof(r.ssid));
+        r.channel = channel;
+        r.lastSample = samples;
+        if (rssi > r.rssi[head]) r.rssi[head] = constrain(rssi, HIST_NONE + 1, 0);
+    }
+
+    void endSample(Print *log)
+    {
+        if (!log || samples < 2) return;
+        int prev = (head + HIST_LEN - 1) % HIST_LEN;
+        for (int i = 0; i < HIST_SLOTS; i++) {
+            const RssiSeries &r = s[i];
+            if (!r.used || r.rssi[prev] == HIST_NONE || r.rssi[head] != HIST_NONE) continue;
+            log->printf("wifi_drop,%lu,%02x:%02x:%02x:%02x:%02x:%02x,%d,%d,%s\n",
+                        (unsigned long)times[head], r.bssid[0], r.bssid[1], r.bssid[2],
+                        r.bssid[3], r.bssid[4], r.bssid[5], r.channel, r.rssi[prev], r.ssid);
+        }
+    }
+
+    // age 0 = newest sample
+    int8_t at(int i, int age) const
+    {
+        if (!s[i].used || age >= HIST_LEN || (uint32_t)age >= samples) return HIST_NONE;
+        return s[i].rssi[(head + HIST_LEN - age) % HIST_LEN];
+    }
+
+    const RssiSeries &series(int i) const { return s[i]; }
+
+    // Strongest RSSI per channel (index 0 = channel 1) in the newest sample
+    void channelPeak(int8_t out[HIST_CHANNELS]) const
+    {
+        for (int c = 0; c < HIST_CHANNELS; c++) out[c] = HIST_NONE;
+        for (int i = 0; i < HIST_SLOTS; i++) {
+            int c = s[i].channel - 1;
+            if (!s[i].used || c < 0 || c >= HIST_CHANNELS) continue;
+            if (s[i].rssi[head] > out[c]) out[c] = s[i].rssi[head];
+        }
+    }
+
+    // Occupancy 0..100 per channel in the newest sample. A 20 MHz 2.4 GHz
+    // channel overlaps its neighbours: each AP counts fully on its own
+    // channel, 1/2 on +-1, 1/4 on +-2, weighted by signal above -95 dBm.
+    void occupancy(uint8_t out[HIST_CHANNELS]) const
+    {
+        uint32_t acc[HIST_CHANNELS] = {};
+        for (int i = 0; i < HIST_SLOTS; i++) {
+            int c = s[i].channel - 1;
+            int rssi = s[i].rssi[head];
+            if (!s[i].used || rssi == HIST_NONE || c < 0 || c >= HIST_CHANNELS) continue;
+            uint32_t w = rssi > -95 ? rssi + 95 : 0;     // 0..95
+            for (int d = -2; d <= 2; d++) {
+                int k = c + d;
+                if (k >= 0 && k < HIST_CHANNELS) acc[k] += w >> abs(d);
+            }
+        }
+        // ~2 strong APs on one channel already mean a busy channel
+        for (int c = 0; c < HIST_CHANNELS; c++) out[c] = min<uint32_t>(acc[c] * 100 / 120, 100);
+    }
+
+    // Whole ring as CSV, oldest sample first: hist,<bssid>,<ch>,<ssid>,<rssi>...
+    void print(Print &out) const
+    {
+        int n = min<uint32_t>(samples, HIST_LEN);
+        for (int i = 0; i < HIST_SLOTS; i++) {
+            const RssiSeries &r = s[i];
+            if (!r.used) continue;
+            out.printf("hist,%02x:%02x:%02x:%02x:%02x:%02x,%d,%s", r.bssid[0], r.bssid[1], r.bssid[2],
+                       r.bssid[3], r.bssid[4], r.bssid[5], r.channel, r.ssid);
+            for (int age = n - 1; age >= 0; age--) out.printf(",%d", at(i, age));
+            out.print('\n');
+        }
+    }
+
+    uint32_t sampleCount() const { return samples; }
+
+private:
+    int slot(const uint8_t *bssid)
+    {
+        int freeSlot = -1, oldest = 0;
+        for (int i = 0; i < HIST_SLOTS; i++) {
+            if (!s[i].used) {
+                if (freeSlot < 0) freeSlot = i;
+                continue;
+            }
+            if (memcmp(s[i].bssid, bssid, 6) == 0) return i;
+            if (s[i].lastSample < s[oldest].lastSample || !s[oldest].used) oldest = i;
+        }
+        int i = freeSlot >= 0 ? freeSlot : oldest;
+        RssiSeries &r = s[i];
+        r.used = true;
+        memcpy(r.bssid, bssid, 6);
+        memset(r.rssi, HIST_NONE, sizeof(r.rssi));
+        return i;
+    }
+
+    RssiSeries s[HIST_SLOTS] = {};
+    uint32_t times[HIST_LEN] = {};
+    int head = 0;
+    uint32_t samples = 0;
+};
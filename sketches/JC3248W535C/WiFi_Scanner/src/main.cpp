@@ -3,6 +3,12 @@
  *
  * Scanner de reseaux WiFi avec interface tactile LVGL.
  * Liste scrollable, bouton scan, signal colore.
+ * Scan asynchrone relance toutes les 15 s : les resultats sont fusionnes
+ * par BSSID (net_table.h) et seules les lignes modifiees sont redessinees.
+ * Mode ANALYSE : scans en continu, historique RSSI par BSSID
+ * (rssi_history.h), occupation des canaux et waterfall. Les pertes de
+ * signal sont tracees sur le port serie (wifi_drop,...), appui long sur
+ * le waterfall pour exporter l'historique (hist,...).
  *
  * Board: JC3248W535C (ESP32-S3 + LCD tactile 3.5")
  * FQBN: PlatformIO esp32-s3-devkitc-1
@@ -16,6 +22,10 @@
 #include "display.h"
 #include "esp_bsp.h"
 #include "lv_port.h"
+#include "esp_heap_caps.h"
+#include "net_table.h"
+#include "rssi_history.h"
+#include "ui_bind.h"
 
 #define LVGL_PORT_ROTATION_DEGREE (270)
 
@@ -35,8 +45,15 @@ static lv_obj_t *label_status;
 static lv_obj_t *btn_scan;
 static lv_obj_t *list_networks;
 static lv_obj_t *spinner;
+static lv_obj_t *btn_mode;
+static lv_obj_t *label_mode;
+static lv_obj_t *view_analyzer;
+static lv_obj_t *chart_occ;
+static lv_chart_series_t *ser_occ;
+static lv_obj_t *canvas_wf;
 
 static bool scanning = false;
+static bool analyzer = false;
 
 // Get color based on signal strength
 static lv_color_t get_signal_color(int rssi)
@@ -56,110 +73,298 @@ static const char* get_signal_bars(int rssi)
     return LV_SYMBOL_WIFI;
 }
 
-// Perform WiFi scan and update list
-static void do_scan()
+// Row pool: created on demand, never deleted, hidden when unused
+#define ROW_H           44
+#define AUTO_SCAN_MS    15000
+
+struct NetRow {
+    lv_obj_t *obj;
+    lv_obj_t *lock;
+    lv_obj_t *ssid;
+    lv_obj_t *chan;
+    lv_obj_t *rssi;
+    lv_obj_t *icon;
+    uint8_t bssid[6];
+    uint32_t rev;         // NetEntry::rev last shown, 0 = unbound
+};
+
+static NetTable networks;
+static NetRow rows[NET_MAX];
+static int rowCount = 0;
+
+static volatile bool scanRequested = true;
+static unsigned long scanStart = 0;
+static unsigned long lastScanEnd = 0;
+
+// Analyzer: back-to-back scans, short dwell per channel
+#define ANALYZER_DWELL_MS  100
+#define WF_COL_W           32                      // px per channel
+#define WF_W               (HIST_CHANNELS * WF_COL_W)
+#define WF_H               120
+#define WF_ROW_H           2                       // px per sample
+
+static RssiHistory history;
+static lv_color_t *wf_buf = NULL;
+static lv_color_t wf_palette[64];
+
+static NetRow *create_row()
 {
-    bsp_display_lock(0);
-
-    // Show scanning state
-    scanning = true;
-    lv_label_set_text(label_status, "Scan en cours...");
-    lv_obj_clear_flag(spinner, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_add_flag(btn_scan, LV_OBJ_FLAG_HIDDEN);
+    NetRow &r = rows[rowCount++];
+
+    r.obj = lv_obj_create(list_networks);
+    lv_obj_set_size(r.obj, LV_PCT(100), ROW_H);
+    lv_obj_set_style_bg_color(r.obj, lv_color_hex(COLOR_CARD), 0);
+    lv_obj_set_style_bg_opa(r.obj, LV_OPA_COVER, 0);
+    lv_obj_set_style_border_width(r.obj, 0, 0);
+    lv_obj_set_style_radius(r.obj, 8, 0);
+    lv_obj_set_style_pad_hor(r.obj, 10, 0);
+    lv_obj_set_style_pad_ver(r.obj, 0, 0);
+    lv_obj_clear_flag(r.obj, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_clear_flag(r.obj, LV_OBJ_FLAG_CLICKABLE);
+
+    r.lock = lv_label_create(r.obj);
+    lv_label_set_text(r.lock, LV_SYMBOL_EYE_CLOSE);
+    lv_obj_set_style_text_color(r.lock, lv_color_hex(0x888888), 0);
+    lv_obj_align(r.lock, LV_ALIGN_LEFT_MID, 0, 0);
+
+    r.ssid = lv_label_create(r.obj);
+    lv_label_set_text(r.ssid, "");
+    lv_obj_set_style_text_color(r.ssid, lv_color_hex(COLOR_TEXT), 0);
+    lv_obj_set_style_text_font(r.ssid, &lv_font_montserrat_16, 0);
+    lv_label_set_long_mode(r.ssid, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(r.ssid, 250);
+    lv_obj_align(r.ssid, LV_ALIGN_LEFT_MID, 24, 0);
+
+    r.chan = lv_label_create(r.obj);
+    lv_label_set_text(r.chan, "");
+    lv_obj_set_style_text_color(r.chan, lv_color_hex(0x888888), 0);
+    lv_obj_set_style_text_font(r.chan, &lv_font_montserrat_12, 0);
+    lv_obj_align(r.chan, LV_ALIGN_RIGHT_MID, -110, 0);
+
+    r.rssi = lv_label_create(r.obj);
+    lv_label_set_text(r.rssi, "");
+    lv_obj_set_style_text_font(r.rssi, &lv_font_montserrat_14, 0);
+    lv_obj_align(r.rssi, LV_ALIGN_RIGHT_MID, -26, 0);
+
+    r.icon = lv_label_create(r.obj);
+    lv_label_set_text(r.icon, LV_SYMBOL_WIFI);
+    lv_obj_align(r.icon, LV_ALIGN_RIGHT_MID, 0, 0);
+
+    r.rev = 0;
+    return &r;
+}
 
-    // Clear previous results
-    lv_obj_clean(list_networks);
+// Shows entry 'net' in row 'r', skipped when the row already shows it
+static void bind_row(NetRow &r, const NetEntry &net)
+{
+    if (r.rev == net.rev && memcmp(r.bssid, net.bssid, 6) == 0) return;
+    memcpy(r.bssid, net.bssid, 6);
+    r.rev = net.rev;
+
+    lv_color_t color = net.missed ? lv_color_hex(0x555555) : get_signal_color(net.rssi);
+    uiSetHidden(r.lock, net.auth == WIFI_AUTH_OPEN);
+    uiSetText(r.ssid, net.ssid[0] ? net.ssid : "(Hidden)");
+    uiSetTextColor(r.ssid, lv_color_hex(net.missed ? 0x888888 : COLOR_TEXT));
+    uiSetTextFmt(r.chan, "ch %d", net.channel);
+    uiSetTextFmt(r.rssi, "%d dBm", net.rssi);
+    uiSetTextColor(r.rssi, color);
+    uiSetTextColor(r.icon, color);
+    uiSetHidden(r.obj, false);
+}
 
-    bsp_display_unlock();
+// Rebinds the rows to the table; rows already showing their entry are left alone
+static void update_list()
+{
+    int n = networks.size();
+    for (int i = 0; i < n; i++) {
+        NetRow *r = i < rowCount ? &rows[i] : create_row();
+        bind_row(*r, networks.at(i));
+    }
+    for (int i = n; i < rowCount; i++) {
+        rows[i].rev = 0;
+        uiSetHidden(rows[i].obj, true);
+    }
+}
 
+static void start_scan()
+{
+    // Async: returns at once, WiFi.scanComplete() polled from loop()
+    int16_t rc = analyzer ? WiFi.scanNetworks(true, true, false, ANALYZER_DWELL_MS)
+                          : WiFi.scanNetworks(true);
+    if (rc != WIFI_SCAN_RUNNING) {
+        bsp_display_lock(0);
+        uiSetText(label_status, "Echec du scan");
+        bsp_display_unlock();
+        lastScanEnd = millis();
+        return;
+    }
+    scanning = true;
+    scanStart = millis();
     Serial.println("Starting WiFi scan...");
-    int n = WiFi.scanNetworks();
-    Serial.printf("Scan complete: %d networks found\n", n);
 
+    if (analyzer) return;   // continuous: no spinner blinking every sample
     bsp_display_lock(0);
+    if (networks.size() == 0) uiSetText(label_status, "Scan en cours...");
+    uiSetHidden(spinner, false);
+    uiSetHidden(btn_scan, true);
+    bsp_display_unlock();
+}
 
-    // Hide spinner, show button
-    lv_obj_add_flag(spinner, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_clear_flag(btn_scan, LV_OBJ_FLAG_HIDDEN);
-
-    if (n == 0) {
-        lv_label_set_text(label_status, "Aucun reseau trouve");
-    } else {
-        char buf[32];
-        snprintf(buf, sizeof(buf), "%d reseaux trouves", n);
-        lv_label_set_text(label_status, buf);
+static void update_analyzer();
 
-        // Add networks to list
+static void finish_scan(int n)
+{
+    scanning = false;
+    lastScanEnd = millis();
+    int changes = 0;
+    if (n >= 0) {
+        changes = networks.merge(n);
+        history.beginSample(lastScanEnd);
         for (int i = 0; i < n; i++) {
-            String ssid = WiFi.SSID(i);
-            int rssi = WiFi.RSSI(i);
-            bool encrypted = WiFi.encryptionType(i) != WIFI_AUTH_OPEN;
-
-            // Create list button
-            lv_obj_t *btn = lv_list_add_btn(list_networks, NULL, "");
-            lv_obj_set_style_bg_color(btn, lv_color_hex(COLOR_CARD), 0);
-            lv_obj_set_style_bg_opa(btn, LV_OPA_COVER, 0);
-            lv_obj_set_style_pad_ver(btn, 8, 0);
-
-            // Container for content
-            lv_obj_t *cont = lv_obj_create(btn);
-            lv_obj_remove_style_all(cont);
-            lv_obj_set_size(cont, LV_PCT(100), LV_SIZE_CONTENT);
-            lv_obj_set_flex_flow(cont, LV_FLEX_FLOW_ROW);
-            lv_obj_set_flex_align(cont, LV_FLEX_ALIGN_SPACE_BETWEEN, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
-
-            // Left side: lock icon + SSID
-            lv_obj_t *left = lv_obj_create(cont);
-            lv_obj_remove_style_all(left);
-            lv_obj_set_size(left, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
-            lv_obj_set_flex_flow(left, LV_FLEX_FLOW_ROW);
-            lv_obj_set_style_pad_column(left, 8, 0);
-
-            if (encrypted) {
-                lv_obj_t *lock = lv_label_create(left);
-                lv_label_set_text(lock, LV_SYMBOL_EYE_CLOSE);
-                lv_obj_set_style_text_color(lock, lv_color_hex(0x888888), 0);
-            }
-
-            lv_obj_t *lbl_ssid = lv_label_create(left);
-            lv_label_set_text(lbl_ssid, ssid.isEmpty() ? "(Hidden)" : ssid.c_str());
-            lv_obj_set_style_text_color(lbl_ssid, lv_color_hex(COLOR_TEXT), 0);
-            lv_obj_set_style_text_font(lbl_ssid, &lv_font_montserrat_16, 0);
-            lv_label_set_long_mode(lbl_ssid, LV_LABEL_LONG_DOT);
-            lv_obj_set_width(lbl_ssid, 280);
-
-            // Right side: signal strength
-            lv_obj_t *right = lv_obj_create(cont);
-            lv_obj_remove_style_all(right);
-            lv_obj_set_size(right, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
-            lv_obj_set_flex_flow(right, LV_FLEX_FLOW_ROW);
-            lv_obj_set_style_pad_column(right, 5, 0);
-
-            char rssi_buf[16];
-            snprintf(rssi_buf, sizeof(rssi_buf), "%d dBm", rssi);
-            lv_obj_t *lbl_rssi = lv_label_create(right);
-            lv_label_set_text(lbl_rssi, rssi_buf);
-            lv_obj_set_style_text_color(lbl_rssi, get_signal_color(rssi), 0);
-            lv_obj_set_style_text_font(lbl_rssi, &lv_font_montserrat_14, 0);
-
-            lv_obj_t *lbl_wifi = lv_label_create(right);
-            lv_label_set_text(lbl_wifi, LV_SYMBOL_WIFI);
-            lv_obj_set_style_text_color(lbl_wifi, get_signal_color(rssi), 0);
+            const uint8_t *bssid = WiFi.BSSID(i);
+            if (bssid) history.add(bssid, WiFi.SSID(i).c_str(), WiFi.channel(i), WiFi.RSSI(i));
         }
+        history.endSample(&Serial);
     }
+    WiFi.scanDelete();
+    Serial.printf("Scan complete: %d networks found, %d changes (%lu ms)\n",
+                  n, changes, lastScanEnd - scanStart);
 
-    scanning = false;
+    bsp_display_lock(0);
+    uiSetHidden(spinner, true);
+    uiSetHidden(btn_scan, analyzer);
+    if (n < 0) {
+        uiSetText(label_status, "Echec du scan");
+    } else if (analyzer) {
+        uiSetTextFmt(label_status, "Analyse : %lu echantillons, %d AP",
+                     (unsigned long)history.sampleCount(), n);
+    } else if (networks.size() == 0) {
+        uiSetText(label_status, "Aucun reseau trouve");
+    } else {
+        uiSetTextFmt(label_status, "%d reseaux trouves", networks.size());
+    }
+    update_list();
+    if (n >= 0) update_analyzer();
     bsp_display_unlock();
+}
 
-    WiFi.scanDelete();
+// -95 dBm (dark blue) .. -35 dBm (red)
+static void build_palette()
+{
+    for (int i = 0; i < 64; i++) {
+        uint8_t h = 240 - i * 240 / 63;            // hue blue -> red
+        wf_palette[i] = lv_color_hsv_to_rgb(h, 100, 25 + i * 75 / 63);
+    }
 }
 
-// Button click callback
-static void btn_scan_cb(lv_event_t *e)
+static lv_color_t wf_color(int rssi)
 {
-    if (!scanning) {
-        do_scan();
+    if (rssi == HIST_NONE) return lv_color_hex(COLOR_BG);
+    int i = (rssi + 95) * 63 / 60;
+    return wf_palette[constrain(i, 0, 63)];
+}
+
+// New sample: chart values, waterfall scrolled down one row
+static void update_analyzer()
+{
+    uint8_t occ[HIST_CHANNELS];
+    history.occupancy(occ);
+    for (int c = 0; c < HIST_CHANNELS; c++) lv_chart_set_value_by_id(chart_occ, ser_occ, c, occ[c]);
+    lv_chart_refresh(chart_occ);
+
+    if (!wf_buf) return;
+    int8_t peak[HIST_CHANNELS];
+    history.channelPeak(peak);
+    memmove(wf_buf + WF_W * WF_ROW_H, wf_buf, WF_W * (WF_H - WF_ROW_H) * sizeof(lv_color_t));
+    lv_color_t *row = wf_buf;
+    for (int c = 0; c < HIST_CHANNELS; c++) {
+        lv_color_t col = wf_color(peak[c]);
+        for (int x = 0; x < WF_COL_W - 1; x++) row[c * WF_COL_W + x] = col;
+        row[c * WF_COL_W + WF_COL_W - 1] = lv_color_hex(COLOR_BG);
     }
+    for (int y = 1; y < WF_ROW_H; y++) memcpy(wf_buf + y * WF_W, row, WF_W * sizeof(lv_color_t));
+    lv_obj_invalidate(canvas_wf);
+}
+
+// Long press: whole RSSI history on Serial
+static void canvas_wf_cb(lv_event_t *e)
+{
+    history.print(Serial);
+}
+
+static void create_analyzer(lv_obj_t *parent)
+{
+    view_analyzer = lv_obj_create(parent);
+    lv_obj_set_size(view_analyzer, 460, 240);
+    lv_obj_align(view_analyzer, LV_ALIGN_BOTTOM_MID, 0, -10);
+    lv_obj_set_style_bg_color(view_analyzer, lv_color_hex(COLOR_BG), 0);
+    lv_obj_set_style_border_width(view_analyzer, 0, 0);
+    lv_obj_set_style_pad_all(view_analyzer, 0, 0);
+    lv_obj_clear_flag(view_analyzer, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(view_analyzer, LV_OBJ_FLAG_HIDDEN);
+
+    // Channel occupancy, one bar per channel above its waterfall column
+    chart_occ = lv_chart_create(view_analyzer);
+    lv_obj_set_size(chart_occ, WF_W, 95);
+    lv_obj_align(chart_occ, LV_ALIGN_TOP_MID, 0, 0);
+    lv_chart_set_type(chart_occ, LV_CHART_TYPE_BAR);
+    lv_chart_set_point_count(chart_occ, HIST_CHANNELS);
+    lv_chart_set_range(chart_occ, LV_CHART_AXIS_PRIMARY_Y, 0, 100);
+    lv_chart_set_div_line_count(chart_occ, 3, 0);
+    lv_obj_set_style_bg_color(chart_occ, lv_color_hex(COLOR_CARD), 0);
+    lv_obj_set_style_border_width(chart_occ, 0, 0);
+    lv_obj_set_style_line_color(chart_occ, lv_color_hex(0x333333), LV_PART_MAIN);
+    lv_obj_set_style_pad_all(chart_occ, 0, 0);
+    lv_obj_set_style_pad_column(chart_occ, 4, LV_PART_MAIN);
+    lv_obj_set_style_pad_column(chart_occ, 1, LV_PART_ITEMS);
+    ser_occ = lv_chart_add_series(chart_occ, lv_color_hex(COLOR_GOOD), LV_CHART_AXIS_PRIMARY_Y);
+    lv_chart_set_all_value(chart_occ, ser_occ, 0);
+
+    for (int c = 0; c < HIST_CHANNELS; c++) {
+        lv_obj_t *lbl = lv_label_create(view_analyzer);
+        lv_label_set_text_fmt(lbl, "%d", c + 1);
+        lv_obj_set_style_text_color(lbl, lv_color_hex(0x888888), 0);
+        lv_obj_set_style_text_font(lbl, &lv_font_montserrat_12, 0);
+        lv_obj_set_width(lbl, WF_COL_W);
+        lv_obj_set_style_text_align(lbl, LV_TEXT_ALIGN_CENTER, 0);
+        lv_obj_align(lbl, LV_ALIGN_TOP_LEFT, (460 - WF_W) / 2 + c * WF_COL_W, 97);
+    }
+
+    // Waterfall: newest sample on top, strongest RSSI per channel
+    wf_buf = (lv_color_t *)heap_caps_malloc(WF_W * WF_H * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+    if (!wf_buf) {
+        Serial.println("ERROR: waterfall buffer alloc failed");
+        return;
+    }
+    build_palette();
+    canvas_wf = lv_canvas_create(view_analyzer);
+    lv_canvas_set_buffer(canvas_wf, wf_buf, WF_W, WF_H, LV_IMG_CF_TRUE_COLOR);
+    lv_canvas_fill_bg(canvas_wf, lv_color_hex(COLOR_BG), LV_OPA_COVER);
+    lv_obj_align(canvas_wf, LV_ALIGN_TOP_MID, 0, 114);
+    lv_obj_add_flag(canvas_wf, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(canvas_wf, canvas_wf_cb, LV_EVENT_LONG_PRESSED, NULL);
+}
+
+static void set_mode(bool on)
+{
+    analyzer = on;
+    uiSetText(label_mode, on ? "LISTE" : "ANALYSE");
+    uiSetHidden(view_analyzer, !on);
+    uiSetHidden(list_networks, on);
+    uiSetHidden(btn_scan, on || scanning);
+    uiSetHidden(spinner, on || !scanning);
+    if (on) uiSetTextFmt(label_status, "Analyse : %lu echantillons", (unsigned long)history.sampleCount());
+}
+
+// Button click callbacks
+static void btn_scan_cb(lv_event_t *e)
+{
+    if (!scanning) scanRequested = true;
+}
+
+static void btn_mode_cb(lv_event_t *e)
+{
+    set_mode(!analyzer);
 }
 
 void setup()
@@ -217,6 +422,18 @@ void setup()
     lv_obj_set_style_text_color(btn_label, lv_color_hex(0x000000), 0);
     lv_obj_center(btn_label);
 
+    // Mode button: list / channel analyzer
+    btn_mode = lv_btn_create(lv_scr_act());
+    lv_obj_set_size(btn_mode, 100, 40);
+    lv_obj_align(btn_mode, LV_ALIGN_TOP_RIGHT, -120, 5);
+    lv_obj_set_style_bg_color(btn_mode, lv_color_hex(COLOR_CARD), 0);
+    lv_obj_add_event_cb(btn_mode, btn_mode_cb, LV_EVENT_CLICKED, NULL);
+
+    label_mode = lv_label_create(btn_mode);
+    lv_label_set_text(label_mode, "ANALYSE");
+    lv_obj_set_style_text_color(label_mode, lv_color_hex(COLOR_TEXT), 0);
+    lv_obj_center(label_mode);
+
     // Spinner (hidden by default)
     spinner = lv_spinner_create(lv_scr_act(), 1000, 60);
     lv_obj_set_size(spinner, 40, 40);
@@ -230,23 +447,37 @@ void setup()
     lv_obj_set_style_text_font(label_status, &lv_font_montserrat_14, 0);
     lv_obj_align(label_status, LV_ALIGN_TOP_LEFT, 15, 45);
 
-    // Network list
-    list_networks = lv_list_create(lv_scr_act());
+    // Network list (rows from the pool, see create_row)
+    list_networks = lv_obj_create(lv_scr_act());
     lv_obj_set_size(list_networks, 460, 240);
     lv_obj_align(list_networks, LV_ALIGN_BOTTOM_MID, 0, -10);
     lv_obj_set_style_bg_color(list_networks, lv_color_hex(COLOR_BG), 0);
     lv_obj_set_style_border_width(list_networks, 0, 0);
+    lv_obj_set_style_pad_all(list_networks, 0, 0);
     lv_obj_set_style_pad_row(list_networks, 5, 0);
+    lv_obj_set_flex_flow(list_networks, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_scroll_dir(list_networks, LV_DIR_VER);
+
+    create_analyzer(lv_scr_act());
 
     bsp_display_unlock();
 
     Serial.println("Setup complete!");
-
-    // Auto-scan on startup
-    do_scan();
 }
 
 void loop()
 {
+    // Start: on request (startup, button), every AUTO_SCAN_MS, or back to
+    // back in analyzer mode
+    if (!scanning && (scanRequested || analyzer || millis() - lastScanEnd >= AUTO_SCAN_MS)) {
+        scanRequested = false;
+        start_scan();
+    }
+
+    if (scanning) {
+        int n = WiFi.scanComplete();
+        if (n != WIFI_SCAN_RUNNING) finish_scan(n);
+    }
+
     delay(100);
 }
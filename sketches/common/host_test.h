@@ -0,0 +1,37 @@
+/*
+ * host_test.h - Minimal check macro for the PC-side tests (sketch/test/)
+ *
+ * CHECK() prints the failing line, condition and a printf-style message,
+ * counts the failure and carries on, so one run reports every problem.
+ * main() ends with `return hostTestEnd();`: prints "OK" or the failure
+ * count, returns the process exit code.
+ *
+ * Plain C/C++ standard library only. Tests add the common directory to
+ * their one-line build command, like the sketches' build_flags do:
+ *   g++ -std=c++11 -Wall -I.. -I../../../common foo_test.cpp -o /tmp/foo_test && /tmp/foo_test
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond, ...)                                  \
+  do {                                                    \
+    if (!(cond)) {                                        \
+      printf("ECHEC ligne %d : %s : ", __LINE__, #cond);  \
+      printf(__VA_ARGS__);                                \
+      printf("\n");                                       \
+      hostTestFailures++;                                 \
+    }                                                     \
+  } while (0)
+
+static inline int hostTestEnd() {
+  if (hostTestFailures) {
+    printf("%d echec(s)\n", hostTestFailures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
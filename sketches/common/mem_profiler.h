@@ -0,0 +1,468 @@
+/*
+ * mem_profiler.h - Heap fragmentation and per-task profiler (ESP32 + LVGL 8)
+ *
+ * MemProfiler samples, every call to sample():
+ *   - internal RAM and PSRAM: free, largest free block, minimum ever free,
+ *     fragmentation (100 - largest * 100 / free)
+ *   - every FreeRTOS task: stack high-water mark (bytes never used), core,
+ *     priority and CPU share since the previous sample, from the run-time
+ *     counters (percent of all cores, IDLE tasks included)
+ * A slow leak shows as a falling minimum; fragmentation as free memory
+ * that stays high while the largest block shrinks. Each live task keeps a
+ * MEMPROF_HISTORY ring of its CPU share (one byte per sample), and the
+ * smallest stack margin of all tasks is kept over the same window: ~1.7 KB.
+ *
+ * MemProfilerOverlay shows it on lv_layer_top(), above any app screen:
+ * free/largest-block history charts, CPU history of the busiest tasks
+ * (IDLE left out, ranked over the whole window), minimum stack margin
+ * history and a task table. The app creates it once (display lock held)
+ * and calls toggle() from any gesture it likes. Sampling continues while
+ * hidden so the history is there when opened.
+ *
+ * Use: add -I${PROJECT_DIR}/../../common to build_flags, then
+ *   #include "mem_profiler.h"
+ *   static MemProfilerOverlay profiler;
+ *   profiler.begin();   // after the display is started
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define MEMPROF_HISTORY    60      // chart points (one per sample)
+#define MEMPROF_MAX_TASKS  24
+#define MEMPROF_PERIOD_MS  1000
+#define MEMPROF_CHART_TASKS 4      // tasks on the CPU history chart
+#define MEMPROF_NO_STACK   UINT32_MAX
+
+struct MemHeapStats {
+    uint32_t total;
+    uint32_t free;
+    uint32_t largest;
+    uint32_t minFree;
+    uint8_t fragPct;
+};
+
+struct MemTaskStats {
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t stackFree;     // high-water mark, bytes
+    uint8_t cpuPct;
+    int8_t core;            // -1: no affinity
+    uint8_t prio;
+    uint8_t slot;           // row of MemProfiler::cpuHist
+};
+
+class MemProfiler {
+public:
+    MemHeapStats internal = {};
+    MemHeapStats psram = {};
+    MemTaskStats tasks[MEMPROF_MAX_TASKS];
+    int taskCount = 0;
+    bool cpuValid = false;  // false until two samples (or without run-time stats)
+
+    // Rings of the last histLen samples, newest at histHead: CPU share per
+    // task slot (0 before the task existed) and smallest stack margin of
+    // all tasks (MEMPROF_NO_STACK: task list not read)
+    uint8_t cpuHist[MEMPROF_MAX_TASKS][MEMPROF_HISTORY] = {};
+    uint32_t stackMinHist[MEMPROF_HISTORY] = {};
+    char stackMinName[configMAX_TASK_NAME_LEN] = "";
+    int histHead = MEMPROF_HISTORY - 1;
+    int histLen = 0;
+
+    // Ring index of the k-th point, oldest first; -1 before the first sample
+    int histAt(int k) const
+    {
+        int age = MEMPROF_HISTORY - 1 - k;
+        return age < histLen ? (histHead - age + MEMPROF_HISTORY) % MEMPROF_HISTORY : -1;
+    }
+
+    uint32_t cpuSum(int slot) const
+    {
+        uint32_t sum = 0;
+        for (int i = 0; i < MEMPROF_HISTORY; i++) sum += cpuHist[slot][i];
+        return sum;
+    }
+
+    void sample()
+    {
+        heap(internal, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        heap(psram, MALLOC_CAP_SPIRAM);
+        histHead = (histHead + 1) % MEMPROF_HISTORY;
+        if (histLen < MEMPROF_HISTORY) histLen++;
+        stackMinHist[histHead] = MEMPROF_NO_STACK;
+        taskSample();
+    }
+
+    // One line per sample, for logs over hours: "mem,int_free,int_largest,..."
+    void print(Print &out) const
+    {
+        out.printf("mem,%lu,%lu,%lu,%u,%lu,%lu,%lu,%u\n",
+                   (unsigned long)internal.free, (unsigned long)internal.largest,
+                   (unsigned long)internal.minFree, internal.fragPct,
+                   (unsigned long)psram.free, (unsigned long)psram.largest,
+                   (unsigned long)psram.minFree, psram.fragPct);
+    }
+
+private:
+    static void heap(MemHeapStats &h, uint32_t caps)
+    {
+        h.total = heap_caps_get_total_size(caps);
+        h.free = heap_caps_get_free_size(caps);
+        h.largest = heap_caps_get_largest_free_block(caps);
+        h.minFree = heap_caps_get_minimum_free_size(caps);
+        h.fragPct = h.free ? 100 - (uint8_t)((uint64_t)h.largest * 100 / h.free) : 0;
+    }
+
+#if configUSE_TRACE_FACILITY
+    void taskSample()
+    {
+        uint32_t totalRun = 0;
+        // Returns 0 when there are more than MEMPROF_MAX_TASKS tasks
+        UBaseType_t n = uxTaskGetSystemState(status, MEMPROF_MAX_TASKS, &totalRun);
+
+        // Run-time deltas against the previous sample, matched by task number
+        uint32_t delta[MEMPROF_MAX_TASKS];
+        uint64_t sum = 0;
+        for (UBaseType_t i = 0; i < n; i++) {
+            delta[i] = 0;
+#if configGENERATE_RUN_TIME_STATS
+            for (int j = 0; j < prevCount; j++) {
+                if (prevNum[j] == status[i].xTaskNumber) {
+                    delta[i] = status[i].ulRunTimeCounter - prevRun[j];
+                    break;
+                }
+            }
+            sum += delta[i];
+#endif
+        }
+
+        // History slots: kept per task number, freed when the task is gone
+        bool seen[MEMPROF_MAX_TASKS] = {};
+        uint8_t slotOf[MEMPROF_MAX_TASKS];
+        for (UBaseType_t i = 0; i < n; i++) {
+            int s = 0;
+            while (s < MEMPROF_MAX_TASKS && !(slotUsed[s] && slotNum[s] == status[i].xTaskNumber)) s++;
+            if (s == MEMPROF_MAX_TASKS) s = -1;
+            slotOf[i] = s < 0 ? MEMPROF_MAX_TASKS : s;
+            if (s >= 0) seen[s] = true;
+        }
+        for (int s = 0; s < MEMPROF_MAX_TASKS; s++) {
+            if (n && !seen[s]) slotUsed[s] = false;
+        }
+        for (UBaseType_t i = 0; i < n; i++) {
+            if (slotOf[i] < MEMPROF_MAX_TASKS) continue;
+            int s = 0;
+            while (slotUsed[s]) s++;    // n <= MEMPROF_MAX_TASKS: always found
+            slotUsed[s] = true;
+            slotNum[s] = status[i].xTaskNumber;
+            memset(cpuHist[s], 0, MEMPROF_HISTORY);
+            slotOf[i] = s;
+        }
+        for (int s = 0; s < MEMPROF_MAX_TASKS; s++) cpuHist[s][histHead] = 0;
+
+        // Sorted by CPU share, then by stack margin
+        taskCount = 0;
+        for (UBaseType_t i = 0; i < n; i++) {
+            MemTaskStats t;
+            strlcpy(t.name, status[i].pcTaskName, sizeof(t.name));
+            t.stackFree = status[i].usStackHighWaterMark * sizeof(StackType_t);
+            t.cpuPct = sum ? (uint8_t)((uint64_t)delta[i] * 100 / sum) : 0;
+#if configTASKLIST_INCLUDE_COREID
+            t.core = status[i].xCoreID == tskNO_AFFINITY ? -1 : (int8_t)status[i].xCoreID;
+#else
+            t.core = -1;
+#endif
+            t.prio = status[i].uxCurrentPriority;
+            t.slot = slotOf[i];
+            cpuHist[t.slot][histHead] = t.cpuPct;
+            if (t.stackFree < stackMinHist[histHead]) {
+                stackMinHist[histHead] = t.stackFree;
+                strlcpy(stackMinName, t.name, sizeof(stackMinName));
+            }
+            int k = taskCount++;
+            while (k > 0 && (tasks[k - 1].cpuPct < t.cpuPct ||
+                             (tasks[k - 1].cpuPct == t.cpuPct && tasks[k - 1].stackFree > t.stackFree))) {
+                tasks[k] = tasks[k - 1];
+                k--;
+            }
+            tasks[k] = t;
+        }
+
+#if configGENERATE_RUN_TIME_STATS
+        cpuValid = prevCount > 0 && sum > 0;
+        prevCount = n;
+        for (UBaseType_t i = 0; i < n; i++) {
+            prevNum[i] = status[i].xTaskNumber;
+            prevRun[i] = status[i].ulRunTimeCounter;
+        }
+#endif
+    }
+
+    TaskStatus_t status[MEMPROF_MAX_TASKS];
+    UBaseType_t slotNum[MEMPROF_MAX_TASKS];
+    bool slotUsed[MEMPROF_MAX_TASKS] = {};
+    UBaseType_t prevNum[MEMPROF_MAX_TASKS];
+    uint32_t prevRun[MEMPROF_MAX_TASKS];
+    int prevCount = 0;
+#else
+    void taskSample() { taskCount = 0; }   // FreeRTOS built without trace facility
+#endif
+};
+
+class MemProfilerOverlay {
+public:
+    MemProfiler prof;
+
+    // Display lock held
+    void begin()
+    {
+        if (panel) return;
+        lv_coord_t w = lv_disp_get_hor_res(NULL);
+        lv_coord_t h = lv_disp_get_ver_res(NULL);
+
+        panel = lv_obj_create(lv_layer_top());
+        lv_obj_set_size(panel, w, h);
+        lv_obj_set_style_bg_color(panel, lv_color_hex(0x0d0d1a), 0);
+        lv_obj_set_style_bg_opa(panel, LV_OPA_90, 0);
+        lv_obj_set_style_border_width(panel, 0, 0);
+        lv_obj_set_style_radius(panel, 0, 0);
+        lv_obj_set_style_pad_all(panel, 6, 0);
+        lv_obj_set_style_text_color(panel, lv_color_hex(0xffffff), 0);
+        lv_obj_set_style_text_font(panel, &lv_font_montserrat_12, 0);
+        lv_obj_add_flag(panel, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_add_event_cb(panel, closeCb, LV_EVENT_LONG_PRESSED, this);
+
+        // 2 x 2 history charts (heaps, then task CPU and stack margin),
+        // task table below
+        lv_coord_t chartW = (w - 18) / 2;
+        lv_coord_t chartH = h / 5;
+        lv_coord_t rowH = chartH + 48;
+        makeHeap(0, "RAM interne", lv_color_hex(0x4cc9f0), 0, chartW, chartH);
+        makeHeap(1, "PSRAM", lv_color_hex(0xf72585), chartW + 6, chartW, chartH);
+
+        cpuChart = makeChart("CPU par tache", lv_color_hex(0xffffff), 0, rowH, chartW, chartH);
+        lv_chart_set_range(cpuChart, LV_CHART_AXIS_PRIMARY_Y, 0, 100);
+        for (int i = 0; i < MEMPROF_CHART_TASKS; i++) {
+            cpuSeries[i] = lv_chart_add_series(cpuChart, lv_color_hex(taskColor(i)), LV_CHART_AXIS_PRIMARY_Y);
+        }
+        cpuLabel = lv_label_create(panel);
+        lv_label_set_recolor(cpuLabel, true);
+        lv_label_set_long_mode(cpuLabel, LV_LABEL_LONG_CLIP);
+        lv_obj_set_pos(cpuLabel, 0, rowH + chartH + 20);
+        lv_obj_set_size(cpuLabel, chartW, 28);
+        lv_label_set_text(cpuLabel, "");
+
+        stackChart = makeChart("Pile libre min.", lv_color_hex(0x80ed99), chartW + 6, rowH, chartW, chartH);
+        stackSeries = lv_chart_add_series(stackChart, lv_color_hex(0x80ed99), LV_CHART_AXIS_PRIMARY_Y);
+        stackLabel = lv_label_create(panel);
+        lv_obj_set_pos(stackLabel, chartW + 6, rowH + chartH + 20);
+        lv_label_set_text(stackLabel, "");
+
+        table = lv_table_create(panel);
+        lv_obj_set_pos(table, 0, 2 * rowH);
+        lv_obj_set_size(table, w - 12, h - 2 * rowH - 12);
+        lv_obj_set_style_pad_all(table, 2, LV_PART_ITEMS);
+        lv_obj_set_style_bg_opa(table, LV_OPA_TRANSP, 0);
+        lv_obj_set_style_bg_opa(table, LV_OPA_TRANSP, LV_PART_ITEMS);
+        lv_obj_set_style_border_width(table, 0, LV_PART_ITEMS);
+        lv_obj_set_style_text_color(table, lv_color_hex(0xffffff), LV_PART_ITEMS);
+        lv_table_set_col_cnt(table, 5);
+        lv_coord_t colW = (w - 24) / 8;
+        lv_table_set_col_width(table, 0, colW * 3);
+        for (int c = 1; c < 5; c++) lv_table_set_col_width(table, c, colW * 5 / 4);
+        static const char *head[] = {"Tache", "Coeur", "Prio", "Pile libre", "CPU"};
+        for (int c = 0; c < 5; c++) lv_table_set_cell_value(table, 0, c, head[c]);
+
+        timer = lv_timer_create(timerCb, MEMPROF_PERIOD_MS, this);
+        sampleNow();
+    }
+
+    void show() { if (panel) { lv_obj_clear_flag(panel, LV_OBJ_FLAG_HIDDEN); refresh(); } }
+    void hide() { if (panel) lv_obj_add_flag(panel, LV_OBJ_FLAG_HIDDEN); }
+    bool visible() const { return panel && !lv_obj_has_flag(panel, LV_OBJ_FLAG_HIDDEN); }
+    void toggle() { visible() ? hide() : show(); }
+
+    // Event callback for the app: attach to any object with
+    // LV_EVENT_LONG_PRESSED (user data: the overlay)
+    static void toggleCb(lv_event_t *e) { ((MemProfilerOverlay *)lv_event_get_user_data(e))->toggle(); }
+
+private:
+    struct HeapView {
+        lv_obj_t *chart;
+        lv_chart_series_t *free;
+        lv_chart_series_t *largest;
+        lv_obj_t *label;
+    };
+
+    // Title + line chart of MEMPROF_HISTORY points at (x, y)
+    lv_obj_t *makeChart(const char *title, lv_color_t color, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h)
+    {
+        lv_obj_t *t = lv_label_create(panel);
+        lv_label_set_text(t, title);
+        lv_obj_set_style_text_color(t, color, 0);
+        lv_obj_set_pos(t, x, y);
+
+        lv_obj_t *chart = lv_chart_create(panel);
+        lv_obj_set_pos(chart, x, y + 16);
+        lv_obj_set_size(chart, w, h);
+        lv_chart_set_type(chart, LV_CHART_TYPE_LINE);
+        lv_chart_set_point_count(chart, MEMPROF_HISTORY);
+        lv_chart_set_update_mode(chart, LV_CHART_UPDATE_MODE_SHIFT);
+        lv_chart_set_div_line_count(chart, 3, 0);
+        lv_obj_set_style_bg_color(chart, lv_color_hex(0x16213e), 0);
+        lv_obj_set_style_border_width(chart, 0, 0);
+        lv_obj_set_style_pad_all(chart, 2, 0);
+        lv_obj_set_style_size(chart, 0, LV_PART_INDICATOR);   // no point markers
+        return chart;
+    }
+
+    void makeHeap(int i, const char *title, lv_color_t color, lv_coord_t x, lv_coord_t w, lv_coord_t h)
+    {
+        HeapView &v = heaps[i];
+        v.chart = makeChart(title, color, x, 0, w, h);
+        v.free = lv_chart_add_series(v.chart, color, LV_CHART_AXIS_PRIMARY_Y);
+        v.largest = lv_chart_add_series(v.chart, lv_color_hex(0xfca311), LV_CHART_AXIS_PRIMARY_Y);
+
+        v.label = lv_label_create(panel);
+        lv_obj_set_pos(v.label, x, h + 20);
+        lv_label_set_text(v.label, "");
+    }
+
+    // Copies a profiler ring into a chart series, oldest point first
+    template <class T, class F>
+    void fillSeries(lv_obj_t *chart, lv_chart_series_t *ser, const T *ring, F value)
+    {
+        lv_coord_t *ys = lv_chart_get_y_array(chart, ser);
+        for (int k = 0; k < MEMPROF_HISTORY; k++) {
+            int i = prof.histAt(k);
+            ys[k] = i < 0 ? LV_CHART_POINT_NONE : value(ring[i]);
+        }
+        lv_chart_set_x_start_point(chart, ser, 0);
+    }
+
+    // Busiest tasks over the whole window (IDLE is the remainder), and the
+    // smallest stack margin of all tasks
+    void refreshTasks()
+    {
+        const MemTaskStats *top[MEMPROF_CHART_TASKS];
+        uint32_t topSum[MEMPROF_CHART_TASKS];
+        int nTop = 0;
+        for (int r = 0; r < prof.taskCount; r++) {
+            const MemTaskStats &t = prof.tasks[r];
+            if (!strncmp(t.name, "IDLE", 4)) continue;
+            uint32_t sum = prof.cpuSum(t.slot);
+            int k = nTop < MEMPROF_CHART_TASKS ? nTop++ : MEMPROF_CHART_TASKS;
+            while (k > 0 && topSum[k - 1] < sum) {
+                if (k < MEMPROF_CHART_TASKS) {
+                    top[k] = top[k - 1];
+                    topSum[k] = topSum[k - 1];
+                }
+                k--;
+            }
+            if (k < MEMPROF_CHART_TASKS) {
+                top[k] = &t;
+                topSum[k] = sum;
+            }
+        }
+
+        char legend[MEMPROF_CHART_TASKS * (configMAX_TASK_NAME_LEN + 16)];
+        int len = 0;
+        for (int i = 0; i < MEMPROF_CHART_TASKS; i++) {
+            if (i < nTop) {
+                fillSeries(cpuChart, cpuSeries[i], prof.cpuHist[top[i]->slot],
+                           [](uint8_t v) { return (lv_coord_t)v; });
+                len += snprintf(legend + len, sizeof(legend) - len, "%s#%06lx %s %u%%#", i ? " " : "",
+                                (unsigned long)taskColor(i), top[i]->name, top[i]->cpuPct);
+            } else {
+                lv_chart_set_all_value(cpuChart, cpuSeries[i], LV_CHART_POINT_NONE);
+            }
+            if (len >= (int)sizeof(legend)) len = sizeof(legend) - 1;
+        }
+        lv_label_set_text(cpuLabel, nTop ? legend : "-");
+        lv_chart_refresh(cpuChart);
+
+        // Range: 0 .. highest point of the window, by 256 bytes. Chart
+        // values stop below LV_CHART_POINT_NONE (LV_COORD_MAX); the label
+        // keeps the exact margin.
+        const uint32_t top256 = (LV_COORD_MAX - 1) / 256 * 256;
+        uint32_t hi = 256;
+        for (int k = 0; k < MEMPROF_HISTORY; k++) {
+            int i = prof.histAt(k);
+            if (i >= 0 && prof.stackMinHist[i] != MEMPROF_NO_STACK && prof.stackMinHist[i] > hi) hi = prof.stackMinHist[i];
+        }
+        hi = (hi + 255) / 256 * 256;
+        lv_chart_set_range(stackChart, LV_CHART_AXIS_PRIMARY_Y, 0, hi > top256 ? top256 : hi);
+        fillSeries(stackChart, stackSeries, prof.stackMinHist, [top256](uint32_t v) {
+            return v == MEMPROF_NO_STACK ? LV_CHART_POINT_NONE : (lv_coord_t)(v > top256 ? top256 : v);
+        });
+        lv_chart_refresh(stackChart);
+        uint32_t last = prof.stackMinHist[prof.histHead];
+        if (last == MEMPROF_NO_STACK) lv_label_set_text(stackLabel, "-");
+        else lv_label_set_text_fmt(stackLabel, "%lu o (%s)", (unsigned long)last, prof.stackMinName);
+    }
+
+    static void timerCb(lv_timer_t *t) { ((MemProfilerOverlay *)t->user_data)->sampleNow(); }
+
+    static void closeCb(lv_event_t *e) { ((MemProfilerOverlay *)lv_event_get_user_data(e))->hide(); }
+
+    void sampleNow()
+    {
+        prof.sample();
+        const MemHeapStats *hs[2] = {&prof.internal, &prof.psram};
+        for (int i = 0; i < 2; i++) {
+            HeapView &v = heaps[i];
+            // Free (colour) and largest block (orange), KB, scaled on total
+            lv_chart_set_range(v.chart, LV_CHART_AXIS_PRIMARY_Y, 0, hs[i]->total / 1024);
+            lv_chart_set_next_value(v.chart, v.free, hs[i]->free / 1024);
+            lv_chart_set_next_value(v.chart, v.largest, hs[i]->largest / 1024);
+        }
+        if (visible()) refresh();
+    }
+
+    void refresh()
+    {
+        const MemHeapStats *hs[2] = {&prof.internal, &prof.psram};
+        char buf[64];
+        for (int i = 0; i < 2; i++) {
+            snprintf(buf, sizeof(buf), "libre %lu K  bloc %lu K\nmin %lu K  frag %u%%",
+                     (unsigned long)(hs[i]->free / 1024), (unsigned long)(hs[i]->largest / 1024),
+                     (unsigned long)(hs[i]->minFree / 1024), hs[i]->fragPct);
+            lv_label_set_text(heaps[i].label, buf);
+            lv_chart_refresh(heaps[i].chart);
+        }
+
+        lv_table_set_row_cnt(table, prof.taskCount + 1);
+        for (int r = 0; r < prof.taskCount; r++) {
+            const MemTaskStats &t = prof.tasks[r];
+            lv_table_set_cell_value(table, r + 1, 0, t.name);
+            if (t.core < 0) lv_table_set_cell_value(table, r + 1, 1, "-");
+            else lv_table_set_cell_value_fmt(table, r + 1, 1, "%d", t.core);
+            lv_table_set_cell_value_fmt(table, r + 1, 2, "%u", t.prio);
+            lv_table_set_cell_value_fmt(table, r + 1, 3, "%lu", (unsigned long)t.stackFree);
+            if (prof.cpuValid) lv_table_set_cell_value_fmt(table, r + 1, 4, "%u%%", t.cpuPct);
+            else lv_table_set_cell_value(table, r + 1, 4, "-");
+        }
+        refreshTasks();
+    }
+
+    static uint32_t taskColor(int i)
+    {
+        static const uint32_t colors[MEMPROF_CHART_TASKS] = {0x4cc9f0, 0xf72585, 0xfca311, 0xb5e48c};
+        return colors[i];
+    }
+
+    lv_obj_t *panel = nullptr;
+    lv_obj_t *table = nullptr;
+    lv_timer_t *timer = nullptr;
+    HeapView heaps[2] = {};
+    lv_obj_t *cpuChart = nullptr;
+    lv_chart_series_t *cpuSeries[MEMPROF_CHART_TASKS] = {};
+    lv_obj_t *cpuLabel = nullptr;
+    lv_obj_t *stackChart = nullptr;
+    lv_chart_series_t *stackSeries = nullptr;
+    lv_obj_t *stackLabel = nullptr;
+};
@@ -0,0 +1,198 @@
+/*
+ * perf_overlay.h - Optional LVGL 8 performance overlay (ESP32)
+ *
+ * FPS, render and flush time per frame, LVGL heap, free internal RAM and
+ * PSRAM, last HTTP fetch latency, in a small box on lv_layer_top().
+ *
+ * Compiled in only with -DPERF_OVERLAY=1 in build_flags. Without it every
+ * perf*() call below is an empty inline function: nothing is hooked,
+ * allocated or linked.
+ *
+ * perfOverlayBegin() hooks the default display driver (flush_cb timed,
+ * monitor_cb counts frames and their refresh time) and the pointer input
+ * driver: holding a press PERF_TOGGLE_MS anywhere shows/hides the box.
+ * Call it once after the display and touch drivers are registered, with
+ * the LVGL lock held when the app has one. Both flush paths in this repo
+ * call lv_disp_flush_ready() before returning, so the time spent in
+ * flush_cb is the whole transfer.
+ *
+ * Use: add -I${PROJECT_DIR}/../../common to build_flags, then
+ *   #include "perf_overlay.h"
+ *   perfOverlayBegin();
+ *   perfFetchBegin(); ... int code = https.GET(); perfFetchEnd(code);
+ */
+
+#pragma once
+
+#include <lvgl.h>
+
+#ifndef PERF_OVERLAY
+#define PERF_OVERLAY 0
+#endif
+
+#if PERF_OVERLAY
+
+#include <Arduino.h>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+#define PERF_TOGGLE_MS   2000
+#define PERF_PERIOD_MS   1000
+
+static struct {
+    lv_obj_t *box;
+    void (*flush)(lv_disp_drv_t *, const lv_area_t *, lv_color_t *);
+    void (*monitor)(lv_disp_drv_t *, uint32_t, uint32_t);
+    void (*read)(lv_indev_drv_t *, lv_indev_data_t *);
+
+    // Current window (reset every PERF_PERIOD_MS)
+    uint32_t frames;
+    uint32_t refreshMs;
+    uint64_t flushUs;
+    uint64_t frameFlushUs;    // flushes of the frame being drawn
+    uint32_t windowStart;
+
+    uint32_t pressStart;
+    bool toggled;
+
+    volatile uint32_t fetchStart;
+    volatile uint32_t fetchMs;
+    volatile uint32_t fetchAt;
+    volatile int fetchCode;
+} perfState;
+
+static void perfFlushHook(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *px)
+{
+    int64_t t0 = esp_timer_get_time();
+    perfState.flush(drv, area, px);
+    perfState.frameFlushUs += esp_timer_get_time() - t0;
+}
+
+static void perfMonitorHook(lv_disp_drv_t *drv, uint32_t timeMs, uint32_t px)
+{
+    perfState.frames++;
+    perfState.refreshMs += timeMs;
+    perfState.flushUs += perfState.frameFlushUs;
+    perfState.frameFlushUs = 0;
+    if (perfState.monitor) perfState.monitor(drv, timeMs, px);
+}
+
+static void perfOverlayToggle()
+{
+    if (!perfState.box) return;
+    if (lv_obj_has_flag(perfState.box, LV_OBJ_FLAG_HIDDEN)) lv_obj_clear_flag(perfState.box, LV_OBJ_FLAG_HIDDEN);
+    else lv_obj_add_flag(perfState.box, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void perfToggleAsync(void *) { perfOverlayToggle(); }
+
+static void perfReadHook(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    perfState.read(drv, data);
+    if (data->state != LV_INDEV_STATE_PRESSED) {
+        perfState.pressStart = 0;
+        perfState.toggled = false;
+    } else if (!perfState.pressStart) {
+        perfState.pressStart = millis() | 1;
+    } else if (!perfState.toggled && millis() - perfState.pressStart >= PERF_TOGGLE_MS) {
+        perfState.toggled = true;
+        lv_async_call(perfToggleAsync, NULL);   // not from inside the input read
+    }
+}
+
+static void perfTimerCb(lv_timer_t *t)
+{
+    uint32_t now = millis();
+    uint32_t window = now - perfState.windowStart;
+    uint32_t frames = perfState.frames;
+    if (!lv_obj_has_flag(perfState.box, LV_OBJ_FLAG_HIDDEN) && window) {
+        float fps = frames * 1000.0f / window;
+        float flushMs = frames ? perfState.flushUs / 1000.0f / frames : 0;
+        float renderMs = frames ? perfState.refreshMs / (float)frames - flushMs : 0;
+        if (renderMs < 0) renderMs = 0;
+
+        char lvgl[40];
+#if LV_MEM_CUSTOM == 0
+        lv_mem_monitor_t mon;
+        lv_mem_monitor(&mon);
+        snprintf(lvgl, sizeof(lvgl), "LVGL %lu/%lu KB frag %u%%",
+                 (unsigned long)((mon.total_size - mon.free_size) / 1024),
+                 (unsigned long)(mon.total_size / 1024), mon.frag_pct);
+#else
+        snprintf(lvgl, sizeof(lvgl), "LVGL: malloc systeme");
+#endif
+        char fetch[40];
+        if (perfState.fetchAt) {
+            snprintf(fetch, sizeof(fetch), "HTTP %lu ms (%d) il y a %lus", (unsigned long)perfState.fetchMs,
+                     perfState.fetchCode, (unsigned long)((now - perfState.fetchAt) / 1000));
+        } else {
+            snprintf(fetch, sizeof(fetch), "HTTP --");
+        }
+
+        char text[200];
+        snprintf(text, sizeof(text), "%.1f FPS  rendu %.1f ms  flush %.1f ms\n%s\nRAM %lu KB (bloc %lu)  PSRAM %lu KB\n%s",
+                 fps, renderMs, flushMs, lvgl,
+                 (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024),
+                 (unsigned long)(heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL) / 1024),
+                 (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_SPIRAM) / 1024), fetch);
+        lv_label_set_text(perfState.box, text);
+    }
+    perfState.frames = 0;
+    perfState.refreshMs = 0;
+    perfState.flushUs = 0;
+    perfState.windowStart = now;
+}
+
+static inline void perfOverlayBegin()
+{
+    if (perfState.box) return;
+
+    lv_disp_t *disp = lv_disp_get_default();
+    if (disp) {
+        perfState.flush = disp->driver->flush_cb;
+        perfState.monitor = disp->driver->monitor_cb;
+        disp->driver->flush_cb = perfFlushHook;
+        disp->driver->monitor_cb = perfMonitorHook;
+    }
+    for (lv_indev_t *in = lv_indev_get_next(NULL); in; in = lv_indev_get_next(in)) {
+        if (lv_indev_get_type(in) == LV_INDEV_TYPE_POINTER && in->driver->read_cb) {
+            perfState.read = in->driver->read_cb;
+            in->driver->read_cb = perfReadHook;
+            break;
+        }
+    }
+
+    lv_obj_t *box = lv_label_create(lv_layer_top());
+    lv_obj_set_style_bg_color(box, lv_color_hex(0x000000), 0);
+    lv_obj_set_style_bg_opa(box, LV_OPA_70, 0);
+    lv_obj_set_style_text_color(box, lv_color_hex(0x00ff88), 0);
+    lv_obj_set_style_text_font(box, &lv_font_montserrat_12, 0);
+    lv_obj_set_style_pad_all(box, 4, 0);
+    lv_obj_align(box, LV_ALIGN_TOP_LEFT, 0, 0);
+    lv_label_set_text(box, "");
+    lv_obj_add_flag(box, LV_OBJ_FLAG_HIDDEN);
+    perfState.box = box;
+    perfState.windowStart = millis();
+    lv_timer_create(perfTimerCb, PERF_PERIOD_MS, NULL);
+}
+
+static inline void perfFetchBegin()
+{
+    perfState.fetchStart = millis();
+}
+
+static inline void perfFetchEnd(int code)
+{
+    perfState.fetchMs = millis() - perfState.fetchStart;
+    perfState.fetchCode = code;
+    perfState.fetchAt = millis() | 1;
+}
+
+#else
+
+static inline void perfOverlayBegin() {}
+static inline void perfOverlayToggle() {}
+static inline void perfFetchBegin() {}
+static inline void perfFetchEnd(int) {}
+
+#endif
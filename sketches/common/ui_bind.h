@@ -0,0 +1,120 @@
+/*
+ * ui_bind.h - Change-only widget updates for LVGL 8 dashboards
+ *
+ * lv_label_set_text(), the style setters and the HIDDEN flag setters
+ * invalidate their widget on every call, even when nothing changed. On a
+ * display driver with full_refresh = 1 (JC3248W535C) one such call is a
+ * whole-screen redraw. The uiSet*() helpers below compare with the value
+ * the widget already holds (the widget is its own cache, no extra memory)
+ * and only call LVGL when it differs.
+ *
+ * uiRedrawCounterBegin() hooks the display driver's monitor_cb (chaining
+ * any previous one) to count the frames actually redrawn. uiBindPrint()
+ * writes one CSV line:
+ *   ui,<writes>,<skipped>,<frames>,<kpx>
+ * Build with -DUI_BIND_ALWAYS=1 to make every helper write unconditionally
+ * (the behaviour before this layer) and compare the two lines.
+ *
+ * Call everything with the LVGL lock held when the app has one.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <stdarg.h>
+
+#ifndef UI_BIND_ALWAYS
+#define UI_BIND_ALWAYS 0
+#endif
+
+#define UI_TEXT_MAX  128   // uiSetTextFmt() output, truncated beyond
+
+static struct {
+    uint32_t writes;
+    uint32_t skipped;
+    uint32_t frames;
+    uint64_t px;
+    void (*monitor)(lv_disp_drv_t *, uint32_t, uint32_t);
+} uiBindStats;
+
+static inline bool uiBindChanged(bool changed)
+{
+    if (changed || UI_BIND_ALWAYS) {
+        uiBindStats.writes++;
+        return true;
+    }
+    uiBindStats.skipped++;
+    return false;
+}
+
+// Each helper returns true when the widget was actually touched
+static inline bool uiSetText(lv_obj_t *label, const char *text)
+{
+    if (!uiBindChanged(strcmp(lv_label_get_text(label), text) != 0)) return false;
+    lv_label_set_text(label, text);
+    return true;
+}
+
+static inline bool uiSetTextFmt(lv_obj_t *label, const char *fmt, ...)
+{
+    char buf[UI_TEXT_MAX];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return uiSetText(label, buf);
+}
+
+static inline bool uiSetArc(lv_obj_t *arc, int16_t value)
+{
+    if (!uiBindChanged(lv_arc_get_value(arc) != value)) return false;
+    lv_arc_set_value(arc, value);
+    return true;
+}
+
+static inline bool uiSetTextColor(lv_obj_t *obj, lv_color_t color)
+{
+    lv_color_t cur = lv_obj_get_style_text_color(obj, LV_PART_MAIN);
+    if (!uiBindChanged(cur.full != color.full)) return false;
+    lv_obj_set_style_text_color(obj, color, 0);
+    return true;
+}
+
+static inline bool uiSetBgColor(lv_obj_t *obj, lv_color_t color)
+{
+    lv_color_t cur = lv_obj_get_style_bg_color(obj, LV_PART_MAIN);
+    if (!uiBindChanged(cur.full != color.full)) return false;
+    lv_obj_set_style_bg_color(obj, color, 0);
+    return true;
+}
+
+static inline bool uiSetHidden(lv_obj_t *obj, bool hidden)
+{
+    if (!uiBindChanged(lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN) != hidden)) return false;
+    if (hidden) lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    else lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    return true;
+}
+
+static void uiBindMonitor(lv_disp_drv_t *drv, uint32_t timeMs, uint32_t px)
+{
+    uiBindStats.frames++;
+    uiBindStats.px += px;
+    if (uiBindStats.monitor) uiBindStats.monitor(drv, timeMs, px);
+}
+
+static inline void uiRedrawCounterBegin()
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    if (!disp || disp->driver->monitor_cb == uiBindMonitor) return;
+    uiBindStats.monitor = disp->driver->monitor_cb;
+    disp->driver->monitor_cb = uiBindMonitor;
+}
+
+static inline void uiBindPrint(Print &out)
+{
+    out.printf("ui,%lu,%lu,%lu,%lu\n", (unsigned long)uiBindStats.writes,
+               (unsigned long)uiBindStats.skipped, (unsigned long)uiBindStats.frames,
+               (unsigned long)(uiBindStats.px / 1000));
+}